@@ -8,8 +8,8 @@
 #include <stdint.h>
 #include <string.h>
 
+#include <bitset>
 #include <limits>
-#include <unordered_set>  // for unordered_set::erase(), insert()
 
 #include <ffi.h>
 #include <girepository.h>
@@ -547,7 +547,7 @@ static bool gjs_marshal_foreign_in_in(JSContext* cx, GjsArgumentCache* self,
 }
 
 GJS_JSAPI_RETURN_CONVENTION
-static bool gjs_marshal_gvalue_in_in(JSContext* cx, GjsArgumentCache*,
+static bool gjs_marshal_gvalue_in_in(JSContext* cx, GjsArgumentCache* self,
                                      GjsFunctionCallState* state,
                                      GIArgument* arg, JS::HandleValue value) {
     if (value.isObject()) {
@@ -559,7 +559,7 @@ static bool gjs_marshal_gvalue_in_in(JSContext* cx, GjsArgumentCache*,
 
         if (gtype == G_TYPE_VALUE) {
             gjs_arg_set(arg, BoxedBase::to_c_ptr<GValue>(cx, obj));
-            state->ignore_release.insert(arg);
+            state->ignore_release.set(self->arg_pos);
             return true;
         }
     }
@@ -812,6 +812,64 @@ static bool gjs_marshal_explicit_array_out_out(JSContext* cx,
                                          length);
 }
 
+GJS_JSAPI_RETURN_CONVENTION
+static bool gjs_marshal_typed_array_out_out(JSContext* cx,
+                                            GjsArgumentCache* self,
+                                            GjsFunctionCallState* state,
+                                            GIArgument* arg,
+                                            JS::MutableHandleValue value) {
+    uint8_t length_pos = self->contents.array.length_pos;
+    GIArgument* length_arg = &(state->out_cvalues[length_pos]);
+    GITypeTag length_tag = self->contents.array.length_tag;
+    size_t length = gjs_g_argument_get_array_length(length_tag, length_arg);
+
+    // Numeric elements need no freeing, so for both container and full
+    // transfer the buffer can be handed over to the ArrayBuffer
+    bool take_ownership = self->transfer != GI_TRANSFER_NOTHING;
+    if (!gjs_typed_array_from_carray(cx, value, self->contents.array.element_tag,
+                                     length, gjs_arg_get<void*>(arg),
+                                     take_ownership))
+        return false;
+
+    // The release marshaller must not free it anymore
+    if (take_ownership)
+        gjs_arg_unset<void*>(arg);
+    return true;
+}
+
+GJS_JSAPI_RETURN_CONVENTION
+static bool gjs_marshal_typed_garray_out_out(JSContext* cx,
+                                             GjsArgumentCache* self,
+                                             GjsFunctionCallState*,
+                                             GIArgument* arg,
+                                             JS::MutableHandleValue value) {
+    auto* garray = gjs_arg_get<GArray*>(arg);
+    if (!garray) {
+        value.setNull();
+        return true;
+    }
+
+    // GLib 2.58 can't steal the data from a GArray, so always copy
+    return gjs_typed_array_from_carray(cx, value,
+                                       self->contents.array.element_tag,
+                                       garray->len, garray->data, false);
+}
+
+GJS_JSAPI_RETURN_CONVENTION
+static bool gjs_marshal_static_string_out_out(JSContext* cx,
+                                              GjsArgumentCache*,
+                                              GjsFunctionCallState*,
+                                              GIArgument* arg,
+                                              JS::MutableHandleValue value) {
+    const char* str = gjs_arg_get<const char*>(arg);
+    if (!str) {
+        value.setNull();
+        return true;
+    }
+
+    return gjs_string_from_static_utf8(cx, str, value);
+}
+
 GJS_JSAPI_RETURN_CONVENTION
 static bool gjs_marshal_skipped_release(JSContext*, GjsArgumentCache*,
                                         GjsFunctionCallState*,
@@ -990,7 +1048,7 @@ static bool gjs_marshal_gvalue_in_maybe_release(JSContext* cx,
                                                 GjsFunctionCallState* state,
                                                 GIArgument* in_arg,
                                                 GIArgument* out_arg) {
-    if (state->ignore_release.erase(in_arg))
+    if (state->ignore_release.test(self->arg_pos))
         return true;
 
     return gjs_marshal_boxed_in_release(cx, self, state, in_arg, out_arg);
@@ -1241,17 +1299,93 @@ static const GjsArgumentMarshallers c_array_out_marshallers = {
     gjs_marshal_explicit_array_out_release,  // release
 };
 
+static const GjsArgumentMarshallers typed_array_out_marshallers = {
+    gjs_marshal_generic_out_in,  // in
+    gjs_marshal_typed_array_out_out,  // out
+    gjs_marshal_explicit_array_out_release,  // release
+};
+
+static const GjsArgumentMarshallers typed_garray_out_marshallers = {
+    gjs_marshal_generic_out_in,  // in
+    gjs_marshal_typed_garray_out_out,  // out
+    gjs_marshal_generic_out_release,  // release
+};
+
 static const GjsArgumentMarshallers caller_allocates_out_marshallers = {
     gjs_marshal_caller_allocates_in,  // in
     gjs_marshal_generic_out_out,  // out
     gjs_marshal_caller_allocates_release,  // release
 };
 
+static const GjsArgumentMarshallers static_string_out_marshallers = {
+    nullptr,  // no in
+    gjs_marshal_static_string_out_out,  // out
+    gjs_marshal_skipped_release,  // release
+};
+
 static inline void gjs_arg_cache_set_skip_all(GjsArgumentCache* self) {
     self->marshallers = &skip_all_marshallers;
     self->flags = (GjsArgumentFlags::SKIP_IN | GjsArgumentFlags::SKIP_OUT);
 }
 
+// Returning numeric arrays as TypedArrays is opt-in, because it changes the
+// type of the value seen in JS. Annotate the argument or return value with
+// (attributes gjs.typed-array=1) to opt in.
+static constexpr const char* TYPED_ARRAY_ATTRIBUTE = "gjs.typed-array";
+
+[[nodiscard]] static bool gjs_arg_cache_use_typed_array(
+    GjsArgumentCache* self, const char* attribute_value) {
+    if (!attribute_value || strcmp(attribute_value, "0") == 0 ||
+        strcmp(attribute_value, "false") == 0)
+        return false;
+
+    GjsAutoTypeInfo element_type =
+        g_type_info_get_param_type(&self->type_info, 0);
+    if (g_type_info_is_pointer(element_type))
+        return false;
+
+    GITypeTag element_tag = g_type_info_get_tag(element_type);
+    if (!gjs_typed_array_supports_element_type(element_tag))
+        return false;
+
+    self->contents.array.element_tag = element_tag;
+    return true;
+}
+
+// Strings returned (transfer none) from these functions are never freed, so
+// they can be converted once and cached by address. Other functions can opt in
+// by annotating their return value with (attributes gjs.static-string=1).
+static constexpr const char* STATIC_STRING_ATTRIBUTE = "gjs.static-string";
+static constexpr const char* static_string_functions[] = {
+    "g_intern_static_string", "g_intern_string",
+    "g_param_spec_get_name",  "g_quark_to_string",
+    "g_signal_name",          "g_type_name",
+    "g_type_name_from_class", "g_type_name_from_instance",
+};
+
+[[nodiscard]] static bool gjs_arg_cache_returns_static_string(
+    GjsArgumentCache* self, GICallableInfo* callable) {
+    if (self->transfer != GI_TRANSFER_NOTHING ||
+        g_type_info_get_tag(&self->type_info) != GI_TYPE_TAG_UTF8)
+        return false;
+
+    const char* attribute_value =
+        g_callable_info_get_return_attribute(callable, STATIC_STRING_ATTRIBUTE);
+    if (attribute_value)
+        return strcmp(attribute_value, "0") != 0 &&
+               strcmp(attribute_value, "false") != 0;
+
+    if (!GI_IS_FUNCTION_INFO(callable))
+        return false;
+
+    const char* symbol = g_function_info_get_symbol(callable);
+    for (const char* static_function : static_string_functions) {
+        if (strcmp(symbol, static_function) == 0)
+            return true;
+    }
+    return false;
+}
+
 bool gjs_arg_cache_build_return(JSContext*, GjsArgumentCache* self,
                                 GjsArgumentCache* arguments,
                                 GICallableInfo* callable,
@@ -1281,6 +1415,10 @@ bool gjs_arg_cache_build_return(JSContext*, GjsArgumentCache* self,
             arguments[length_pos].marshallers = &array_length_out_marshallers;
 
             self->marshallers = &return_array_marshallers;
+            if (gjs_arg_cache_use_typed_array(
+                    self, g_callable_info_get_return_attribute(
+                              callable, TYPED_ARRAY_ATTRIBUTE)))
+                self->marshallers = &typed_array_out_marshallers;
 
             self->set_array_length_pos(length_pos);
 
@@ -1299,6 +1437,16 @@ bool gjs_arg_cache_build_return(JSContext*, GjsArgumentCache* self,
     self->flags = (self->flags | GjsArgumentFlags::SKIP_IN);
     self->marshallers = &return_value_marshallers;
 
+    if (gjs_arg_cache_returns_static_string(self, callable))
+        self->marshallers = &static_string_out_marshallers;
+
+    if (g_type_info_get_tag(&self->type_info) == GI_TYPE_TAG_ARRAY &&
+        g_type_info_get_array_type(&self->type_info) == GI_ARRAY_TYPE_ARRAY &&
+        gjs_arg_cache_use_typed_array(
+            self, g_callable_info_get_return_attribute(callable,
+                                                       TYPED_ARRAY_ATTRIBUTE)))
+        self->marshallers = &typed_garray_out_marshallers;
+
     return true;
 }
 
@@ -1749,6 +1897,10 @@ bool gjs_arg_cache_build_arg(JSContext* cx, GjsArgumentCache* self,
                     &array_length_out_marshallers;
 
                 self->marshallers = &c_array_out_marshallers;
+                if (gjs_arg_cache_use_typed_array(
+                        self,
+                        g_base_info_get_attribute(arg, TYPED_ARRAY_ATTRIBUTE)))
+                    self->marshallers = &typed_array_out_marshallers;
             }
 
             self->set_array_length_pos(length_pos);
@@ -1771,10 +1923,18 @@ bool gjs_arg_cache_build_arg(JSContext* cx, GjsArgumentCache* self,
     if (direction == GI_DIRECTION_IN)
         return gjs_arg_cache_build_normal_in_arg(cx, self, callable, type_tag);
 
-    if (direction == GI_DIRECTION_INOUT)
+    if (direction == GI_DIRECTION_INOUT) {
         self->marshallers = &fallback_inout_marshallers;
-    else
+    } else if (type_tag == GI_TYPE_TAG_ARRAY &&
+               g_type_info_get_array_type(&self->type_info) ==
+                   GI_ARRAY_TYPE_ARRAY &&
+               gjs_arg_cache_use_typed_array(
+                   self,
+                   g_base_info_get_attribute(arg, TYPED_ARRAY_ATTRIBUTE))) {
+        self->marshallers = &typed_garray_out_marshallers;
+    } else {
         self->marshallers = &fallback_out_marshallers;
+    }
 
     return true;
 }
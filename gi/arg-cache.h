@@ -51,6 +51,8 @@ struct GjsArgumentCache {
         struct {
             uint8_t length_pos;
             GITypeTag length_tag : 5;
+            // only for arrays marshalled to TypedArrays
+            GITypeTag element_tag : 5;
         } array;
 
         struct {
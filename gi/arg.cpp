@@ -8,14 +8,17 @@
 #include <string.h>  // for strcmp, strlen, memcpy
 
 #include <string>
+#include <type_traits>  // for is_same_v
 
 #include <girepository.h>
 #include <glib-object.h>
 #include <glib.h>
 
 #include <js/Array.h>
+#include <js/ArrayBuffer.h>  // for NewArrayBufferWithContents, NewExternal...
 #include <js/CharacterEncoding.h>
 #include <js/Conversions.h>
+#include <js/GCAPI.h>  // for AutoCheckCannotGC
 #include <js/GCVector.h>            // for RootedVector, MutableWrappedPtrOp...
 #include <js/PropertyDescriptor.h>  // for JSPROP_ENUMERATE
 #include <js/RootingAPI.h>
@@ -604,6 +607,35 @@ GJS_JSAPI_RETURN_CONVENTION static bool js_value_to_c_strict(
     return ret;
 }
 
+// Whether the contents of a typed array of type @array_type have exactly the
+// same representation as a C array of T, and converting them element by
+// element with js_value_to_c_strict() would give the same result. 64-bit
+// typed arrays hold BigInts, which the element-wise path does not accept.
+template <typename T, GITypeTag TAG>
+[[nodiscard]] static bool typed_array_matches(js::Scalar::Type array_type) {
+    if constexpr (TAG != GI_TYPE_TAG_VOID)
+        return false;
+    else if constexpr (std::is_same_v<T, int8_t>)
+        return array_type == js::Scalar::Int8;
+    else if constexpr (std::is_same_v<T, uint8_t>)
+        return array_type == js::Scalar::Uint8 ||
+               array_type == js::Scalar::Uint8Clamped;
+    else if constexpr (std::is_same_v<T, int16_t>)
+        return array_type == js::Scalar::Int16;
+    else if constexpr (std::is_same_v<T, uint16_t>)
+        return array_type == js::Scalar::Uint16;
+    else if constexpr (std::is_same_v<T, int32_t>)
+        return array_type == js::Scalar::Int32;
+    else if constexpr (std::is_same_v<T, uint32_t>)
+        return array_type == js::Scalar::Uint32;
+    else if constexpr (std::is_same_v<T, float>)
+        return array_type == js::Scalar::Float32;
+    else if constexpr (std::is_same_v<T, double>)
+        return array_type == js::Scalar::Float64;
+    else
+        return false;
+}
+
 template <typename T, GITypeTag TAG = GI_TYPE_TAG_VOID>
 GJS_JSAPI_RETURN_CONVENTION static bool gjs_array_to_auto_array(
     JSContext* cx, JS::Value array_value, size_t length, void** arr_p) {
@@ -613,6 +645,19 @@ GJS_JSAPI_RETURN_CONVENTION static bool gjs_array_to_auto_array(
     // Add one so we're always zero terminated
     GjsSmartPointer<T> result = array_allocate<T>(length + 1);
 
+    // Fast path: a typed array with the same element type can be copied in
+    // one go, instead of getting and converting each element separately
+    if (array && JS_IsTypedArrayObject(array) &&
+        typed_array_matches<T, TAG>(JS_GetArrayBufferViewType(array)) &&
+        JS_GetTypedArrayLength(array) >= length) {
+        bool unused;
+        JS::AutoCheckCannotGC nogc;
+        memcpy(result.get(), JS_GetArrayBufferViewData(array, &unused, nogc),
+               length * sizeof(T));
+        *arr_p = result.release();
+        return true;
+    }
+
     for (size_t i = 0; i < length; ++i) {
         elem = JS::UndefinedValue();
 
@@ -691,7 +736,7 @@ gjs_string_to_intarray(JSContext       *context,
     switch (element_type) {
         case GI_TYPE_TAG_INT8:
         case GI_TYPE_TAG_UINT8: {
-            JS::UniqueChars result(JS_EncodeStringToUTF8(context, str));
+            JS::UniqueChars result = gjs_string_to_utf8(context, str);
             if (!result)
                 return false;
             *length = strlen(result.get());
@@ -1121,6 +1166,15 @@ bool gjs_array_to_explicit_array(JSContext* context, JS::HandleValue value,
                                            element_type == GI_TYPE_TAG_UINT8)) {
             GBytes* bytes = gjs_byte_array_get_bytes(array_obj);
             *contents = g_bytes_unref_to_data(bytes, length_p);
+        } else if (JS_IsTypedArrayObject(array_obj)) {
+            // The length of a typed array can't be overridden, so there is no
+            // need to look it up as a property
+            uint32_t length = JS_GetTypedArrayLength(array_obj);
+            if (!gjs_array_to_array(context, value, length, transfer,
+                                    param_info, contents))
+                return false;
+
+            *length_p = length;
         } else if (JS_HasPropertyById(context, array_obj, atoms.length(),
                                       &found_length) &&
                    found_length) {
@@ -1415,9 +1469,9 @@ static bool value_to_interface_gi_argument(
 }
 
 template <typename T>
-GJS_JSAPI_RETURN_CONVENTION inline static bool gjs_arg_set_from_js_value(
-    JSContext* cx, const JS::HandleValue& value, GArgument* arg,
-    const char* arg_name, GjsArgumentType arg_type) {
+bool gjs_arg_set_from_js_value(JSContext* cx, const JS::HandleValue& value,
+                               GArgument* arg, const char* arg_name,
+                               GjsArgumentType arg_type) {
     bool out_of_range = false;
 
     if (!gjs_arg_set_from_js_value<T>(cx, value, arg, &out_of_range)) {
@@ -1441,6 +1495,48 @@ GJS_JSAPI_RETURN_CONVENTION inline static bool gjs_arg_set_from_js_value(
     return true;
 }
 
+// Also used for the return values of callbacks, in function.cpp
+template bool gjs_arg_set_from_js_value<int8_t>(JSContext*,
+                                                const JS::HandleValue&,
+                                                GArgument*, const char*,
+                                                GjsArgumentType);
+template bool gjs_arg_set_from_js_value<uint8_t>(JSContext*,
+                                                 const JS::HandleValue&,
+                                                 GArgument*, const char*,
+                                                 GjsArgumentType);
+template bool gjs_arg_set_from_js_value<int16_t>(JSContext*,
+                                                 const JS::HandleValue&,
+                                                 GArgument*, const char*,
+                                                 GjsArgumentType);
+template bool gjs_arg_set_from_js_value<uint16_t>(JSContext*,
+                                                  const JS::HandleValue&,
+                                                  GArgument*, const char*,
+                                                  GjsArgumentType);
+template bool gjs_arg_set_from_js_value<int32_t>(JSContext*,
+                                                 const JS::HandleValue&,
+                                                 GArgument*, const char*,
+                                                 GjsArgumentType);
+template bool gjs_arg_set_from_js_value<uint32_t>(JSContext*,
+                                                  const JS::HandleValue&,
+                                                  GArgument*, const char*,
+                                                  GjsArgumentType);
+template bool gjs_arg_set_from_js_value<int64_t>(JSContext*,
+                                                 const JS::HandleValue&,
+                                                 GArgument*, const char*,
+                                                 GjsArgumentType);
+template bool gjs_arg_set_from_js_value<uint64_t>(JSContext*,
+                                                  const JS::HandleValue&,
+                                                  GArgument*, const char*,
+                                                  GjsArgumentType);
+template bool gjs_arg_set_from_js_value<float>(JSContext*,
+                                               const JS::HandleValue&,
+                                               GArgument*, const char*,
+                                               GjsArgumentType);
+template bool gjs_arg_set_from_js_value<double>(JSContext*,
+                                                const JS::HandleValue&,
+                                                GArgument*, const char*,
+                                                GjsArgumentType);
+
 static bool check_nullable_argument(JSContext* cx, const char* arg_name,
                                     GjsArgumentType arg_type,
                                     GITypeTag type_tag, GjsArgumentFlags flags,
@@ -1568,7 +1664,7 @@ bool gjs_value_to_g_argument(JSContext* context, JS::HandleValue value,
             gjs_arg_set(arg, nullptr);
         } else if (value.isString()) {
             JS::RootedString str(context, value.toString());
-            JS::UniqueChars utf8_str(JS_EncodeStringToUTF8(context, str));
+            JS::UniqueChars utf8_str = gjs_string_to_utf8(context, str);
             if (!utf8_str)
                 return false;
 
@@ -2086,6 +2182,93 @@ gjs_array_from_carray_internal (JSContext             *context,
     return true;
 }
 
+using TypedArrayConstructor = JSObject* (*)(JSContext*, JS::HandleObject,
+                                             uint32_t, int32_t);
+
+[[nodiscard]] static TypedArrayConstructor typed_array_constructor_for_tag(
+    GITypeTag element_type, size_t* element_size) {
+    switch (element_type) {
+        case GI_TYPE_TAG_INT8:
+            *element_size = sizeof(int8_t);
+            return JS_NewInt8ArrayWithBuffer;
+        case GI_TYPE_TAG_INT16:
+            *element_size = sizeof(int16_t);
+            return JS_NewInt16ArrayWithBuffer;
+        case GI_TYPE_TAG_UINT16:
+            *element_size = sizeof(uint16_t);
+            return JS_NewUint16ArrayWithBuffer;
+        case GI_TYPE_TAG_INT32:
+            *element_size = sizeof(int32_t);
+            return JS_NewInt32ArrayWithBuffer;
+        case GI_TYPE_TAG_UINT32:
+            *element_size = sizeof(uint32_t);
+            return JS_NewUint32ArrayWithBuffer;
+        case GI_TYPE_TAG_FLOAT:
+            *element_size = sizeof(float);
+            return JS_NewFloat32ArrayWithBuffer;
+        case GI_TYPE_TAG_DOUBLE:
+            *element_size = sizeof(double);
+            return JS_NewFloat64ArrayWithBuffer;
+        default:
+            // 64-bit integers are Numbers in GJS, not BigInts, and guint8
+            // arrays already become Uint8Arrays
+            return nullptr;
+    }
+}
+
+bool gjs_typed_array_supports_element_type(GITypeTag element_type) {
+    size_t element_size;
+    return !!typed_array_constructor_for_tag(element_type, &element_size);
+}
+
+static void gfree_arraybuffer_contents(void* contents, void*) {
+    g_free(contents);
+}
+
+/*
+ * gjs_typed_array_from_carray:
+ * @take_ownership: whether the array was allocated with g_malloc() and is
+ *   owned by the caller
+ *
+ * Converts a C array of numbers into the TypedArray with the matching element
+ * type, without converting each element. If @take_ownership is true, then the
+ * resulting ArrayBuffer adopts @array and frees it when it's garbage collected;
+ * otherwise @array is copied with one memcpy.
+ */
+bool gjs_typed_array_from_carray(JSContext* cx, JS::MutableHandleValue value_p,
+                                 GITypeTag element_type, size_t length,
+                                 void* array, bool take_ownership) {
+    size_t element_size;
+    TypedArrayConstructor new_typed_array =
+        typed_array_constructor_for_tag(element_type, &element_size);
+    g_assert(new_typed_array &&
+             "Check gjs_typed_array_supports_element_type() first");
+
+    JS::RootedObject array_buffer(cx);
+    size_t nbytes = length * element_size;
+    // a null array pointer takes precedence over whatever `length` says
+    if (!array) {
+        array_buffer = JS::NewArrayBuffer(cx, 0);
+    } else if (take_ownership) {
+        array_buffer = JS::NewExternalArrayBuffer(
+            cx, nbytes, array, gfree_arraybuffer_contents, nullptr);
+    } else {
+        void* contents = g_memdup(array, nbytes);
+        array_buffer = JS::NewArrayBufferWithContents(cx, nbytes, contents);
+        if (!array_buffer)
+            g_free(contents);
+    }
+    if (!array_buffer)
+        return false;
+
+    JSObject* typed_array = new_typed_array(cx, array_buffer, 0, -1);
+    if (!typed_array)
+        return false;
+
+    value_p.setObject(*typed_array);
+    return true;
+}
+
 GJS_JSAPI_RETURN_CONVENTION
 static bool
 gjs_array_from_fixed_size_array (JSContext             *context,
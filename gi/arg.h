@@ -43,6 +43,13 @@ enum class GjsArgumentFlags : uint8_t {
 [[nodiscard]] char* gjs_argument_display_name(const char* arg_name,
                                               GjsArgumentType arg_type);
 
+// Converts @value to the number type T and stores it in @arg, throwing if it
+// is out of range; instantiated for the integer and floating point types
+template <typename T>
+GJS_JSAPI_RETURN_CONVENTION bool gjs_arg_set_from_js_value(
+    JSContext* cx, const JS::HandleValue& value, GArgument* arg,
+    const char* arg_name, GjsArgumentType arg_type);
+
 GJS_JSAPI_RETURN_CONVENTION
 bool gjs_value_to_arg(JSContext      *context,
                       JS::HandleValue value,
@@ -88,6 +95,13 @@ bool gjs_value_from_explicit_array(JSContext             *context,
                                    GIArgument            *arg,
                                    int                    length);
 
+[[nodiscard]] bool gjs_typed_array_supports_element_type(GITypeTag element_type);
+
+GJS_JSAPI_RETURN_CONVENTION
+bool gjs_typed_array_from_carray(JSContext* cx, JS::MutableHandleValue value_p,
+                                 GITypeTag element_type, size_t length,
+                                 void* array, bool take_ownership);
+
 GJS_JSAPI_RETURN_CONVENTION
 bool gjs_g_argument_release    (JSContext  *context,
                                 GITransfer  transfer,
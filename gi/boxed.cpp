@@ -8,6 +8,7 @@
 #include <string.h>  // for memcpy, size_t, strcmp
 
 #include <string>
+#include <unordered_set>
 #include <utility>  // for move, forward
 
 #include <girepository.h>
@@ -17,6 +18,7 @@
 #include <js/Class.h>
 #include <js/GCHashTable.h>  // for GCHashMap
 #include <js/GCVector.h>     // for MutableWrappedPtrOperations
+#include <js/MemoryFunctions.h>  // for AddAssociatedMemory, RemoveAssoci...
 #include <js/TracingAPI.h>
 #include <js/TypeDecls.h>
 #include <js/Utility.h>  // for UniqueChars
@@ -41,8 +43,10 @@
 BoxedInstance::BoxedInstance(JSContext* cx, JS::HandleObject obj)
     : GIWrapperInstance(cx, obj),
       m_allocated_directly(false),
-      m_owning_ptr(false) {
+      m_owning_ptr(false),
+      m_associated_bytes(0) {
     GJS_INC_COUNTER(boxed_instance);
+    GJS_ADD_BYTES(boxed_instance, sizeof(BoxedInstance));
 }
 
 [[nodiscard]] static bool struct_is_simple(GIStructInfo* info);
@@ -316,9 +320,11 @@ bool BoxedInstance::constructor_impl(JSContext* context, JS::HandleObject obj,
 
         if (g_type_is_a(gtype(), G_TYPE_BOXED)) {
             copy_boxed(source_priv->to_instance());
+            associate_memory(obj);
             return true;
         } else if (get_prototype()->can_allocate_directly()) {
             copy_memory(source_priv->to_instance());
+            associate_memory(obj);
             return true;
         }
     }
@@ -400,6 +406,8 @@ bool BoxedInstance::constructor_impl(JSContext* context, JS::HandleObject obj,
         return false;
     }
 
+    associate_memory(obj);
+
     /* If we reach this code, we need to init from a map of fields */
 
     if (args.length() == 0)
@@ -432,12 +440,92 @@ BoxedInstance::~BoxedInstance() {
     }
 
     GJS_DEC_COUNTER(boxed_instance);
+    GJS_SUB_BYTES(boxed_instance, sizeof(BoxedInstance));
+}
+
+/*
+ * BoxedInstance::associate_memory:
+ *
+ * Reports the C memory owned by this instance, if any, to SpiderMonkey as
+ * belonging to @obj, so that the GC knows how much memory it would free by
+ * collecting @obj. Call this once the C memory is allocated.
+ */
+void BoxedInstance::associate_memory(JSObject* obj) {
+    if (!m_owning_ptr || m_associated_bytes || gtype() == G_TYPE_VARIANT)
+        return;
+
+    m_associated_bytes = g_struct_info_get_size(info());
+    if (m_associated_bytes == 0)
+        return;
+
+    JS::AddAssociatedMemory(obj, m_associated_bytes,
+                            MemoryUse::BoxedInstanceStruct);
+    GJS_ADD_BYTES(boxed_instance, m_associated_bytes);
 }
 
+void BoxedInstance::finalize_impl(JSFreeOp* fop, JSObject* obj) {
+    if (m_associated_bytes) {
+        JS::RemoveAssociatedMemory(obj, m_associated_bytes,
+                                   MemoryUse::BoxedInstanceStruct);
+        GJS_SUB_BYTES(boxed_instance, m_associated_bytes);
+    }
+
+    GIWrapperInstance::finalize_impl(fop, obj);
+}
+
+// BoxedPrototypes aren't attached to their GType, since many boxed types don't
+// have one, so keep track of them here in order to be able to release their
+// caches
+static std::unordered_set<BoxedPrototype*> all_boxed_prototypes;
+
 BoxedPrototype::~BoxedPrototype(void) {
+    all_boxed_prototypes.erase(this);
     GJS_DEC_COUNTER(boxed_prototype);
 }
 
+/*
+ * BoxedPrototype::release_field_map:
+ *
+ * Frees the field cache, which is created again when it is next needed.
+ * Returns the number of entries that were dropped.
+ */
+size_t BoxedPrototype::release_field_map(void) {
+    if (!m_field_map)
+        return 0;
+    size_t released = m_field_map->count();
+    m_field_map.reset();
+    return released;
+}
+
+/*
+ * BoxedPrototype::all_field_maps_size:
+ *
+ * Returns the approximate number of bytes used by the field maps of all
+ * BoxedPrototypes.
+ */
+size_t BoxedPrototype::all_field_maps_size(void) {
+    size_t size = 0;
+    for (BoxedPrototype* priv : all_boxed_prototypes) {
+        if (priv->m_field_map)
+            size += priv->m_field_map->capacity() *
+                    (sizeof(FieldMap::Entry) + sizeof(js::HashNumber));
+    }
+    return size;
+}
+
+/*
+ * BoxedPrototype::release_all_field_maps:
+ *
+ * Calls release_field_map() on every BoxedPrototype, for example when the
+ * system is low on memory.
+ */
+size_t BoxedPrototype::release_all_field_maps(void) {
+    size_t released = 0;
+    for (BoxedPrototype* priv : all_boxed_prototypes)
+        released += priv->release_field_map();
+    return released;
+}
+
 /*
  * BoxedBase::get_field_info:
  *
@@ -866,6 +954,7 @@ BoxedPrototype::BoxedPrototype(GIStructInfo* info, GType gtype)
       m_default_constructor(-1),
       m_default_constructor_name(JSID_VOID),
       m_can_allocate_directly(struct_is_simple(info)) {
+    all_boxed_prototypes.insert(this);
     GJS_INC_COUNTER(boxed_prototype);
 }
 
@@ -980,6 +1069,7 @@ JSObject* BoxedInstance::new_for_c_struct_impl(JSContext* cx,
 
     if (!priv->init_from_c_struct(cx, gboxed, std::forward<Args>(args)...))
         return nullptr;
+    priv->associate_memory(obj);
 
     if (priv->gtype() == G_TYPE_ERROR && !gjs_define_error_properties(cx, obj))
         return nullptr;
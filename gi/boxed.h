@@ -7,6 +7,7 @@
 
 #include <config.h>
 
+#include <stddef.h>  // for size_t
 #include <stdint.h>
 
 #include <memory>  // for unique_ptr
@@ -117,6 +118,10 @@ class BoxedPrototype : public GIWrapperPrototype<BoxedBase, BoxedPrototype,
             m_default_constructor_name.address());
     }
 
+    size_t release_field_map(void);
+    static size_t release_all_field_maps(void);
+    [[nodiscard]] static size_t all_field_maps_size(void);
+
     // JSClass operations
 
  private:
@@ -157,10 +162,14 @@ class BoxedInstance
     bool m_allocated_directly : 1;
     bool m_owning_ptr : 1;  // if set, the JS wrapper owns the C memory referred
                             // to by m_ptr.
+    // Size of the owned C memory, as reported to SpiderMonkey
+    uint32_t m_associated_bytes;
 
     explicit BoxedInstance(JSContext* cx, JS::HandleObject obj);
     ~BoxedInstance(void);
 
+    void associate_memory(JSObject* obj);
+
     // Don't set GIWrapperBase::m_ptr directly. Instead, use one of these
     // setters to express your intention to own the pointer or not.
     void own_ptr(void* boxed_ptr) {
@@ -215,9 +224,19 @@ class BoxedInstance
     bool constructor_impl(JSContext* cx, JS::HandleObject obj,
                           const JS::CallArgs& args);
 
-    // Public API for initializing BoxedInstance JS object from C struct
+    // JSClass operations
+
+    void finalize_impl(JSFreeOp* fop, JSObject* obj);
+
+    // C memory owned by this wrapper, in bytes; used in heap snapshots
 
  public:
+    [[nodiscard]] size_t native_size(void) const {
+        return sizeof(BoxedInstance) + m_associated_bytes;
+    }
+
+    // Public API for initializing BoxedInstance JS object from C struct
+
     struct NoCopy {};
 
  private:
@@ -120,6 +120,7 @@ static void closure_invalidated(void*, GClosure* closure) {
     c = &((GjsClosure*) closure)->priv;
 
     GJS_DEC_COUNTER(closure);
+    GJS_SUB_BYTES(closure, sizeof(GjsClosure));
     gjs_debug_closure("Invalidating closure %p which calls function %p",
                       closure, c->func.debug_addr());
 
@@ -155,6 +156,7 @@ static void closure_set_invalid(void*, GClosure* closure) {
     self->context = nullptr;
 
     GJS_DEC_COUNTER(closure);
+    GJS_SUB_BYTES(closure, sizeof(GjsClosure));
 }
 
 static void closure_finalize(void*, GClosure* closure) {
@@ -282,6 +284,7 @@ GClosure* gjs_closure_new(JSContext* context, JSFunction* callable,
     c->context = context;
 
     GJS_INC_COUNTER(closure);
+    GJS_ADD_BYTES(closure, sizeof(GjsClosure));
 
     if (root_function) {
         /* Fully manage closure lifetime if so asked */
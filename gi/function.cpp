@@ -8,7 +8,6 @@
 #include <stdlib.h>  // for exit
 #include <string.h>  // for memset
 
-#include <memory>  // for unique_ptr
 #include <string>
 #include <type_traits>
 #include <vector>
@@ -22,7 +21,9 @@
 #include <js/Array.h>
 #include <js/CallArgs.h>
 #include <js/Class.h>
+#include <js/Conversions.h>  // for ToBoolean
 #include <js/GCVector.h>
+#include <js/MemoryFunctions.h>     // for AddAssociatedMemory, RemoveAssoci...
 #include <js/PropertyDescriptor.h>  // for JSPROP_PERMANENT
 #include <js/PropertySpec.h>
 #include <js/Realm.h>  // for GetRealmFunctionPrototype
@@ -41,6 +42,7 @@
 #include "gi/gerror.h"
 #include "gi/object.h"
 #include "gi/utils-inl.h"
+#include "gi/wrapperutils.h"
 #include "gjs/context-private.h"
 #include "gjs/context.h"
 #include "gjs/jsapi-class.h"
@@ -57,6 +59,9 @@ typedef struct {
     GICallableInfo* info;
 
     GjsArgumentCache* arguments;
+    // Size of the allocation that arguments points into, if it is reported to
+    // SpiderMonkey as associated with the function object
+    size_t arguments_bytes;
 
     uint8_t js_in_argc;
     guint8 js_out_argc;
@@ -106,13 +111,11 @@ static inline std::enable_if_t<std::is_pointer_v<T>> set_ffi_arg(
         gjs_pointer_to_int<ffi_arg>(gjs_arg_get<T, TAG>(value));
 }
 
-static void
-set_return_ffi_arg_from_giargument (GITypeInfo  *ret_type,
-                                    void        *result,
-                                    GIArgument  *return_value)
-{
+static void set_return_ffi_arg_from_giargument(GjsCallbackArgument* ret_type,
+                                               void* result,
+                                               GIArgument* return_value) {
     // Be consistent with gjs_value_to_g_argument()
-    switch (g_type_info_get_tag(ret_type)) {
+    switch (ret_type->tag) {
     case GI_TYPE_TAG_VOID:
         g_assert_not_reached();
     case GI_TYPE_TAG_INT8:
@@ -143,18 +146,11 @@ set_return_ffi_arg_from_giargument (GITypeInfo  *ret_type,
         set_ffi_arg<int64_t>(result, return_value);
         break;
     case GI_TYPE_TAG_INTERFACE:
-        {
-            GIInfoType interface_type;
-
-            GjsAutoBaseInfo interface_info(g_type_info_get_interface(ret_type));
-            interface_type = g_base_info_get_type(interface_info);
-
-            if (interface_type == GI_INFO_TYPE_ENUM ||
-                interface_type == GI_INFO_TYPE_FLAGS)
-                set_ffi_arg<int, GI_TYPE_TAG_INTERFACE>(result, return_value);
-            else
-                set_ffi_arg<void*>(result, return_value);
-        }
+        if (ret_type->interface_type == GI_INFO_TYPE_ENUM ||
+            ret_type->interface_type == GI_INFO_TYPE_FLAGS)
+            set_ffi_arg<int, GI_TYPE_TAG_INTERFACE>(result, return_value);
+        else
+            set_ffi_arg<void*>(result, return_value);
         break;
     case GI_TYPE_TAG_UINT64:
         // Other primitive types need to squeeze into 64-bit ffi_arg too
@@ -184,6 +180,75 @@ set_return_ffi_arg_from_giargument (GITypeInfo  *ret_type,
     }
 }
 
+// Out marshallers for values returned from JS callbacks. The common cases of
+// booleans and numbers (for example, the return value of a sort comparator)
+// have specialized marshallers, everything else goes through the generic one.
+
+GJS_JSAPI_RETURN_CONVENTION
+static bool gjs_callback_marshal_generic_out(JSContext* cx,
+                                             GjsCallbackArgument* self,
+                                             JS::HandleValue value,
+                                             GIArgument* arg) {
+    return gjs_value_to_g_argument(cx, value, &self->type_info, self->arg_name,
+                                   self->argument_type(), self->transfer,
+                                   self->flags, arg);
+}
+
+GJS_JSAPI_RETURN_CONVENTION
+static bool gjs_callback_marshal_boolean_out(JSContext*, GjsCallbackArgument*,
+                                             JS::HandleValue value,
+                                             GIArgument* arg) {
+    gjs_arg_set(arg, JS::ToBoolean(value));
+    return true;
+}
+
+template <typename T>
+GJS_JSAPI_RETURN_CONVENTION static bool gjs_callback_marshal_number_out(
+    JSContext* cx, GjsCallbackArgument* self, JS::HandleValue value,
+    GIArgument* arg) {
+    return gjs_arg_set_from_js_value<T>(cx, value, arg, self->arg_name,
+                                        self->argument_type());
+}
+
+[[nodiscard]] static GjsCallbackOutMarshaller gjs_callback_out_marshaller(
+    GITypeTag tag) {
+    switch (tag) {
+        case GI_TYPE_TAG_BOOLEAN:
+            return gjs_callback_marshal_boolean_out;
+        case GI_TYPE_TAG_INT8:
+            return gjs_callback_marshal_number_out<int8_t>;
+        case GI_TYPE_TAG_UINT8:
+            return gjs_callback_marshal_number_out<uint8_t>;
+        case GI_TYPE_TAG_INT16:
+            return gjs_callback_marshal_number_out<int16_t>;
+        case GI_TYPE_TAG_UINT16:
+            return gjs_callback_marshal_number_out<uint16_t>;
+        case GI_TYPE_TAG_INT32:
+            return gjs_callback_marshal_number_out<int32_t>;
+        case GI_TYPE_TAG_UINT32:
+            return gjs_callback_marshal_number_out<uint32_t>;
+        case GI_TYPE_TAG_INT64:
+            return gjs_callback_marshal_number_out<int64_t>;
+        case GI_TYPE_TAG_UINT64:
+            return gjs_callback_marshal_number_out<uint64_t>;
+        case GI_TYPE_TAG_FLOAT:
+            return gjs_callback_marshal_number_out<float>;
+        case GI_TYPE_TAG_DOUBLE:
+            return gjs_callback_marshal_number_out<double>;
+        default:
+            return gjs_callback_marshal_generic_out;
+    }
+}
+
+[[nodiscard]] static GIInfoType gjs_callback_interface_type(
+    GITypeInfo* type_info) {
+    if (g_type_info_get_tag(type_info) != GI_TYPE_TAG_INTERFACE)
+        return GI_INFO_TYPE_INVALID;
+
+    GjsAutoBaseInfo interface_info = g_type_info_get_interface(type_info);
+    return interface_info.type();
+}
+
 void GjsCallbackTrampoline::warn_about_illegal_js_callback(const char* when,
                                                            const char* reason) {
     g_critical("Attempting to run a JS callback %s. This is most likely caused "
@@ -203,7 +268,6 @@ void GjsCallbackTrampoline::warn_about_illegal_js_callback(const char* when,
  */
 void GjsCallbackTrampoline::callback_closure(GIArgument** args, void* result) {
     JSContext *context;
-    GITypeInfo ret_type;
 
     if (G_UNLIKELY(!gjs_closure_is_valid(m_js_function))) {
         warn_about_illegal_js_callback(
@@ -234,7 +298,7 @@ void GjsCallbackTrampoline::callback_closure(GIArgument** args, void* result) {
     JSAutoRealm ar(
         context, JS_GetFunctionObject(gjs_closure_get_callable(m_js_function)));
 
-    int n_args = m_param_types.size();
+    int n_args = m_args.size();
     g_assert(n_args >= 0);
 
     struct AutoCallbackData {
@@ -274,14 +338,13 @@ void GjsCallbackTrampoline::callback_closure(GIArgument** args, void* result) {
 
     JS::RootedValue rval(context);
 
-    g_callable_info_load_return_type(m_info, &ret_type);
     GIArgument* error_argument = nullptr;
 
-    if (g_callable_info_can_throw_gerror(m_info))
+    if (m_can_throw_gerror)
         error_argument = args[n_args + c_args_offset];
 
-    if (!callback_closure_inner(context, this_object, &rval, args, &ret_type,
-                                n_args, c_args_offset, result)) {
+    if (!callback_closure_inner(context, this_object, &rval, args,
+                                c_args_offset, result)) {
         if (!JS_IsExceptionPending(context)) {
             // "Uncatchable" exception thrown, we have to exit. We may be in a
             // main loop, or maybe not, but there's no way to tell, so we have
@@ -299,11 +362,11 @@ void GjsCallbackTrampoline::callback_closure(GIArgument** args, void* result) {
         }
 
         // Fill in the result with some hopefully neutral value
-        if (g_type_info_get_tag(&ret_type) != GI_TYPE_TAG_VOID) {
+        if (m_return_value.tag != GI_TYPE_TAG_VOID) {
             GIArgument argument = {};
-            g_callable_info_load_return_type(m_info, &ret_type);
-            gjs_gi_argument_init_default(&ret_type, &argument);
-            set_return_ffi_arg_from_giargument(&ret_type, result, &argument);
+            gjs_gi_argument_init_default(&m_return_value.type_info, &argument);
+            set_return_ffi_arg_from_giargument(&m_return_value, result,
+                                               &argument);
         }
 
         // If the callback has a GError** argument and invoking the closure
@@ -327,9 +390,9 @@ void GjsCallbackTrampoline::callback_closure(GIArgument** args, void* result) {
     }
 }
 
-inline GIArgument* get_argument_for_arg_info(GIArgInfo* arg_info,
-                                             GIArgument** args, int index) {
-    if (!g_arg_info_is_caller_allocates(arg_info))
+[[nodiscard]] static inline GIArgument* get_out_argument(
+    GjsCallbackArgument* arg, GIArgument** args, int index) {
+    if (!(arg->flags & GjsArgumentFlags::CALLER_ALLOCATES))
         return *reinterpret_cast<GIArgument**>(args[index]);
     else
         return args[index];
@@ -337,60 +400,43 @@ inline GIArgument* get_argument_for_arg_info(GIArgInfo* arg_info,
 
 bool GjsCallbackTrampoline::callback_closure_inner(
     JSContext* context, JS::HandleObject this_object,
-    JS::MutableHandleValue rval, GIArgument** args, GITypeInfo* ret_type,
-    int n_args, int c_args_offset, void* result) {
-    int n_outargs = 0;
+    JS::MutableHandleValue rval, GIArgument** args, int c_args_offset,
+    void* result) {
+    int n_args = m_args.size();
     JS::RootedValueVector jsargs(context);
 
     if (!jsargs.reserve(n_args))
         g_error("Unable to reserve space for vector");
 
-    bool ret_type_is_void = g_type_info_get_tag(ret_type) == GI_TYPE_TAG_VOID;
+    bool ret_type_is_void = m_return_value.tag == GI_TYPE_TAG_VOID;
 
     for (int i = 0, n_jsargs = 0; i < n_args; i++) {
-        GIArgInfo arg_info;
-        GITypeInfo type_info;
-        GjsParamType param_type;
-
-        g_callable_info_load_arg(m_info, i, &arg_info);
-        g_arg_info_load_type(&arg_info, &type_info);
+        GjsCallbackArgument* arg = &m_args[i];
 
         /* Skip void * arguments */
-        if (g_type_info_get_tag(&type_info) == GI_TYPE_TAG_VOID)
+        if (arg->tag == GI_TYPE_TAG_VOID)
             continue;
 
-        if (g_arg_info_get_direction(&arg_info) == GI_DIRECTION_OUT) {
-            n_outargs++;
+        if (arg->direction == GI_DIRECTION_OUT)
             continue;
-        }
-
-        if (g_arg_info_get_direction(&arg_info) == GI_DIRECTION_INOUT)
-            n_outargs++;
 
-        param_type = m_param_types[i];
-
-        switch (param_type) {
+        switch (arg->param_type) {
             case PARAM_SKIPPED:
                 continue;
             case PARAM_ARRAY: {
-                gint array_length_pos = g_type_info_get_array_length(&type_info);
-                GIArgInfo array_length_arg;
-                GITypeInfo arg_type_info;
+                uint8_t array_length_pos = arg->array_length_pos;
                 JS::RootedValue length(context);
 
-                g_callable_info_load_arg(m_info, array_length_pos,
-                                         &array_length_arg);
-                g_arg_info_load_type(&array_length_arg, &arg_type_info);
-                if (!gjs_value_from_g_argument(context, &length, &arg_type_info,
-                                               args[array_length_pos + c_args_offset],
-                                               true))
+                if (!gjs_value_from_g_argument(
+                        context, &length, &m_args[array_length_pos].type_info,
+                        args[array_length_pos + c_args_offset], true))
                     return false;
 
                 if (!jsargs.growBy(1))
                     g_error("Unable to grow vector");
 
                 if (!gjs_value_from_explicit_array(context, jsargs[n_jsargs++],
-                                                   &type_info,
+                                                   &arg->type_info,
                                                    args[i + c_args_offset],
                                                    length.toInt32()))
                     return false;
@@ -400,13 +446,12 @@ bool GjsCallbackTrampoline::callback_closure_inner(
                 if (!jsargs.growBy(1))
                     g_error("Unable to grow vector");
 
-                GIArgument* arg = args[i + c_args_offset];
-                if (g_arg_info_get_direction(&arg_info) == GI_DIRECTION_INOUT &&
-                    !g_arg_info_is_caller_allocates(&arg_info))
-                    arg = *reinterpret_cast<GIArgument**>(arg);
+                GIArgument* c_arg = args[i + c_args_offset];
+                if (arg->direction == GI_DIRECTION_INOUT)
+                    c_arg = get_out_argument(arg, args, i + c_args_offset);
 
                 if (!gjs_value_from_g_argument(context, jsargs[n_jsargs++],
-                                               &type_info, arg, false))
+                                               &arg->type_info, c_arg, false))
                     return false;
                 break;
             }
@@ -423,33 +468,27 @@ bool GjsCallbackTrampoline::callback_closure_inner(
     if (!gjs_closure_invoke(m_js_function, this_object, jsargs, rval, true))
         return false;
 
-    if (n_outargs == 0 && ret_type_is_void) {
+    if (m_n_outargs == 0 && ret_type_is_void) {
         /* void return value, no out args, nothing to do */
-    } else if (n_outargs == 0) {
+    } else if (m_n_outargs == 0) {
         GIArgument argument;
-        GITransfer transfer;
 
-        transfer = g_callable_info_get_caller_owns(m_info);
         /* non-void return value, no out args. Should
          * be a single return value. */
-        if (!gjs_value_to_g_argument(context, rval, ret_type, "callback",
-                                     GJS_ARGUMENT_RETURN_VALUE, transfer,
-                                     GjsArgumentFlags::MAY_BE_NULL, &argument))
+        if (!m_return_value.out(context, &m_return_value, rval, &argument))
             return false;
 
-        set_return_ffi_arg_from_giargument(ret_type, result, &argument);
-    } else if (n_outargs == 1 && ret_type_is_void) {
+        set_return_ffi_arg_from_giargument(&m_return_value, result, &argument);
+    } else if (m_n_outargs == 1 && ret_type_is_void) {
         /* void return value, one out args. Should
          * be a single return value. */
         for (int i = 0; i < n_args; i++) {
-            GIArgInfo arg_info;
-            g_callable_info_load_arg(m_info, i, &arg_info);
-            if (g_arg_info_get_direction(&arg_info) == GI_DIRECTION_IN)
+            GjsCallbackArgument* arg = &m_args[i];
+            if (arg->direction == GI_DIRECTION_IN)
                 continue;
 
-            if (!gjs_value_to_arg(context, rval, &arg_info,
-                                  get_argument_for_arg_info(&arg_info, args,
-                                                            i + c_args_offset)))
+            if (!arg->out(context, arg, rval,
+                          get_out_argument(arg, args, i + c_args_offset)))
                 return false;
 
             break;
@@ -477,34 +516,29 @@ bool GjsCallbackTrampoline::callback_closure_inner(
 
         if (!ret_type_is_void) {
             GIArgument argument;
-            GITransfer transfer = g_callable_info_get_caller_owns(m_info);
 
             if (!JS_GetElement(context, out_array, elem_idx, &elem))
                 return false;
 
-            if (!gjs_value_to_g_argument(context, elem, ret_type, "callback",
-                                         GJS_ARGUMENT_RETURN_VALUE, transfer,
-                                         GjsArgumentFlags::MAY_BE_NULL,
-                                         &argument))
+            if (!m_return_value.out(context, &m_return_value, elem, &argument))
                 return false;
 
-            set_return_ffi_arg_from_giargument(ret_type, result, &argument);
+            set_return_ffi_arg_from_giargument(&m_return_value, result,
+                                               &argument);
 
             elem_idx++;
         }
 
         for (int i = 0; i < n_args; i++) {
-            GIArgInfo arg_info;
-            g_callable_info_load_arg(m_info, i, &arg_info);
-            if (g_arg_info_get_direction(&arg_info) == GI_DIRECTION_IN)
+            GjsCallbackArgument* arg = &m_args[i];
+            if (arg->direction == GI_DIRECTION_IN)
                 continue;
 
             if (!JS_GetElement(context, out_array, elem_idx, &elem))
                 return false;
 
-            if (!gjs_value_to_arg(context, elem, &arg_info,
-                                  get_argument_for_arg_info(&arg_info, args,
-                                                            i + c_args_offset)))
+            if (!arg->out(context, arg, elem,
+                          get_out_argument(arg, args, i + c_args_offset)))
                 return false;
 
             elem_idx++;
@@ -533,13 +567,17 @@ GjsCallbackTrampoline::GjsCallbackTrampoline(GICallableInfo* callable_info,
                                              GIScopeType scope, bool is_vfunc)
     : m_info(callable_info, GjsAutoTakeOwnership()),
       m_scope(scope),
-      m_param_types(g_callable_info_get_n_args(callable_info), {}),
-      m_is_vfunc(is_vfunc) {
+      m_args(g_callable_info_get_n_args(callable_info)),
+      m_return_value(),
+      m_is_vfunc(is_vfunc),
+      m_can_throw_gerror(g_callable_info_can_throw_gerror(callable_info)) {
     g_atomic_ref_count_init(&ref_count);
+    GJS_ADD_BYTES(callback_trampoline, native_size());
 }
 
 GjsCallbackTrampoline::~GjsCallbackTrampoline() {
     g_assert(g_atomic_ref_count_compare(&ref_count, 0));
+    GJS_SUB_BYTES(callback_trampoline, native_size());
 
     if (m_info && m_closure)
         g_callable_info_free_closure(m_info, m_closure);
@@ -551,55 +589,80 @@ bool GjsCallbackTrampoline::initialize(JSContext* cx,
     g_assert(!m_js_function);
     g_assert(!m_closure);
 
-    /* Analyze param types and directions, similarly to
-     * init_cached_function_data */
-    for (size_t i = 0; i < m_param_types.size(); i++) {
-        GIDirection direction;
+    // Build the marshalling plan for the return value and the arguments,
+    // similarly to init_cached_function_data(), so that the introspection
+    // info doesn't have to be queried every time the callback is invoked
+    g_callable_info_load_return_type(m_info, &m_return_value.type_info);
+    m_return_value.arg_name = "callback";
+    m_return_value.tag = g_type_info_get_tag(&m_return_value.type_info);
+    m_return_value.interface_type =
+        gjs_callback_interface_type(&m_return_value.type_info);
+    m_return_value.direction = GI_DIRECTION_OUT;
+    m_return_value.transfer = g_callable_info_get_caller_owns(m_info);
+    m_return_value.flags = GjsArgumentFlags::MAY_BE_NULL;
+    m_return_value.is_return_value = true;
+    m_return_value.out = gjs_callback_out_marshaller(m_return_value.tag);
+
+    for (size_t i = 0; i < m_args.size(); i++) {
+        GjsCallbackArgument* arg = &m_args[i];
         GIArgInfo arg_info;
-        GITypeInfo type_info;
-        GITypeTag type_tag;
-
-        if (m_param_types[i] == PARAM_SKIPPED)
-            continue;
 
         g_callable_info_load_arg(m_info, i, &arg_info);
-        g_arg_info_load_type(&arg_info, &type_info);
+        g_arg_info_load_type(&arg_info, &arg->type_info);
+
+        arg->arg_name = g_base_info_get_name(&arg_info);
+        arg->tag = g_type_info_get_tag(&arg->type_info);
+        arg->interface_type = gjs_callback_interface_type(&arg->type_info);
+        arg->direction = g_arg_info_get_direction(&arg_info);
+        arg->transfer = g_arg_info_get_ownership_transfer(&arg_info);
+        arg->is_return_value = g_arg_info_is_return_value(&arg_info);
+
+        GjsArgumentFlags flags = GjsArgumentFlags::NONE;
+        if (g_arg_info_may_be_null(&arg_info))
+            flags |= GjsArgumentFlags::MAY_BE_NULL;
+        if (g_arg_info_is_caller_allocates(&arg_info))
+            flags |= GjsArgumentFlags::CALLER_ALLOCATES;
+        arg->flags = flags;
+
+        arg->out = gjs_callback_out_marshaller(arg->tag);
+
+        if (arg->tag != GI_TYPE_TAG_VOID && arg->direction != GI_DIRECTION_IN)
+            m_n_outargs++;
+    }
 
-        direction = g_arg_info_get_direction(&arg_info);
-        type_tag = g_type_info_get_tag(&type_info);
+    /* Analyze param types and directions, similarly to
+     * init_cached_function_data */
+    for (size_t i = 0; i < m_args.size(); i++) {
+        GjsCallbackArgument* arg = &m_args[i];
+
+        if (arg->param_type == PARAM_SKIPPED)
+            continue;
 
-        if (direction != GI_DIRECTION_IN) {
+        if (arg->direction != GI_DIRECTION_IN) {
             /* INOUT and OUT arguments are handled differently. */
             continue;
         }
 
-        if (type_tag == GI_TYPE_TAG_INTERFACE) {
-            GIInfoType interface_type;
-
-            GjsAutoBaseInfo interface_info =
-                g_type_info_get_interface(&type_info);
-            interface_type = g_base_info_get_type(interface_info);
-            if (interface_type == GI_INFO_TYPE_CALLBACK) {
+        if (arg->tag == GI_TYPE_TAG_INTERFACE) {
+            if (arg->interface_type == GI_INFO_TYPE_CALLBACK) {
                 gjs_throw(cx,
                           "%s %s accepts another callback as a parameter. This "
                           "is not supported",
                           m_is_vfunc ? "VFunc" : "Callback", m_info.name());
                 return false;
             }
-        } else if (type_tag == GI_TYPE_TAG_ARRAY) {
-            if (g_type_info_get_array_type(&type_info) == GI_ARRAY_TYPE_C) {
-                int array_length_pos = g_type_info_get_array_length(&type_info);
+        } else if (arg->tag == GI_TYPE_TAG_ARRAY) {
+            if (g_type_info_get_array_type(&arg->type_info) == GI_ARRAY_TYPE_C) {
+                int array_length_pos =
+                    g_type_info_get_array_length(&arg->type_info);
 
                 if (array_length_pos < 0)
                     continue;
 
-                if (static_cast<size_t>(array_length_pos) <
-                    m_param_types.size()) {
-                    GIArgInfo length_arg_info;
+                if (static_cast<size_t>(array_length_pos) < m_args.size()) {
+                    GjsCallbackArgument* length_arg = &m_args[array_length_pos];
 
-                    g_callable_info_load_arg(m_info, array_length_pos,
-                                             &length_arg_info);
-                    if (g_arg_info_get_direction(&length_arg_info) != direction) {
+                    if (length_arg->direction != arg->direction) {
                         gjs_throw(cx,
                                   "%s %s has an array with different-direction "
                                   "length argument. This is not supported",
@@ -608,8 +671,9 @@ bool GjsCallbackTrampoline::initialize(JSContext* cx,
                         return false;
                     }
 
-                    m_param_types[array_length_pos] = PARAM_SKIPPED;
-                    m_param_types[i] = PARAM_ARRAY;
+                    length_arg->param_type = PARAM_SKIPPED;
+                    arg->param_type = PARAM_ARRAY;
+                    arg->array_length_pos = array_length_pos;
                 }
             }
         }
@@ -760,8 +824,8 @@ static bool gjs_invoke_c_function(JSContext* context, Function* function,
     // - state.inout_original_cvalues: For the special case of (inout) args, we
     //   need to keep track of the original values we passed into the function,
     //   in case we need to free it.
-    // - ffi_arg_pointers: For passing data to FFI, we need to create another
-    //   layer of indirection; this array is a pointer to an element in
+    // - state.ffi_arg_pointers: For passing data to FFI, we need to create
+    //   another layer of indirection; this array is a pointer to an element in
     //   state.in_cvalues or state.out_cvalues.
     // - return_value: The actual return value of the C function, i.e. not an
     //   (out) param
@@ -776,9 +840,13 @@ static bool gjs_invoke_c_function(JSContext* context, Function* function,
     //
     // Use gi_arg_pos to index inside the GIArgument array. Use ffi_arg_pos to
     // index inside ffi_arg_pointers.
+    //
+    // For functions with few arguments, all of these arrays are stored inline
+    // in the call state, so this path does not allocate.
     GjsFunctionCallState state(context, function->info, gi_argc);
-
-    auto ffi_arg_pointers = std::make_unique<void*[]>(ffi_argc);
+    g_assert(ffi_argc <= unsigned(gi_argc + state.first_arg_offset()) &&
+             "Not enough room for ffi arguments");
+    void** ffi_arg_pointers = state.ffi_arg_pointers;
 
     failed = false;
     unsigned ffi_arg_pos = 0;  // index into ffi_arg_pointers
@@ -873,7 +941,7 @@ static bool gjs_invoke_c_function(JSContext* context, Function* function,
     return_value_p = get_return_ffi_pointer_from_giargument(
         &function->arguments[-1], &return_value);
     ffi_call(&(function->invoker.cif), FFI_FN(function->invoker.native_address),
-             return_value_p, ffi_arg_pointers.get());
+             return_value_p, ffi_arg_pointers);
 
     /* Return value and out arguments are valid only if invocation doesn't
      * return error. In arguments need to be released always.
@@ -1071,6 +1139,12 @@ static void function_finalize(JSFreeOp*, JSObject* obj) {
     if (priv == NULL)
         return; /* we are the prototype, not a real instance, so constructor never called */
 
+    if (priv->arguments_bytes) {
+        JS::RemoveAssociatedMemory(obj, priv->arguments_bytes,
+                                   MemoryUse::FunctionArgumentCache);
+        GJS_SUB_BYTES(argument_cache, priv->arguments_bytes);
+    }
+
     uninit_cached_function_data(priv);
 
     GJS_DEC_COUNTER(function);
@@ -1308,6 +1382,16 @@ function_new(JSContext      *context,
     if (!init_cached_function_data(context, priv, gtype, (GICallableInfo *)info))
       return NULL;
 
+    if (priv->arguments) {
+        size_t offset = g_callable_info_is_method(info) ? 2 : 1;
+        priv->arguments_bytes =
+            (g_callable_info_get_n_args(info) + offset) *
+            sizeof(GjsArgumentCache);
+        JS::AddAssociatedMemory(function, priv->arguments_bytes,
+                                MemoryUse::FunctionArgumentCache);
+        GJS_ADD_BYTES(argument_cache, priv->arguments_bytes);
+    }
+
     return function;
 }
 
@@ -7,7 +7,10 @@
 
 #include <config.h>
 
-#include <unordered_set>
+#include <stdint.h>
+
+#include <bitset>
+#include <memory>  // for unique_ptr
 #include <vector>
 
 #include <ffi.h>
@@ -18,6 +21,8 @@
 #include <js/RootingAPI.h>
 #include <js/TypeDecls.h>
 
+#include "gi/arg-cache.h"
+#include "gi/arg.h"
 #include "gjs/jsapi-util.h"
 #include "gjs/macros.h"
 
@@ -36,6 +41,39 @@ typedef enum {
 using GjsAutoGClosure =
     GjsAutoPointer<GClosure, GClosure, g_closure_unref, g_closure_ref>;
 
+struct GjsCallbackArgument;
+
+using GjsCallbackOutMarshaller = bool (*)(JSContext* cx,
+                                          GjsCallbackArgument* self,
+                                          JS::HandleValue value,
+                                          GIArgument* arg);
+
+// Marshalling plan for one argument (or the return value) of a JS callback or
+// vfunc implementation. These are computed once, when the trampoline is
+// created, so that invoking the callback does not have to query the
+// introspection info again.
+struct GjsCallbackArgument {
+    GITypeInfo type_info;
+    const char* arg_name;
+    // Converts the JS value returned from the callback, for out and inout
+    // arguments and the return value
+    GjsCallbackOutMarshaller out;
+    GIInfoType interface_type;  // GI_INFO_TYPE_INVALID if not an interface
+
+    GjsParamType param_type : 4;
+    GITypeTag tag : 5;
+    GIDirection direction : 2;
+    GITransfer transfer : 2;
+    GjsArgumentFlags flags : 5;
+    bool is_return_value : 1;
+    uint8_t array_length_pos;
+
+    [[nodiscard]] constexpr GjsArgumentType argument_type() const {
+        return is_return_value ? GJS_ARGUMENT_RETURN_VALUE
+                               : GJS_ARGUMENT_ARGUMENT;
+    }
+};
+
 struct GjsCallbackTrampoline {
     GjsCallbackTrampoline(GICallableInfo* callable_info, GIScopeType scope,
                           bool is_vfunc);
@@ -54,18 +92,24 @@ struct GjsCallbackTrampoline {
     GJS_JSAPI_RETURN_CONVENTION
     bool callback_closure_inner(JSContext* cx, JS::HandleObject this_object,
                                 JS::MutableHandleValue rval, GIArgument** args,
-                                GITypeInfo* ret_type, int n_args,
                                 int c_args_offset, void* result);
     void warn_about_illegal_js_callback(const char* when, const char* reason);
+    [[nodiscard]] size_t native_size() const {
+        return sizeof(GjsCallbackTrampoline) +
+               m_args.capacity() * sizeof(GjsCallbackArgument);
+    }
 
     GjsAutoCallableInfo m_info;
     GjsAutoGClosure m_js_function;
 
     ffi_closure* m_closure = nullptr;
     GIScopeType m_scope;
-    std::vector<GjsParamType> m_param_types;
+    std::vector<GjsCallbackArgument> m_args;
+    GjsCallbackArgument m_return_value;
+    int m_n_outargs = 0;
 
-    bool m_is_vfunc;
+    bool m_is_vfunc : 1;
+    bool m_can_throw_gerror : 1;
     ffi_cif m_cif;
 };
 
@@ -84,10 +128,20 @@ using GjsAutoCallbackTrampoline =
 
 // Stack allocation only!
 struct GjsFunctionCallState {
+    // Most introspected functions take only a handful of arguments, so the
+    // argument arrays for those are stored inline. Only functions with unusually
+    // long signatures need to allocate them on the heap. Each array has room for
+    // the GI arguments plus the return value and instance parameter, which also
+    // covers the trailing GError** in the ffi argument array.
+    static constexpr int MAX_INLINE_ARGS = 8;
+    static constexpr int MAX_INLINE_SLOTS = MAX_INLINE_ARGS + 2;
+
     GIArgument* in_cvalues;
     GIArgument* out_cvalues;
     GIArgument* inout_original_cvalues;
-    std::unordered_set<GIArgument*> ignore_release;
+    void** ffi_arg_pointers;
+    // Indexed by GI argument position
+    std::bitset<GjsArgumentCache::MAX_ARGS> ignore_release;
     JS::RootedObject instance_object;
     int gi_argc;
     bool call_completed : 1;
@@ -99,18 +153,36 @@ struct GjsFunctionCallState {
           call_completed(false),
           is_method(g_callable_info_is_method(callable)) {
         int size = gi_argc + first_arg_offset();
-        in_cvalues = new GIArgument[size] + first_arg_offset();
-        out_cvalues = new GIArgument[size] + first_arg_offset();
-        inout_original_cvalues = new GIArgument[size] + first_arg_offset();
+        GIArgument* storage = m_inline_cvalues;
+        ffi_arg_pointers = m_inline_ffi_arg_pointers;
+
+        if (G_UNLIKELY(size > MAX_INLINE_SLOTS)) {
+            m_heap_cvalues.reset(new GIArgument[3 * size]);
+            m_heap_ffi_arg_pointers.reset(new void*[size]);
+            storage = m_heap_cvalues.get();
+            ffi_arg_pointers = m_heap_ffi_arg_pointers.get();
+        }
+
+        in_cvalues = storage + first_arg_offset();
+        out_cvalues = storage + size + first_arg_offset();
+        inout_original_cvalues = storage + 2 * size + first_arg_offset();
     }
 
-    ~GjsFunctionCallState() {
-        delete[](in_cvalues - first_arg_offset());
-        delete[](out_cvalues - first_arg_offset());
-        delete[](inout_original_cvalues - first_arg_offset());
-    }
+    // The array pointers point into this object
+    GjsFunctionCallState(const GjsFunctionCallState&) = delete;
+    GjsFunctionCallState& operator=(const GjsFunctionCallState&) = delete;
 
     constexpr int first_arg_offset() const { return is_method ? 2 : 1; }
+
+    [[nodiscard]] constexpr bool uses_inline_storage() const {
+        return ffi_arg_pointers == m_inline_ffi_arg_pointers;
+    }
+
+ private:
+    GIArgument m_inline_cvalues[3 * MAX_INLINE_SLOTS];
+    void* m_inline_ffi_arg_pointers[MAX_INLINE_SLOTS];
+    std::unique_ptr<GIArgument[]> m_heap_cvalues;
+    std::unique_ptr<void*[]> m_heap_ffi_arg_pointers;
 };
 
 GJS_JSAPI_RETURN_CONVENTION
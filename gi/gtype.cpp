@@ -79,7 +79,8 @@ get_name_func (JSContext *context,
         rec.rval().setNull();
         return true;
     }
-    return gjs_string_from_utf8(context, g_type_name(gtype), rec.rval());
+    return gjs_string_from_static_utf8(context, g_type_name(gtype),
+                                       rec.rval());
 }
 
 /* Properties */
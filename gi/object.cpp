@@ -6,12 +6,12 @@
 #include <config.h>
 
 #include <stdint.h>
-#include <string.h>  // for memset, strcmp
+#include <string.h>  // for memset, strchr, strcmp
 
-#include <algorithm>  // for find
 #include <functional>  // for mem_fn
 #include <string>
 #include <tuple>        // for tie
+#include <unordered_map>
 #include <utility>      // for move
 #include <vector>
 
@@ -20,6 +20,7 @@
 #include <glib-object.h>
 #include <glib.h>
 
+#include <js/Array.h>  // for GetArrayLength, IsArrayObject, NewArrayObject
 #include <js/CallArgs.h>
 #include <js/CharacterEncoding.h>
 #include <js/Class.h>
@@ -55,6 +56,7 @@
 #include "gjs/jsapi-util-args.h"
 #include "gjs/jsapi-util-root.h"
 #include "gjs/mem-private.h"
+#include "gjs/profiler-private.h"
 #include "util/log.h"
 
 class JSTracer;
@@ -67,15 +69,28 @@ class JSTracer;
 
 #if defined(__x86_64__) && defined(__clang__)
 /* This isn't meant to be comprehensive, but should trip on at least one CI job
- * if sizeof(ObjectInstance) is increased. */
-static_assert(sizeof(ObjectInstance) <= 88,
+ * if sizeof(ObjectInstance) is increased. Anything that only objects with JS
+ * state need belongs out of line, like the rooting in GjsMaybeOwned and the
+ * closures in closures_by_instance; past 56 bytes, malloc() rounds up to the
+ * next bucket. */
+static_assert(sizeof(ObjectInstance) <= 56,
               "Think very hard before increasing the size of ObjectInstance. "
               "There can be tens of thousands of them alive in a typical "
               "gnome-shell run.");
 #endif  // x86-64 clang
 
 bool ObjectInstance::s_weak_pointer_callback = false;
-ObjectInstance *ObjectInstance::wrapped_gobject_list = nullptr;
+size_t ObjectInstance::s_weak_wrappers_examined = 0;
+size_t ObjectInstance::s_wrappers_collected = 0;
+ObjectInstance* ObjectInstance::rooted_wrapper_list = nullptr;
+
+// All GClosures installed on each object (from signal connections and
+// scope-notify callbacks passed to methods), used when tracing. Only objects
+// that use toggle refs have closures, so the sets are kept here rather than in
+// every ObjectInstance.
+static std::unordered_map<const ObjectInstance*, GjsClosureSet>
+    closures_by_instance;
+ObjectInstance* ObjectInstance::weak_wrapper_list = nullptr;
 
 // clang-format off
 G_DEFINE_QUARK(gjs::custom-type, ObjectBase::custom_type)
@@ -150,15 +165,25 @@ GjsListLink::size(void) const
 }
 
 void ObjectInstance::link(void) {
-    if (wrapped_gobject_list)
-        m_instance_link.prepend(this, wrapped_gobject_list);
-    wrapped_gobject_list = this;
+    g_assert(!m_linked);
+    m_in_weak_list = !wrapper_is_rooted();
+    ObjectInstance*& head =
+        m_in_weak_list ? weak_wrapper_list : rooted_wrapper_list;
+    if (head)
+        m_instance_link.prepend(this, head);
+    head = this;
+    m_linked = true;
 }
 
 void ObjectInstance::unlink(void) {
-    if (wrapped_gobject_list == this)
-        wrapped_gobject_list = m_instance_link.next();
+    if (!m_linked)
+        return;
+    ObjectInstance*& head =
+        m_in_weak_list ? weak_wrapper_list : rooted_wrapper_list;
+    if (head == this)
+        head = m_instance_link.next();
     m_instance_link.unlink();
+    m_linked = false;
 }
 
 const void* ObjectBase::jsobj_addr(void) const {
@@ -228,6 +253,77 @@ ObjectPrototype* ObjectPrototype::for_gtype(GType gtype) {
         g_type_get_qdata(gtype, gjs_object_priv_quark()));
 }
 
+/*
+ * ObjectPrototype::release_caches:
+ *
+ * Empties the property, field, negative lookup, and signal caches, which are
+ * filled again on demand. Returns the number of entries that were dropped.
+ */
+size_t ObjectPrototype::release_caches(void) {
+    size_t released = m_property_cache.count() + m_field_cache.count() +
+                      m_unresolvable_cache.count() + m_signal_cache.size();
+    m_property_cache.clearAndCompact();
+    m_field_cache.clearAndCompact();
+    m_unresolvable_cache.clearAndCompact();
+    SignalCache().swap(m_signal_cache);  // also frees the buckets
+    return released;
+}
+
+/*
+ * ObjectPrototype::caches_size:
+ *
+ * Returns the approximate number of bytes used by the property, field,
+ * negative lookup, and signal caches, not counting what the cached values point
+ * to. The signal cache is counted as one bucket pointer per bucket and one node,
+ * with its next pointer, per entry.
+ */
+size_t ObjectPrototype::caches_size(void) const {
+    return m_property_cache.capacity() *
+               (sizeof(PropertyCache::Entry) + sizeof(js::HashNumber)) +
+           m_field_cache.capacity() *
+               (sizeof(FieldCache::Entry) + sizeof(js::HashNumber)) +
+           m_unresolvable_cache.capacity() *
+               (sizeof(NegativeLookupCache::Entry) + sizeof(js::HashNumber)) +
+           m_signal_cache.bucket_count() * sizeof(void*) +
+           m_signal_cache.size() *
+               (sizeof(SignalCache::value_type) + sizeof(void*));
+}
+
+// Calls @func on the ObjectPrototype of @gtype and of all of its descendants
+// that have one
+template <typename F>
+static void for_each_prototype_in_subtree(GType gtype, F func) {
+    if (ObjectPrototype* priv = ObjectPrototype::for_gtype(gtype))
+        func(priv);
+
+    unsigned n_children;
+    GjsAutoFree<GType> children = g_type_children(gtype, &n_children);
+    for (unsigned ix = 0; ix < n_children; ix++)
+        for_each_prototype_in_subtree(children.get()[ix], func);
+}
+
+/*
+ * ObjectPrototype::release_all_caches:
+ *
+ * Calls release_caches() on every ObjectPrototype, found by walking the GType
+ * hierarchy, for example when the system is low on memory.
+ */
+size_t ObjectPrototype::release_all_caches(void) {
+    size_t released = 0;
+    for_each_prototype_in_subtree(G_TYPE_OBJECT, [&released](auto* priv) {
+        released += priv->release_caches();
+    });
+    return released;
+}
+
+size_t ObjectPrototype::all_caches_size(void) {
+    size_t size = 0;
+    for_each_prototype_in_subtree(G_TYPE_OBJECT, [&size](auto* priv) {
+        size += priv->caches_size();
+    });
+    return size;
+}
+
 void ObjectPrototype::set_type_qdata(void) {
     g_type_set_qdata(m_gtype, gjs_object_priv_quark(), this);
 }
@@ -244,16 +340,25 @@ ObjectInstance::unset_object_qdata(void)
     g_object_set_qdata(m_ptr, gjs_object_priv_quark(), nullptr);
 }
 
-GParamSpec* ObjectPrototype::find_param_spec_from_id(JSContext* cx,
-                                                     JS::HandleString key) {
+/*
+ * ObjectPrototype::lookup_param_spec:
+ *
+ * Like find_param_spec_from_id(), but a nonexistent property is not an error;
+ * in that case, @pspec_out is set to null. Returns false only if an exception
+ * is pending.
+ */
+bool ObjectPrototype::lookup_param_spec(JSContext* cx, JS::HandleString key,
+                                        GParamSpec** pspec_out) {
     /* First check for the ID in the cache */
     auto entry = m_property_cache.lookupForAdd(key);
-    if (entry)
-        return entry->value();
+    if (entry) {
+        *pspec_out = entry->value();
+        return true;
+    }
 
     JS::UniqueChars js_prop_name(JS_EncodeStringToUTF8(cx, key));
     if (!js_prop_name)
-        return nullptr;
+        return false;
 
     GjsAutoChar gname = gjs_hyphen_from_camel(js_prop_name.get());
     GjsAutoTypeClass<GObjectClass> gobj_class(m_gtype);
@@ -261,15 +366,33 @@ GParamSpec* ObjectPrototype::find_param_spec_from_id(JSContext* cx,
     GjsAutoParam param_spec(pspec, GjsAutoTakeOwnership());
 
     if (!param_spec) {
-        gjs_wrapper_throw_nonexistent_field(cx, m_gtype, js_prop_name.get());
-        return nullptr;
+        *pspec_out = nullptr;
+        return true;
     }
 
     if (!m_property_cache.add(entry, key, std::move(param_spec))) {
         JS_ReportOutOfMemory(cx);
+        return false;
+    }
+    *pspec_out = pspec; /* owned by property cache */
+    return true;
+}
+
+GParamSpec* ObjectPrototype::find_param_spec_from_id(JSContext* cx,
+                                                     JS::HandleString key) {
+    GParamSpec* pspec;
+    if (!lookup_param_spec(cx, key, &pspec))
+        return nullptr;
+
+    if (!pspec) {
+        JS::UniqueChars js_prop_name(JS_EncodeStringToUTF8(cx, key));
+        if (!js_prop_name)
+            return nullptr;
+        gjs_wrapper_throw_nonexistent_field(cx, m_gtype, js_prop_name.get());
         return nullptr;
     }
-    return pspec; /* owned by property cache */
+
+    return pspec;
 }
 
 /* A hook on adding a property to an object. This is called during a set
@@ -304,6 +427,7 @@ bool ObjectInstance::add_property_impl(JSContext* cx, JS::HandleObject obj,
     return true;
 }
 
+template <GType TYPE>
 bool ObjectBase::prop_getter(JSContext* cx, unsigned argc, JS::Value* vp) {
     GJS_GET_WRAPPER_PRIV(cx, argc, vp, args, obj, ObjectBase, priv);
 
@@ -317,9 +441,54 @@ bool ObjectBase::prop_getter(JSContext* cx, unsigned argc, JS::Value* vp) {
         /* Ignore silently; note that this is different from what we do for
          * boxed types, for historical reasons */
 
-    return priv->to_instance()->prop_getter_impl(cx, name, args.rval());
+    return priv->to_instance()->prop_getter_impl<TYPE>(cx, name, args.rval());
+}
+
+/*
+ * Converts a GValue holding a property value of fundamental type TYPE to JS,
+ * without going through the type dispatch in gjs_value_from_g_value().
+ * G_TYPE_INVALID means the property type has no fast path.
+ */
+template <GType TYPE>
+GJS_JSAPI_RETURN_CONVENTION static bool prop_value_to_js(
+    JSContext* cx, const GValue* gvalue, JS::MutableHandleValue rval) {
+    if constexpr (TYPE == G_TYPE_BOOLEAN) {
+        rval.setBoolean(!!g_value_get_boolean(gvalue));
+    } else if constexpr (TYPE == G_TYPE_INT) {
+        rval.setInt32(g_value_get_int(gvalue));
+    } else if constexpr (TYPE == G_TYPE_UINT) {
+        rval.setNumber(g_value_get_uint(gvalue));
+    } else if constexpr (TYPE == G_TYPE_INT64) {
+        rval.setNumber(static_cast<double>(g_value_get_int64(gvalue)));
+    } else if constexpr (TYPE == G_TYPE_UINT64) {
+        rval.setNumber(static_cast<double>(g_value_get_uint64(gvalue)));
+    } else if constexpr (TYPE == G_TYPE_DOUBLE) {
+        rval.setNumber(g_value_get_double(gvalue));
+    } else if constexpr (TYPE == G_TYPE_STRING) {
+        const char* str = g_value_get_string(gvalue);
+        if (!str) {
+            rval.setNull();
+            return true;
+        }
+        return gjs_string_from_utf8(cx, str, rval);
+    } else if constexpr (TYPE == G_TYPE_OBJECT) {
+        auto* gobj = static_cast<GObject*>(g_value_get_object(gvalue));
+        if (!gobj) {
+            rval.setNull();
+            return true;
+        }
+        JSObject* wrapper = ObjectInstance::wrapper_from_gobject(cx, gobj);
+        if (!wrapper)
+            return false;
+        rval.setObject(*wrapper);
+    } else {
+        static_assert(TYPE == G_TYPE_INVALID, "No fast path for this type");
+        return gjs_value_from_g_value(cx, rval, gvalue);
+    }
+    return true;
 }
 
+template <GType TYPE>
 bool ObjectInstance::prop_getter_impl(JSContext* cx, JS::HandleString name,
                                       JS::MutableHandleValue rval) {
     if (!check_gobject_disposed("get any property from"))
@@ -348,7 +517,11 @@ bool ObjectInstance::prop_getter_impl(JSContext* cx, JS::HandleString name,
 
     g_value_init(&gvalue, G_PARAM_SPEC_VALUE_TYPE(param));
     g_object_get_property(m_ptr, param->name, &gvalue);
-    if (!gjs_value_from_g_value(cx, rval, &gvalue)) {
+    // A subclass may have overridden the property, so check the type again
+    bool ok = G_VALUE_HOLDS(&gvalue, TYPE)
+                  ? prop_value_to_js<TYPE>(cx, &gvalue, rval)
+                  : gjs_value_from_g_value(cx, rval, &gvalue);
+    if (!ok) {
         g_value_unset(&gvalue);
         return false;
     }
@@ -399,6 +572,8 @@ bool ObjectInstance::field_getter_impl(JSContext* cx, JS::HandleString name,
 
     ObjectPrototype* proto_priv = get_prototype();
     GIFieldInfo* field = proto_priv->lookup_cached_field_info(cx, name);
+    if (!field)
+        return false;
     GITypeTag tag;
     GIArgument arg = { 0 };
 
@@ -439,6 +614,7 @@ bool ObjectInstance::field_getter_impl(JSContext* cx, JS::HandleString name,
 
 /* Dynamic setter for GObject properties. Returns false on OOM/exception.
  * args.rval() becomes the "stored value" for the property. */
+template <GType TYPE>
 bool ObjectBase::prop_setter(JSContext* cx, unsigned argc, JS::Value* vp) {
     GJS_GET_WRAPPER_PRIV(cx, argc, vp, args, obj, ObjectBase, priv);
 
@@ -455,9 +631,77 @@ bool ObjectBase::prop_setter(JSContext* cx, unsigned argc, JS::Value* vp) {
     /* Clear the JS stored value, to avoid keeping additional references */
     args.rval().setUndefined();
 
-    return priv->to_instance()->prop_setter_impl(cx, name, args[0]);
+    return priv->to_instance()->prop_setter_impl<TYPE>(cx, name, args[0]);
+}
+
+/*
+ * Converts a JS value to a GValue holding a property value of fundamental type
+ * TYPE. Only the common cases are handled here, without side effects; for
+ * anything else, *handled is set to false and the caller must fall back to
+ * gjs_value_to_g_value(), which also takes care of throwing the appropriate
+ * exception.
+ */
+template <GType TYPE>
+GJS_JSAPI_RETURN_CONVENTION static bool prop_value_from_js(
+    JSContext* cx, JS::HandleValue value, GValue* gvalue, bool* handled) {
+    *handled = true;
+
+    if constexpr (TYPE == G_TYPE_BOOLEAN) {
+        g_value_set_boolean(gvalue, JS::ToBoolean(value));
+        return true;
+    } else if constexpr (TYPE == G_TYPE_INT) {
+        if (value.isInt32()) {
+            g_value_set_int(gvalue, value.toInt32());
+            return true;
+        }
+        if (value.isDouble()) {
+            g_value_set_int(gvalue, JS::ToInt32(value.toDouble()));
+            return true;
+        }
+    } else if constexpr (TYPE == G_TYPE_UINT) {
+        if (value.isNumber()) {
+            g_value_set_uint(gvalue, JS::ToUint32(value.toNumber()));
+            return true;
+        }
+    } else if constexpr (TYPE == G_TYPE_DOUBLE) {
+        if (value.isNumber()) {
+            g_value_set_double(gvalue, value.toNumber());
+            return true;
+        }
+    } else if constexpr (TYPE == G_TYPE_STRING) {
+        if (value.isNull()) {
+            g_value_set_string(gvalue, nullptr);
+            return true;
+        }
+        if (value.isString()) {
+            JS::UniqueChars utf8_string = gjs_string_to_utf8(cx, value);
+            if (!utf8_string)
+                return false;
+            g_value_set_string(gvalue, utf8_string.get());
+            return true;
+        }
+    } else if constexpr (TYPE == G_TYPE_OBJECT) {
+        if (value.isNull()) {
+            g_value_set_object(gvalue, nullptr);
+            return true;
+        }
+        if (value.isObject()) {
+            GObject* gobj;
+            JS::RootedObject obj(cx, &value.toObject());
+            if (!ObjectBase::typecheck(cx, obj, nullptr, G_VALUE_TYPE(gvalue)) ||
+                !ObjectBase::to_c_ptr(cx, obj, &gobj))
+                return false;
+            // A disposed object is treated as null
+            g_value_set_object(gvalue, gobj);
+            return true;
+        }
+    }
+
+    *handled = false;
+    return true;
 }
 
+template <GType TYPE>
 bool ObjectInstance::prop_setter_impl(JSContext* cx, JS::HandleString name,
                                       JS::HandleValue value) {
     if (!check_gobject_disposed("set any property on"))
@@ -485,7 +729,13 @@ bool ObjectInstance::prop_setter_impl(JSContext* cx, JS::HandleString name,
 
     GValue gvalue = G_VALUE_INIT;
     g_value_init(&gvalue, G_PARAM_SPEC_VALUE_TYPE(param_spec));
-    if (!gjs_value_to_g_value(cx, value, &gvalue)) {
+    bool handled = false;
+    if (G_VALUE_HOLDS(&gvalue, TYPE) &&
+        !prop_value_from_js<TYPE>(cx, value, &gvalue, &handled)) {
+        g_value_unset(&gvalue);
+        return false;
+    }
+    if (!handled && !gjs_value_to_g_value(cx, value, &gvalue)) {
         g_value_unset(&gvalue);
         return false;
     }
@@ -525,6 +775,8 @@ bool ObjectInstance::field_setter_not_impl(JSContext* cx,
 
     ObjectPrototype* proto_priv = get_prototype();
     GIFieldInfo* field = proto_priv->lookup_cached_field_info(cx, name);
+    if (!field)
+        return false;
 
     /* As far as I know, GI never exposes GObject instance struct fields as
      * writable, so no need to implement this for the time being */
@@ -629,10 +881,45 @@ bool ObjectPrototype::lazy_define_gobject_property(JSContext* cx,
 
     debug_jsprop("Defining lazy GObject property", id, obj);
 
+    // Bind accessors specialized for the type of the property's value, if
+    // there are any, so that getting and setting skips the generic conversion
+    JSNative getter = &ObjectBase::prop_getter<>;
+    JSNative setter = &ObjectBase::prop_setter<>;
+    GjsAutoChar canonical_name = gjs_hyphen_from_camel(name);
+    GjsAutoTypeClass<GObjectClass> oclass(m_gtype);
+    GParamSpec* pspec = g_object_class_find_property(oclass, canonical_name);
+    if (pspec) {
+        switch (G_TYPE_FUNDAMENTAL(G_PARAM_SPEC_VALUE_TYPE(pspec))) {
+#define BIND_TYPED_ACCESSORS(TYPE)                    \
+    case TYPE:                                        \
+        getter = &ObjectBase::prop_getter<TYPE>;      \
+        setter = &ObjectBase::prop_setter<TYPE>;      \
+        break;
+            BIND_TYPED_ACCESSORS(G_TYPE_BOOLEAN)
+            BIND_TYPED_ACCESSORS(G_TYPE_INT)
+            BIND_TYPED_ACCESSORS(G_TYPE_UINT)
+            BIND_TYPED_ACCESSORS(G_TYPE_INT64)
+            BIND_TYPED_ACCESSORS(G_TYPE_UINT64)
+            BIND_TYPED_ACCESSORS(G_TYPE_DOUBLE)
+            BIND_TYPED_ACCESSORS(G_TYPE_STRING)
+            BIND_TYPED_ACCESSORS(G_TYPE_OBJECT)
+#undef BIND_TYPED_ACCESSORS
+            case G_TYPE_INTERFACE:
+                // Interfaces that require GObject are stored as objects
+                if (g_type_is_a(G_PARAM_SPEC_VALUE_TYPE(pspec),
+                                G_TYPE_OBJECT)) {
+                    getter = &ObjectBase::prop_getter<G_TYPE_OBJECT>;
+                    setter = &ObjectBase::prop_setter<G_TYPE_OBJECT>;
+                }
+                break;
+            default:
+                break;
+        }
+    }
+
     JS::RootedValue private_id(cx, JS::StringValue(JSID_TO_STRING(id)));
     if (!gjs_define_property_dynamic(
-            cx, obj, name, "gobject_prop", &ObjectBase::prop_getter,
-            &ObjectBase::prop_setter, private_id,
+            cx, obj, name, "gobject_prop", getter, setter, private_id,
             // Make property configurable so that interface properties can be
             // overridden by GObject.ParamSpec.override in the class that
             // implements them
@@ -751,8 +1038,9 @@ bool ObjectPrototype::resolve_no_info(JSContext* cx, JS::HandleObject obj,
 bool ObjectBase::id_is_never_lazy(jsid name, const GjsAtoms& atoms) {
     // Keep this list in sync with ObjectBase::proto_properties and
     // ObjectBase::proto_methods. However, explicitly do not include
-    // connect() in it, because there are a few cases where the lazy property
-    // should override the predefined one, such as Gio.Cancellable.connect().
+    // connect(), get(), or set() in it, because there are a few cases where the
+    // lazy property should override the predefined one, such as
+    // Gio.Cancellable.connect() or Gtk.ListStore.set().
     return name == atoms.init() || name == atoms.connect_after() ||
            name == atoms.emit();
 }
@@ -1075,8 +1363,8 @@ ObjectInstance::gobj_dispose_notify(void)
 }
 
 void ObjectInstance::iterate_wrapped_gobjects(
-    const ObjectInstance::Action& action) {
-    ObjectInstance *link = ObjectInstance::wrapped_gobject_list;
+    ObjectInstance* head, const ObjectInstance::Action& action) {
+    ObjectInstance* link = head;
     while (link) {
         ObjectInstance *next = link->next();
         action(link);
@@ -1085,10 +1373,11 @@ void ObjectInstance::iterate_wrapped_gobjects(
 }
 
 void ObjectInstance::remove_wrapped_gobjects_if(
-    const ObjectInstance::Predicate& predicate,
+    ObjectInstance* head, const ObjectInstance::Predicate& predicate,
     const ObjectInstance::Action& action) {
     std::vector<ObjectInstance *> removed;
-    iterate_wrapped_gobjects([&predicate, &removed](ObjectInstance* link) {
+    iterate_wrapped_gobjects(head, [&predicate,
+                                    &removed](ObjectInstance* link) {
         if (predicate(link)) {
             removed.push_back(link);
             link->unlink();
@@ -1108,6 +1397,7 @@ void ObjectInstance::remove_wrapped_gobjects_if(
 void ObjectInstance::context_dispose_notify(void*, GObject* where_the_object_was
                                             [[maybe_unused]]) {
     ObjectInstance::iterate_wrapped_gobjects(
+        rooted_wrapper_list,
         std::mem_fn(&ObjectInstance::handle_context_dispose));
 }
 
@@ -1150,11 +1440,12 @@ ObjectInstance::toggle_down(void)
          *
          * Since we cannot know how many more wrapped GObjects are going
          * be marked for garbage collection after the owner is destroyed,
-         * always queue a garbage collection when a toggle reference goes
-         * down.
+         * let the GC policy know that a toggle reference went down. It
+         * decides, together with the heap growth and memory usage, when
+         * and how to collect.
          */
         if (!gjs->destroying())
-            gjs->schedule_gc();
+            gjs->note_wrapper_toggled_down();
     }
 }
 
@@ -1201,7 +1492,7 @@ toggle_handler(GObject               *gobj,
 static void wrapped_gobj_toggle_notify(void*, GObject* gobj,
                                        gboolean is_last_ref) {
     bool is_main_thread;
-    bool toggle_up_queued, toggle_down_queued;
+    bool toggle_up_queued = false, toggle_down_queued = false;
 
     GjsContextPrivate* gjs = GjsContextPrivate::from_current_context();
     if (gjs->destroying()) {
@@ -1241,8 +1532,12 @@ static void wrapped_gobj_toggle_notify(void*, GObject* gobj,
      */
     is_main_thread = gjs->is_owner_thread();
 
+    // Only the main thread needs to know about pending toggles; other threads
+    // always enqueue
     auto& toggle_queue = ToggleQueue::get_default();
-    std::tie(toggle_down_queued, toggle_up_queued) = toggle_queue.is_queued(gobj);
+    if (is_main_thread)
+        std::tie(toggle_down_queued, toggle_up_queued) =
+            toggle_queue.is_queued(gobj);
 
     if (is_last_ref) {
         /* We've transitions from 2 -> 1 references,
@@ -1320,7 +1615,7 @@ void ObjectInstance::prepare_shutdown(void) {
      *   toggle ref removal -> gobj dispose -> toggle ref notify
      * by emptying the toggle queue earlier in the shutdown sequence. */
     ObjectInstance::remove_wrapped_gobjects_if(
-        std::mem_fn(&ObjectInstance::wrapper_is_rooted),
+        rooted_wrapper_list, std::mem_fn(&ObjectInstance::wrapper_is_rooted),
         std::mem_fn(&ObjectInstance::release_native_object));
 }
 
@@ -1328,14 +1623,29 @@ ObjectInstance::ObjectInstance(JSContext* cx, JS::HandleObject object)
     : GIWrapperInstance(cx, object),
       m_wrapper_finalized(false),
       m_gobj_disposed(false),
-      m_uses_toggle_ref(false) {
+      m_uses_toggle_ref(false),
+      m_linked(false),
+      m_in_weak_list(false),
+      m_has_closures(false) {
     GTypeQuery query;
     type_query_dynamic_safe(&query);
-    if (G_LIKELY(query.type))
+    if (G_LIKELY(query.type)) {
         JS::AddAssociatedMemory(object, query.instance_size,
                                 MemoryUse::GObjectInstanceStruct);
+        GJS_ADD_BYTES(object_instance, query.instance_size);
+    }
 
     GJS_INC_COUNTER(object_instance);
+    GJS_ADD_BYTES(object_instance, sizeof(ObjectInstance));
+}
+
+size_t ObjectInstance::native_size(void) {
+    if (!m_ptr)
+        return sizeof(ObjectInstance);
+
+    GTypeQuery query;
+    type_query_dynamic_safe(&query);
+    return sizeof(ObjectInstance) + query.instance_size;
 }
 
 ObjectPrototype::ObjectPrototype(GIObjectInfo* info, GType gtype)
@@ -1351,16 +1661,38 @@ ObjectPrototype::ObjectPrototype(GIObjectInfo* info, GType gtype)
  * Private callback, called after the JS engine finishes garbage collection, and
  * notifies when weak pointers need to be either moved or swept.
  */
-void ObjectInstance::update_heap_wrapper_weak_pointers(JSContext*,
+void ObjectInstance::update_heap_wrapper_weak_pointers(JSContext* cx,
                                                        JS::Compartment*,
                                                        void*) {
+    // Rooted wrappers are traced, so only the weak ones need to be updated or
+    // swept here
     gjs_debug_lifecycle(GJS_DEBUG_GOBJECT, "Weak pointer update callback, "
                         "%zu wrapped GObject(s) to examine",
-                        ObjectInstance::num_wrapped_gobjects());
+                        ObjectInstance::list_size(weak_wrapper_list));
+
+    int64_t begin_time = g_get_monotonic_time();
 
+    s_weak_wrappers_examined = 0;
     ObjectInstance::remove_wrapped_gobjects_if(
-        std::mem_fn(&ObjectInstance::weak_pointer_was_finalized),
+        weak_wrapper_list,
+        [](ObjectInstance* instance) {
+            s_weak_wrappers_examined++;
+            if (!instance->weak_pointer_was_finalized())
+                return false;
+            s_wrappers_collected++;
+            return true;
+        },
         std::mem_fn(&ObjectInstance::disassociate_js_gobject));
+
+    GjsProfiler* profiler = GjsContextPrivate::from_cx(cx)->profiler();
+    if (profiler && _gjs_profiler_is_running(profiler)) {
+        int64_t now = g_get_monotonic_time();
+        GjsAutoChar message = g_strdup_printf(
+            "%zu weak wrappers examined", s_weak_wrappers_examined);
+        _gjs_profiler_add_mark(profiler, begin_time * 1000L,
+                               (now - begin_time) * 1000L, "GJS",
+                               "Weak pointer sweep", message);
+    }
 }
 
 bool
@@ -1441,7 +1773,7 @@ ObjectInstance::ensure_uses_toggle_ref(JSContext *cx)
     g_object_unref(m_ptr);
 }
 
-static void invalidate_closure_list(std::forward_list<GClosure*>* closures) {
+static void invalidate_closure_list(GjsClosureSet* closures) {
     g_assert(closures);
     // Can't loop directly through the items, since invalidating an item's
     // closure might have the effect of removing the item from the list in the
@@ -1451,10 +1783,10 @@ static void invalidate_closure_list(std::forward_list<GClosure*>* closures) {
         // invalidation mechanism, but adding a temporary reference to
         // ensure that the closure is still valid when calling invalidation
         // notify callbacks
-        GjsAutoGClosure closure(closures->front(), GjsAutoTakeOwnership());
+        GjsAutoGClosure closure(*closures->begin(), GjsAutoTakeOwnership());
         g_closure_invalidate(closure);
         /* Erase element if not already erased */
-        closures->remove(closure);
+        closures->erase(closure.get());
     }
 }
 
@@ -1481,7 +1813,7 @@ ObjectInstance::disassociate_js_gobject(void)
     unset_object_qdata();
 
     /* Now release all the resources the current wrapper has */
-    invalidate_closure_list(&m_closures);
+    invalidate_closures();
     release_native_object();
 
     /* Mark that a JS object once existed, but it doesn't any more */
@@ -1610,7 +1942,9 @@ bool ObjectInstance::constructor_impl(JSContext* context,
 }
 
 void ObjectInstance::trace_impl(JSTracer* tracer) {
-    for (GClosure *closure : m_closures)
+    if (!m_has_closures)
+        return;
+    for (GClosure* closure : *closures())
         gjs_closure_trace(closure, tracer);
 }
 
@@ -1625,9 +1959,11 @@ void ObjectPrototype::trace_impl(JSTracer* tracer) {
 void ObjectInstance::finalize_impl(JSFreeOp* fop, JSObject* obj) {
     GTypeQuery query;
     type_query_dynamic_safe(&query);
-    if (G_LIKELY(query.type))
+    if (G_LIKELY(query.type)) {
         JS::RemoveAssociatedMemory(obj, query.instance_size,
                                    MemoryUse::GObjectInstanceStruct);
+        GJS_SUB_BYTES(object_instance, query.instance_size);
+    }
 
     GIWrapperInstance::finalize_impl(fop, obj);
 }
@@ -1635,7 +1971,7 @@ void ObjectInstance::finalize_impl(JSFreeOp* fop, JSObject* obj) {
 ObjectInstance::~ObjectInstance() {
     TRACE(GJS_OBJECT_WRAPPER_FINALIZE(this, m_ptr, ns(), name()));
 
-    invalidate_closure_list(&m_closures);
+    invalidate_closures();
 
     /* GObject is not already freed */
     if (m_ptr) {
@@ -1679,6 +2015,7 @@ ObjectInstance::~ObjectInstance() {
     unlink();
 
     GJS_DEC_COUNTER(object_instance);
+    GJS_SUB_BYTES(object_instance, sizeof(ObjectInstance));
 }
 
 ObjectPrototype::~ObjectPrototype() {
@@ -1791,37 +2128,134 @@ GIFieldInfo* ObjectPrototype::lookup_cached_field_info(JSContext* cx,
     gjs_debug_jsprop(GJS_DEBUG_GOBJECT,
                      "Looking up cached field info for '%s' in '%s' prototype",
                      gjs_debug_string(key).c_str(), g_type_name(m_gtype));
-    auto entry = m_field_cache.lookupForAdd(key);
+    auto entry = m_field_cache.lookup(key);
     if (entry)
         return entry->value().get();
 
+    // The field's accessors stay on the prototype when release_caches()
+    // empties the cache, so the field may be ours and need looking up again
+    JS::UniqueChars name(JS_EncodeStringToUTF8(cx, key));
+    if (!name)
+        return nullptr;
+    GjsAutoFieldInfo field_info = lookup_field_info(m_info, name.get());
+    if (field_info) {
+        GIFieldInfo* retval = field_info.get();
+        if (!m_field_cache.putNew(key, field_info.release())) {
+            JS_ReportOutOfMemory(cx);
+            return nullptr;
+        }
+        return retval;
+    }
+
     // We must be looking up a field defined on a parent. Look up the prototype
     // object via its GIObjectInfo.
     GjsAutoObjectInfo parent_info = g_object_info_get_parent(m_info);
+    if (!parent_info) {
+        gjs_throw(cx, "No field %s on %s", name.get(), type_name());
+        return nullptr;
+    }
     JS::RootedObject parent_proto(cx, gjs_lookup_object_prototype_from_info(
                                           cx, parent_info, G_TYPE_INVALID));
+    if (!parent_proto)
+        return nullptr;
     ObjectPrototype* parent = ObjectPrototype::for_js(cx, parent_proto);
     return parent->lookup_cached_field_info(cx, key);
 }
 
+/*
+ * ObjectPrototype::lookup_signal:
+ *
+ * Parses a detailed signal name, given as a JS string, for this prototype's
+ * GType. The signal is cached per name, so that code that emits or connects to
+ * the same signal repeatedly only pays for looking it up and g_signal_query()
+ * once. The detail is parsed on every call, and always interned, as by
+ * g_signal_parse_name() with force_detail_quark. Throws if there is no such
+ * signal.
+ */
+bool ObjectPrototype::lookup_signal(JSContext* cx, JS::HandleValue name,
+                                    GjsSignalLookup* lookup_out) {
+    g_assert(name.isString() && "signal name must be a string");
+
+    JS::UniqueChars signal_name = gjs_string_to_utf8(cx, name);
+    if (!signal_name)
+        return false;
+
+    const char* colon = strchr(signal_name.get(), ':');
+    std::string base_name =
+        colon ? std::string(signal_name.get(), colon - signal_name.get())
+              : std::string(signal_name.get());
+
+    auto entry = m_signal_cache.find(base_name);
+    GjsSignalLookup lookup;
+    if (entry != m_signal_cache.end()) {
+        lookup = entry->second;
+    } else {
+        // Unlike g_signal_lookup(), doesn't warn about invalid names
+        if (!g_signal_parse_name(base_name.c_str(), m_gtype, &lookup.signal_id,
+                                 &lookup.detail, false)) {
+            gjs_throw(cx, "No signal '%s' on object '%s'", signal_name.get(),
+                      g_type_name(m_gtype));
+            return false;
+        }
+        g_signal_query(lookup.signal_id, &lookup.query);
+        m_signal_cache.emplace(std::move(base_name), lookup);
+    }
+
+    // Same rules as g_signal_parse_name()
+    if (colon) {
+        if (colon[1] != ':' || colon[2] == '\0' ||
+            !(lookup.query.signal_flags & G_SIGNAL_DETAILED)) {
+            gjs_throw(cx, "No signal '%s' on object '%s'", signal_name.get(),
+                      g_type_name(m_gtype));
+            return false;
+        }
+        lookup.detail = g_quark_from_string(colon + 2);
+    }
+
+    *lookup_out = lookup;
+    return true;
+}
+
 void ObjectInstance::associate_closure(JSContext* cx, GClosure* closure) {
     if (!is_prototype())
         to_instance()->ensure_uses_toggle_ref(cx);
 
-    g_assert(std::find(m_closures.begin(), m_closures.end(), closure) ==
-                 m_closures.end() &&
-             "This closure was already associated with this object");
+    GjsClosureSet& closures = closures_by_instance[this];
+    m_has_closures = true;
 
     /* This is a weak reference, and will be cleared when the closure is
      * invalidated */
-    m_closures.push_front(closure);
+    [[maybe_unused]] bool inserted = closures.insert(closure).second;
+    g_assert(inserted &&
+             "This closure was already associated with this object");
     g_closure_add_invalidate_notifier(
         closure, this, &ObjectInstance::closure_invalidated_notify);
 }
 
 void ObjectInstance::closure_invalidated_notify(void* data, GClosure* closure) {
     auto* priv = static_cast<ObjectInstance*>(data);
-    priv->m_closures.remove(closure);
+    if (priv->m_has_closures)
+        priv->closures()->erase(closure);
+}
+
+// Returns the closures installed on this object; only call if m_has_closures is
+// set. The set stays allocated, even if it becomes empty, until
+// invalidate_closures().
+GjsClosureSet* ObjectInstance::closures(void) {
+    g_assert(m_has_closures);
+    auto it = closures_by_instance.find(this);
+    g_assert(it != closures_by_instance.end());
+    return &it->second;
+}
+
+void ObjectInstance::invalidate_closures(void) {
+    if (!m_has_closures)
+        return;
+    // References to the set stay valid even if the map is rehashed while
+    // invalidating, but iterators don't
+    invalidate_closure_list(closures());
+    closures_by_instance.erase(this);
+    m_has_closures = false;
 }
 
 bool ObjectBase::connect(JSContext* cx, unsigned argc, JS::Value* vp) {
@@ -1847,8 +2281,6 @@ ObjectInstance::connect_impl(JSContext          *context,
 {
     GClosure *closure;
     gulong id;
-    guint signal_id;
-    GQuark signal_detail;
 
     gjs_debug_gsignal("connect obj %p priv %p", m_wrapper.get(), this);
 
@@ -1867,20 +2299,17 @@ ObjectInstance::connect_impl(JSContext          *context,
         return false;
     }
 
-    if (!g_signal_parse_name(signal_name.get(), gtype(), &signal_id,
-                             &signal_detail, true)) {
-        gjs_throw(context, "No signal '%s' on object '%s'",
-                  signal_name.get(), type_name());
+    GjsSignalLookup signal;
+    if (!get_prototype()->lookup_signal(context, args[0], &signal))
         return false;
-    }
 
-    closure = gjs_closure_new_for_signal(
-        context, JS_GetObjectFunction(callback), "signal callback", signal_id);
+    closure = gjs_closure_new_for_signal(context, JS_GetObjectFunction(callback),
+                                         "signal callback", signal.signal_id);
     if (closure == NULL)
         return false;
     associate_closure(context, closure);
 
-    id = g_signal_connect_closure_by_id(m_ptr, signal_id, signal_detail,
+    id = g_signal_connect_closure_by_id(m_ptr, signal.signal_id, signal.detail,
                                         closure, after);
 
     args.rval().setDouble(id);
@@ -1900,9 +2329,6 @@ bool
 ObjectInstance::emit_impl(JSContext          *context,
                           const JS::CallArgs& argv)
 {
-    guint signal_id;
-    GQuark signal_detail;
-    GSignalQuery signal_query;
     GValue rvalue = G_VALUE_INIT;
     unsigned int i;
     bool failed;
@@ -1913,21 +2339,25 @@ ObjectInstance::emit_impl(JSContext          *context,
     if (!check_gobject_disposed("emit any signal on"))
         return true;
 
-    JS::UniqueChars signal_name;
-    if (!gjs_parse_call_args(context, "emit", argv, "!s",
-                             "signal name", &signal_name))
-        return false;
+    if (argv.length() == 0 || !argv[0].isString()) {
+        // Not the fast path; let the argument parser throw a suitable error
+        JS::UniqueChars signal_name;
+        if (!gjs_parse_call_args(context, "emit", argv, "!s",
+                                 "signal name", &signal_name))
+            return false;
+    }
 
-    if (!g_signal_parse_name(signal_name.get(), gtype(), &signal_id,
-                             &signal_detail, false)) {
-        gjs_throw(context, "No signal '%s' on object '%s'",
-                  signal_name.get(), type_name());
+    GjsSignalLookup signal;
+    if (!get_prototype()->lookup_signal(context, argv[0], &signal))
         return false;
-    }
 
-    g_signal_query(signal_id, &signal_query);
+    const GSignalQuery& signal_query = signal.query;
 
     if ((argv.length() - 1) != signal_query.n_params) {
+        JS::RootedString str(context, argv[0].toString());
+        JS::UniqueChars signal_name(JS_EncodeStringToUTF8(context, str));
+        if (!signal_name)
+            return false;
         gjs_throw(context, "Signal '%s' on %s requires %d args got %d",
                   signal_name.get(), type_name(), signal_query.n_params,
                   argv.length() - 1);
@@ -1938,17 +2368,29 @@ ObjectInstance::emit_impl(JSContext          *context,
         g_value_init(&rvalue, signal_query.return_type & ~G_SIGNAL_TYPE_STATIC_SCOPE);
     }
 
-    GjsAutoPointer<GValue> instance_and_args =
-        g_new0(GValue, signal_query.n_params + 1);
+    // Most signals have few enough parameters that they fit on the stack
+    unsigned n_values = signal_query.n_params + 1;
+    GValue inline_values[MAX_INLINE_SIGNAL_ARGS + 1];
+    GjsAutoPointer<GValue> heap_values;
+    GValue* instance_and_args = inline_values;
+    if (n_values > G_N_ELEMENTS(inline_values)) {
+        heap_values = g_new0(GValue, n_values);
+        instance_and_args = heap_values;
+    } else {
+        memset(inline_values, 0, n_values * sizeof(GValue));
+    }
+
     g_value_init(&instance_and_args[0], gtype());
     g_value_set_instance(&instance_and_args[0], m_ptr);
 
+    unsigned n_initialized = 1;
     failed = false;
     for (i = 0; i < signal_query.n_params; ++i) {
         GValue *value;
         value = &instance_and_args[i + 1];
 
         g_value_init(value, signal_query.param_types[i] & ~G_SIGNAL_TYPE_STATIC_SCOPE);
+        n_initialized++;
         if ((signal_query.param_types[i] & G_SIGNAL_TYPE_STATIC_SCOPE) != 0)
             failed = !gjs_value_to_g_value_no_copy(context, argv[i + 1], value);
         else
@@ -1959,7 +2401,7 @@ ObjectInstance::emit_impl(JSContext          *context,
     }
 
     if (!failed) {
-        g_signal_emitv(instance_and_args, signal_id, signal_detail,
+        g_signal_emitv(instance_and_args, signal.signal_id, signal.detail,
                        &rvalue);
     }
 
@@ -1972,13 +2414,224 @@ ObjectInstance::emit_impl(JSContext          *context,
         argv.rval().setUndefined();
     }
 
-    for (i = 0; i < (signal_query.n_params + 1); ++i) {
+    for (i = 0; i < n_initialized; ++i) {
         g_value_unset(&instance_and_args[i]);
     }
 
     return !failed;
 }
 
+bool ObjectBase::set_properties(JSContext* cx, unsigned argc, JS::Value* vp) {
+    GJS_GET_WRAPPER_PRIV(cx, argc, vp, args, obj, ObjectBase, priv);
+    if (!priv->check_is_instance(cx, "set properties"))
+        return false;
+
+    return priv->to_instance()->set_properties_impl(cx, args);
+}
+
+/*
+ * ObjectInstance::set_properties_impl:
+ *
+ * Replacement for the non-introspectable g_object_set(). Converts all the
+ * GObject properties in the given object to GValues in one pass and then sets
+ * them with one call to g_object_setv(), with property notifications frozen
+ * for the duration of the call. Any other keys, such as properties implemented
+ * in JS, are set on the JS object as they would be by Object.assign().
+ */
+bool ObjectInstance::set_properties_impl(JSContext* cx,
+                                         const JS::CallArgs& args) {
+    JS::RootedObject props(cx);
+    if (!gjs_parse_call_args(cx, "set", args, "o", "properties", &props))
+        return false;
+
+    args.rval().setUndefined();
+
+    if (!check_gobject_disposed("set any property on"))
+        return true;
+
+    JS::Rooted<JS::IdVector> ids(cx, cx);
+    if (!JS_Enumerate(cx, props, &ids))
+        return false;
+
+    std::vector<const char*> names;
+    AutoGValueVector values;
+    JS::RootedIdVector other_ids(cx);
+    names.reserve(ids.length());
+    values.reserve(ids.length());
+
+    ObjectPrototype* proto_priv = get_prototype();
+    JS::RootedId prop_id(cx);
+    JS::RootedString prop_name(cx);
+    JS::RootedValue value(cx);
+    for (size_t ix = 0; ix < ids.length(); ix++) {
+        prop_id = ids[ix];
+
+        GParamSpec* param_spec = nullptr;
+        if (JSID_IS_STRING(prop_id)) {
+            prop_name = JSID_TO_STRING(prop_id);
+            if (!proto_priv->lookup_param_spec(cx, prop_name, &param_spec))
+                return false;
+        }
+
+        // Leave JS overridden properties, and read-only properties which
+        // should throw, to the property setter
+        if (!param_spec ||
+            g_param_spec_get_qdata(param_spec,
+                                   ObjectBase::custom_property_quark()) ||
+            !(param_spec->flags & G_PARAM_WRITABLE)) {
+            if (!other_ids.append(prop_id)) {
+                JS_ReportOutOfMemory(cx);
+                return false;
+            }
+            continue;
+        }
+
+        if (param_spec->flags & G_PARAM_DEPRECATED)
+            _gjs_warn_deprecated_once_per_callsite(cx,
+                                                   DeprecatedGObjectProperty);
+
+        if (!JS_GetPropertyById(cx, props, prop_id, &value))
+            return false;
+
+        GValue gvalue = G_VALUE_INIT;
+        g_value_init(&gvalue, G_PARAM_SPEC_VALUE_TYPE(param_spec));
+        if (!gjs_value_to_g_value(cx, value, &gvalue)) {
+            g_value_unset(&gvalue);
+            return false;
+        }
+
+        names.push_back(param_spec->name);  /* owned by GParamSpec in cache */
+        values.push_back(gvalue);
+    }
+
+    gjs_debug_jsprop(GJS_DEBUG_GOBJECT, "Setting %zu GObject props at once",
+                     values.size());
+
+    g_object_freeze_notify(m_ptr);
+    g_object_setv(m_ptr, values.size(), names.data(), values.data());
+
+    bool ok = true;
+    JS::RootedObject wrapper(cx, m_wrapper);
+    for (size_t ix = 0; ix < other_ids.length(); ix++) {
+        prop_id = other_ids[ix];
+        if (!JS_GetPropertyById(cx, props, prop_id, &value) ||
+            !JS_SetPropertyById(cx, wrapper, prop_id, value)) {
+            ok = false;
+            break;
+        }
+    }
+    g_object_thaw_notify(m_ptr);
+
+    return ok;
+}
+
+bool ObjectBase::get_properties(JSContext* cx, unsigned argc, JS::Value* vp) {
+    GJS_GET_WRAPPER_PRIV(cx, argc, vp, args, obj, ObjectBase, priv);
+    if (!priv->check_is_instance(cx, "get properties"))
+        return false;
+
+    return priv->to_instance()->get_properties_impl(cx, args);
+}
+
+/*
+ * ObjectInstance::get_properties_impl:
+ *
+ * Replacement for the non-introspectable g_object_get(). Takes an array of
+ * property names and returns an array of their values in the same order,
+ * fetching all the GObject properties with one call to g_object_getv().
+ */
+bool ObjectInstance::get_properties_impl(JSContext* cx,
+                                         const JS::CallArgs& args) {
+    JS::RootedObject names_array(cx);
+    if (!gjs_parse_call_args(cx, "get", args, "o", "property names",
+                             &names_array))
+        return false;
+
+    bool is_array;
+    if (!JS::IsArrayObject(cx, names_array, &is_array))
+        return false;
+    if (!is_array) {
+        gjs_throw(cx, "Argument to get() should be an array of property names");
+        return false;
+    }
+
+    uint32_t length;
+    if (!JS::GetArrayLength(cx, names_array, &length))
+        return false;
+
+    JS::RootedValueVector result(cx);
+    if (!result.resize(length)) {
+        JS_ReportOutOfMemory(cx);
+        return false;
+    }
+
+    if (!check_gobject_disposed("get any property from")) {
+        JSObject* array = JS::NewArrayObject(cx, result);
+        if (!array)
+            return false;
+        args.rval().setObject(*array);
+        return true;
+    }
+
+    std::vector<const char*> names;
+    std::vector<uint32_t> gobject_indices;
+    names.reserve(length);
+    gobject_indices.reserve(length);
+
+    ObjectPrototype* proto_priv = get_prototype();
+    JS::RootedObject wrapper(cx, m_wrapper);
+    JS::RootedValue elem(cx);
+    JS::RootedString prop_name(cx);
+    JS::RootedId prop_id(cx);
+    for (uint32_t ix = 0; ix < length; ix++) {
+        if (!JS_GetElement(cx, names_array, ix, &elem))
+            return false;
+        if (!elem.isString()) {
+            gjs_throw(cx, "Property name at index %u should be a string", ix);
+            return false;
+        }
+
+        prop_name = elem.toString();
+        GParamSpec* param_spec =
+            proto_priv->find_param_spec_from_id(cx, prop_name);
+        if (!param_spec)
+            return false;
+
+        // Do not fetch JS overridden properties from GObject, to avoid
+        // infinite recursion
+        if (g_param_spec_get_qdata(param_spec,
+                                   ObjectBase::custom_property_quark())) {
+            if (!JS_StringToId(cx, prop_name, &prop_id) ||
+                !JS_GetPropertyById(cx, wrapper, prop_id, result[ix]))
+                return false;
+            continue;
+        }
+
+        // Unreadable properties read as undefined
+        if (!(param_spec->flags & G_PARAM_READABLE))
+            continue;
+
+        names.push_back(param_spec->name);  /* owned by GParamSpec in cache */
+        gobject_indices.push_back(ix);
+    }
+
+    AutoGValueVector values;
+    values.resize(names.size());  // zero-initialized, as getv requires
+    g_object_getv(m_ptr, names.size(), names.data(), values.data());
+
+    for (size_t ix = 0; ix < values.size(); ix++) {
+        if (!gjs_value_from_g_value(cx, result[gobject_indices[ix]],
+                                    &values[ix]))
+            return false;
+    }
+
+    JSObject* array = JS::NewArrayObject(cx, result);
+    if (!array)
+        return false;
+    args.rval().setObject(*array);
+    return true;
+}
+
 bool ObjectInstance::signal_match_arguments_from_object(
     JSContext* cx, JS::HandleObject match_obj, GSignalMatchType* mask_out,
     unsigned* signal_id_out, GQuark* detail_out,
@@ -2090,8 +2743,8 @@ bool ObjectInstance::signal_find_impl(JSContext* cx, const JS::CallArgs& args) {
     if (!func) {
         handler = g_signal_handler_find(m_ptr, mask, signal_id, detail, nullptr,
                                         nullptr, nullptr);
-    } else {
-        for (GClosure* candidate : m_closures) {
+    } else if (m_has_closures) {
+        for (GClosure* candidate : *closures()) {
             if (gjs_closure_get_callable(candidate) == func) {
                 handler = g_signal_handler_find(m_ptr, mask, signal_id, detail,
                                                 candidate, nullptr, nullptr);
@@ -2164,9 +2817,9 @@ bool ObjectInstance::signals_action_impl(JSContext* cx,
     if (!func) {
         n_matched = MatchFunc(m_ptr, mask, signal_id, detail, nullptr, nullptr,
                               nullptr);
-    } else {
+    } else if (m_has_closures) {
         std::vector<GClosure*> candidates;
-        for (GClosure* candidate : m_closures) {
+        for (GClosure* candidate : *closures()) {
             if (gjs_closure_get_callable(candidate) == func)
                 candidates.push_back(candidate);
         }
@@ -2244,6 +2897,8 @@ JSFunctionSpec ObjectBase::proto_methods[] = {
     JS_FN("connect", &ObjectBase::connect, 0, 0),
     JS_FN("connect_after", &ObjectBase::connect_after, 0, 0),
     JS_FN("emit", &ObjectBase::emit, 0, 0),
+    JS_FN("set", &ObjectBase::set_properties, 1, 0),
+    JS_FN("get", &ObjectBase::get_properties, 1, 0),
     JS_FS_END
 };
 
@@ -2608,10 +3263,10 @@ bool ObjectPrototype::hook_up_vfunc_impl(JSContext* cx,
 
         // This is traced, and will be cleared from the list when the closure is
         // invalidated
-        g_assert(std::find(m_vfuncs.begin(), m_vfuncs.end(),
-                           trampoline->js_function()) == m_vfuncs.end() &&
+        [[maybe_unused]] bool inserted =
+            m_vfuncs.insert(trampoline->js_function()).second;
+        g_assert(inserted &&
                  "This vfunc was already associated with this class");
-        m_vfuncs.push_front(trampoline->js_function());
         g_closure_add_invalidate_notifier(
             trampoline->js_function(), this,
             &ObjectPrototype::vfunc_invalidated_notify);
@@ -2629,7 +3284,7 @@ bool ObjectPrototype::hook_up_vfunc_impl(JSContext* cx,
 
 void ObjectPrototype::vfunc_invalidated_notify(void* data, GClosure* closure) {
     auto* priv = static_cast<ObjectPrototype*>(data);
-    priv->m_vfuncs.remove(closure);
+    priv->m_vfuncs.erase(closure);
 }
 
 bool
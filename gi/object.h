@@ -9,8 +9,10 @@
 
 #include <stddef.h>  // for size_t
 
-#include <forward_list>
 #include <functional>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 #include <girepository.h>
@@ -58,6 +60,10 @@ class GjsListLink {
     [[nodiscard]] size_t size() const;
 };
 
+// Objects such as a settings proxy can end up with thousands of closures
+// installed, so adding and removing one should not depend on how many there are
+using GjsClosureSet = std::unordered_set<GClosure*>;
+
 struct AutoGValueVector : public std::vector<GValue> {
     ~AutoGValueVector() {
         for (GValue value : *this)
@@ -143,12 +149,18 @@ class ObjectBase
     /* JS property getters/setters */
 
  public:
-    GJS_JSAPI_RETURN_CONVENTION
-    static bool prop_getter(JSContext* cx, unsigned argc, JS::Value* vp);
+    // The TYPE parameter selects an accessor specialized for properties whose
+    // value has that fundamental type; G_TYPE_INVALID selects the generic one
+    template <GType TYPE = G_TYPE_INVALID>
+    GJS_JSAPI_RETURN_CONVENTION static bool prop_getter(JSContext* cx,
+                                                        unsigned argc,
+                                                        JS::Value* vp);
     GJS_JSAPI_RETURN_CONVENTION
     static bool field_getter(JSContext* cx, unsigned argc, JS::Value* vp);
-    GJS_JSAPI_RETURN_CONVENTION
-    static bool prop_setter(JSContext* cx, unsigned argc, JS::Value* vp);
+    template <GType TYPE = G_TYPE_INVALID>
+    GJS_JSAPI_RETURN_CONVENTION static bool prop_setter(JSContext* cx,
+                                                        unsigned argc,
+                                                        JS::Value* vp);
     GJS_JSAPI_RETURN_CONVENTION
     static bool field_setter(JSContext* cx, unsigned argc, JS::Value* vp);
 
@@ -161,6 +173,10 @@ class ObjectBase
     GJS_JSAPI_RETURN_CONVENTION
     static bool emit(JSContext* cx, unsigned argc, JS::Value* vp);
     GJS_JSAPI_RETURN_CONVENTION
+    static bool set_properties(JSContext* cx, unsigned argc, JS::Value* vp);
+    GJS_JSAPI_RETURN_CONVENTION
+    static bool get_properties(JSContext* cx, unsigned argc, JS::Value* vp);
+    GJS_JSAPI_RETURN_CONVENTION
     static bool signal_find(JSContext* cx, unsigned argc, JS::Value* vp);
     template <SignalMatchFunc(*MATCH_FUNC)>
     GJS_JSAPI_RETURN_CONVENTION static bool signals_action(JSContext* cx,
@@ -192,6 +208,15 @@ struct IdHasher {
     static bool match(jsid id1, jsid id2) { return id1 == id2; }
 };
 
+// Result of parsing a detailed signal name such as "notify::name". The signal
+// is cached on the prototype by its name without the detail, so that emitting
+// or connecting doesn't have to look it up again.
+struct GjsSignalLookup {
+    unsigned signal_id;
+    GQuark detail;
+    GSignalQuery query;
+};
+
 class ObjectPrototype
     : public GIWrapperPrototype<ObjectBase, ObjectPrototype, ObjectInstance> {
     friend class GIWrapperPrototype<ObjectBase, ObjectPrototype,
@@ -206,12 +231,16 @@ class ObjectPrototype
                       js::DefaultHasher<JSString*>, js::SystemAllocPolicy>;
     using NegativeLookupCache =
         JS::GCHashSet<JS::Heap<jsid>, IdHasher, js::SystemAllocPolicy>;
+    // Keyed by signal name without the detail; details are unbounded, since
+    // programs can build them at run time
+    using SignalCache = std::unordered_map<std::string, GjsSignalLookup>;
 
     PropertyCache m_property_cache;
     FieldCache m_field_cache;
     NegativeLookupCache m_unresolvable_cache;
-    // a list of vfunc GClosures installed on this prototype, used when tracing
-    std::forward_list<GClosure*> m_vfuncs;
+    SignalCache m_signal_cache;
+    // the vfunc GClosures installed on this prototype, used when tracing
+    GjsClosureSet m_vfuncs;
 
     ObjectPrototype(GIObjectInfo* info, GType gtype);
     ~ObjectPrototype();
@@ -246,10 +275,16 @@ class ObjectPrototype
  public:
     void set_type_qdata(void);
     GJS_JSAPI_RETURN_CONVENTION
+    bool lookup_param_spec(JSContext* cx, JS::HandleString key,
+                           GParamSpec** pspec_out);
+    GJS_JSAPI_RETURN_CONVENTION
     GParamSpec* find_param_spec_from_id(JSContext* cx, JS::HandleString key);
     GJS_JSAPI_RETURN_CONVENTION
     GIFieldInfo* lookup_cached_field_info(JSContext* cx, JS::HandleString key);
     GJS_JSAPI_RETURN_CONVENTION
+    bool lookup_signal(JSContext* cx, JS::HandleValue name,
+                       GjsSignalLookup* lookup_out);
+    GJS_JSAPI_RETURN_CONVENTION
     bool props_to_g_parameters(JSContext* cx, JS::HandleObject props,
                                std::vector<const char*>* names,
                                AutoGValueVector* values);
@@ -260,6 +295,11 @@ class ObjectPrototype
                              JS::MutableHandleObject constructor,
                              JS::MutableHandleObject prototype);
 
+    size_t release_caches(void);
+    static size_t release_all_caches(void);
+    [[nodiscard]] size_t caches_size(void) const;
+    [[nodiscard]] static size_t all_caches_size(void);
+
     void ref_vfuncs(void) {
         for (GClosure* closure : m_vfuncs)
             g_closure_ref(closure);
@@ -297,9 +337,6 @@ class ObjectInstance : public GIWrapperInstance<ObjectBase, ObjectPrototype,
     // GIWrapperInstance::m_ptr may be null in ObjectInstance.
 
     GjsMaybeOwned<JSObject*> m_wrapper;
-    // a list of all GClosures installed on this object (from signal connections
-    // and scope-notify callbacks passed to methods), used when tracing
-    std::forward_list<GClosure*> m_closures;
     GjsListLink m_instance_link;
 
     bool m_wrapper_finalized : 1;
@@ -310,7 +347,16 @@ class ObjectInstance : public GIWrapperInstance<ObjectBase, ObjectPrototype,
      * hard ref on the underlying GObject, and may be finalized at will. */
     bool m_uses_toggle_ref : 1;
 
+    // Which of the lists of instances this one is in, if any; see link()
+    bool m_linked : 1;
+    bool m_in_weak_list : 1;
+
+    // Whether any GClosures are installed on this object; see closures()
+    bool m_has_closures : 1;
+
     static bool s_weak_pointer_callback;
+    static size_t s_weak_wrappers_examined;
+    static size_t s_wrappers_collected;
 
     /* Constructors */
 
@@ -333,13 +379,21 @@ class ObjectInstance : public GIWrapperInstance<ObjectBase, ObjectPrototype,
 
  public:
     [[nodiscard]] JSObject* wrapper() const { return m_wrapper; }
+    // C memory owned by this wrapper, in bytes; used in heap snapshots
+    [[nodiscard]] size_t native_size(void);
 
     /* Methods to manipulate the JS object wrapper */
 
  private:
     void discard_wrapper(void) { m_wrapper.reset(); }
-    void switch_to_rooted(JSContext* cx) { m_wrapper.switch_to_rooted(cx); }
-    void switch_to_unrooted(JSContext* cx) { m_wrapper.switch_to_unrooted(cx); }
+    void switch_to_rooted(JSContext* cx) {
+        m_wrapper.switch_to_rooted(cx);
+        relink();
+    }
+    void switch_to_unrooted(JSContext* cx) {
+        m_wrapper.switch_to_unrooted(cx);
+        relink();
+    }
     [[nodiscard]] bool update_after_gc() { return m_wrapper.update_after_gc(); }
     [[nodiscard]] bool wrapper_is_rooted() const { return m_wrapper.rooted(); }
     void release_native_object(void);
@@ -364,6 +418,8 @@ class ObjectInstance : public GIWrapperInstance<ObjectBase, ObjectPrototype,
 
  private:
     static void closure_invalidated_notify(void* data, GClosure* closure);
+    [[nodiscard]] GjsClosureSet* closures(void);
+    void invalidate_closures(void);
 
  public:
     void associate_closure(JSContext* cx, GClosure* closure);
@@ -393,29 +449,50 @@ class ObjectInstance : public GIWrapperInstance<ObjectBase, ObjectPrototype,
     bool init_custom_class_from_gobject(JSContext* cx, JS::HandleObject wrapper,
                                         GObject* gobj);
 
-    /* Methods to manipulate the linked list of instances */
+    /* Methods to manipulate the linked lists of instances. Instances with a
+     * rooted wrapper are in one list, and instances with a weak (unrooted)
+     * wrapper in the other, so that the weak pointer callback after each GC
+     * only has to look at the weak ones. */
 
  private:
-    static ObjectInstance* wrapped_gobject_list;
+    static ObjectInstance* rooted_wrapper_list;
+    static ObjectInstance* weak_wrapper_list;
     [[nodiscard]] ObjectInstance* next() const {
         return m_instance_link.next();
     }
     void link(void);
     void unlink(void);
-    [[nodiscard]] static size_t num_wrapped_gobjects() {
-        return wrapped_gobject_list
-                   ? wrapped_gobject_list->m_instance_link.size()
-                   : 0;
+    void relink(void) {
+        if (m_linked && m_in_weak_list == wrapper_is_rooted()) {
+            unlink();
+            link();
+        }
+    }
+    [[nodiscard]] static size_t list_size(ObjectInstance* head) {
+        return head ? head->m_instance_link.size() : 0;
     }
     using Action = std::function<void(ObjectInstance*)>;
     using Predicate = std::function<bool(ObjectInstance*)>;
-    static void iterate_wrapped_gobjects(const Action& action);
-    static void remove_wrapped_gobjects_if(const Predicate& predicate,
+    static void iterate_wrapped_gobjects(ObjectInstance* head,
+                                         const Action& action);
+    static void remove_wrapped_gobjects_if(ObjectInstance* head,
+                                           const Predicate& predicate,
                                            const Action& action);
 
  public:
     [[nodiscard]] GjsListLink* get_link() { return &m_instance_link; }
     static void prepare_shutdown(void);
+    // Number of weak wrappers examined by the weak pointer callback during the
+    // most recent GC; see System.memoryReport()
+    [[nodiscard]] static size_t num_weak_wrappers_examined() {
+        return s_weak_wrappers_examined;
+    }
+    // Number of wrappers whose JS object was collected since the previous call
+    [[nodiscard]] static size_t take_num_wrappers_collected() {
+        size_t retval = s_wrappers_collected;
+        s_wrappers_collected = 0;
+        return retval;
+    }
 
     /* JSClass operations */
 
@@ -429,15 +506,16 @@ class ObjectInstance : public GIWrapperInstance<ObjectBase, ObjectPrototype,
     /* JS property getters/setters */
 
  private:
-    GJS_JSAPI_RETURN_CONVENTION
-    bool prop_getter_impl(JSContext* cx, JS::HandleString name,
-                          JS::MutableHandleValue rval);
+    template <GType TYPE>
+    GJS_JSAPI_RETURN_CONVENTION bool prop_getter_impl(
+        JSContext* cx, JS::HandleString name, JS::MutableHandleValue rval);
     GJS_JSAPI_RETURN_CONVENTION
     bool field_getter_impl(JSContext* cx, JS::HandleString name,
                            JS::MutableHandleValue rval);
-    GJS_JSAPI_RETURN_CONVENTION
-    bool prop_setter_impl(JSContext* cx, JS::HandleString name,
-                          JS::HandleValue value);
+    template <GType TYPE>
+    GJS_JSAPI_RETURN_CONVENTION bool prop_setter_impl(JSContext* cx,
+                                                      JS::HandleString name,
+                                                      JS::HandleValue value);
     GJS_JSAPI_RETURN_CONVENTION
     bool field_setter_not_impl(JSContext* cx, JS::HandleString name);
 
@@ -450,11 +528,18 @@ class ObjectInstance : public GIWrapperInstance<ObjectBase, ObjectPrototype,
     /* JS methods */
 
  private:
+    // Signals with up to this many parameters are emitted without allocating
+    static constexpr unsigned MAX_INLINE_SIGNAL_ARGS = 8;
+
     GJS_JSAPI_RETURN_CONVENTION
     bool connect_impl(JSContext* cx, const JS::CallArgs& args, bool after);
     GJS_JSAPI_RETURN_CONVENTION
     bool emit_impl(JSContext* cx, const JS::CallArgs& args);
     GJS_JSAPI_RETURN_CONVENTION
+    bool set_properties_impl(JSContext* cx, const JS::CallArgs& args);
+    GJS_JSAPI_RETURN_CONVENTION
+    bool get_properties_impl(JSContext* cx, const JS::CallArgs& args);
+    GJS_JSAPI_RETURN_CONVENTION
     bool signal_find_impl(JSContext* cx, const JS::CallArgs& args);
     template <SignalMatchFunc(*MATCH_FUNC)>
     GJS_JSAPI_RETURN_CONVENTION bool signals_action_impl(
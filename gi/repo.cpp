@@ -15,6 +15,8 @@
 #include <glib-object.h>
 #include <glib.h>
 
+#include <js/Array.h>  // for IsArrayObject, GetArrayLength
+#include <js/CharacterEncoding.h>
 #include <js/Class.h>
 #include <js/ComparisonOperators.h>
 #include <js/Id.h>                  // for JSID_IS_STRING, JSID_VOID
@@ -42,6 +44,7 @@
 #include "gjs/atoms.h"
 #include "gjs/context-private.h"
 #include "gjs/global.h"
+#include "gjs/import-path-cache.h"
 #include "gjs/jsapi-util.h"
 #include "gjs/module.h"
 #include "util/log.h"
@@ -511,6 +514,78 @@ out:
     return retval;
 }
 
+/* Whether the overrides importer might have a module for @ns_name. Most
+ * namespaces have no overrides, and finding that out by importing costs a
+ * search of the path and a thrown ImportError; instead, each directory in the
+ * path is listed once, and looked up in the import path cache. */
+GJS_JSAPI_RETURN_CONVENTION
+static bool override_may_exist(JSContext* cx, JS::HandleObject overridespkg,
+                               JS::HandleId ns_name, bool* may_exist) {
+    *may_exist = true;
+
+    bool found;
+    if (!JS_AlreadyHasOwnPropertyById(cx, overridespkg, ns_name, &found))
+        return false;
+    if (found)
+        return true;  // already imported
+
+    /* Anything unexpected is left to the importer to complain about */
+    const GjsAtoms& atoms = GjsContextPrivate::atoms(cx);
+    JS::RootedValue v_search_path(cx);
+    if (!JS_GetPropertyById(cx, overridespkg, atoms.search_path(),
+                            &v_search_path))
+        return false;
+    if (!v_search_path.isObject())
+        return true;
+
+    JS::RootedObject search_path(cx, &v_search_path.toObject());
+    bool is_array;
+    uint32_t search_path_len;
+    if (!JS::IsArrayObject(cx, search_path, &is_array))
+        return false;
+    if (!is_array)
+        return true;
+    if (!JS::GetArrayLength(cx, search_path, &search_path_len))
+        return false;
+
+    JS::UniqueChars name;
+    if (!gjs_get_string_id(cx, ns_name, &name))
+        return false;
+    if (!name)
+        return true;
+    GjsAutoChar filename = g_strconcat(name.get(), ".js", nullptr);
+
+    GjsImportPathCache& path_cache =
+        GjsContextPrivate::from_cx(cx)->import_path_cache();
+    JS::RootedValue elem(cx);
+    JS::RootedString str(cx);
+    for (uint32_t ix = 0; ix < search_path_len; ix++) {
+        if (!JS_GetElement(cx, search_path, ix, &elem))
+            return false;
+        if (elem.isUndefined())
+            continue;
+        if (!elem.isString())
+            return true;
+
+        str = elem.toString();
+        JS::UniqueChars dirname(JS_EncodeStringToUTF8(cx, str));
+        if (!dirname)
+            return false;
+        if (dirname[0] == '\0')
+            continue;
+
+        path_cache.enumerate(dirname.get());
+        /* An __init__.js could define the override as well */
+        if (path_cache.exists(dirname.get(), filename) ||
+            path_cache.exists(dirname.get(), name.get()) ||
+            path_cache.exists(dirname.get(), "__init__.js"))
+            return true;
+    }
+
+    *may_exist = false;
+    return true;
+}
+
 GJS_JSAPI_RETURN_CONVENTION
 static bool
 lookup_override_function(JSContext             *cx,
@@ -527,10 +602,18 @@ lookup_override_function(JSContext             *cx,
     JS::RootedObject overridespkg(cx), module(cx);
     JS::RootedObject importer_obj(cx, &importer.toObject());
     const GjsAtoms& atoms = GjsContextPrivate::atoms(cx);
+    bool may_exist;
     if (!gjs_object_require_property(cx, importer_obj, "importer",
-                                     atoms.overrides(), &overridespkg))
+                                     atoms.overrides(), &overridespkg) ||
+        !override_may_exist(cx, overridespkg, ns_name, &may_exist))
         goto fail;
 
+    if (!may_exist) {
+        gjs_debug(GJS_DEBUG_GNAMESPACE, "No overrides for namespace '%s'",
+                  gjs_debug_id(ns_name).c_str());
+        return true;
+    }
+
     if (!gjs_object_require_property(cx, overridespkg,
                                      "GI repository object", ns_name,
                                      &module)) {
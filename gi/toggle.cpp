@@ -4,9 +4,7 @@
 // SPDX-FileContributor: Authored by: Philip Chimento <philip@endlessm.com>
 // SPDX-FileContributor: Philip Chimento <philip.chimento@gmail.com>
 
-#include <algorithm>  // for find_if
-#include <deque>
-#include <mutex>
+#include <atomic>
 #include <utility>  // for pair
 
 #include <glib-object.h>
@@ -14,60 +12,89 @@
 
 #include "gi/toggle.h"
 
-std::deque<ToggleQueue::Item>::iterator
-ToggleQueue::find_operation_locked(const GObject               *gobj,
-                                   ToggleQueue::Direction direction) {
-    return std::find_if(q.begin(), q.end(),
-        [gobj, direction](const Item& item)->bool {
-            return item.gobj == gobj && item.direction == direction;
-        });
+ToggleQueue::ToggleQueue() : m_head(&m_stub), m_tail(&m_stub) {}
+
+GQuark ToggleQueue::item_quark(ToggleQueue::Direction direction) {
+    static GQuark down_quark =
+        g_quark_from_static_string("gjs::toggle-down-item");
+    static GQuark up_quark = g_quark_from_static_string("gjs::toggle-up-item");
+    return direction == UP ? up_quark : down_quark;
 }
 
-std::deque<ToggleQueue::Item>::const_iterator
-ToggleQueue::find_operation_locked(const GObject *gobj,
-                                   ToggleQueue::Direction direction) const {
-    return std::find_if(q.begin(), q.end(),
-        [gobj, direction](const Item& item)->bool {
-            return item.gobj == gobj && item.direction == direction;
-        });
+// Called from any thread
+void ToggleQueue::push(Item* item) {
+    item->next.store(nullptr, std::memory_order_relaxed);
+    Item* prev = m_head.exchange(item, std::memory_order_acq_rel);
+    // Between the exchange and this store, the consumer can't see past prev
+    prev->next.store(item, std::memory_order_release);
 }
 
-bool
-ToggleQueue::find_and_erase_operation_locked(const GObject               *gobj,
-                                             ToggleQueue::Direction direction)
-{
-    auto pos = find_operation_locked(gobj, direction);
-    bool had_toggle = (pos != q.end());
-    if (had_toggle)
-        q.erase(pos);
-    return had_toggle;
+// Called from the main thread only. Returns nullptr if the queue is empty, or
+// if the only remaining item is still in the middle of being pushed; in that
+// case the producer will schedule another idle after it's done.
+ToggleQueue::Item* ToggleQueue::pop(void) {
+    Item* tail = m_tail;
+    Item* next = tail->next.load(std::memory_order_acquire);
+
+    if (tail == &m_stub) {
+        if (!next)
+            return nullptr;
+        m_tail = next;
+        tail = next;
+        next = next->next.load(std::memory_order_acquire);
+    }
+
+    if (next) {
+        m_tail = next;
+        return tail;
+    }
+
+    if (tail != m_head.load(std::memory_order_acquire))
+        return nullptr;
+
+    // tail is the last item; put the stub back behind it so we can take it
+    push(&m_stub);
+    next = tail->next.load(std::memory_order_acquire);
+    if (next) {
+        m_tail = next;
+        return tail;
+    }
+    return nullptr;
+}
+
+bool ToggleQueue::cancel_operation(GObject* gobj,
+                                   ToggleQueue::Direction direction) {
+    auto* item =
+        static_cast<Item*>(g_object_steal_qdata(gobj, item_quark(direction)));
+    if (!item)
+        return false;
+
+    // The item is freed when it reaches the front of the queue
+    item->cancelled = true;
+    return true;
 }
 
 gboolean
 ToggleQueue::idle_handle_toggle(void *data)
 {
     auto self = static_cast<ToggleQueue *>(data);
-    while (self->handle_toggle(self->m_toggle_handler))
+
+    // Reset this first, so that any toggle enqueued from now on schedules
+    // another idle, even if it arrives too late to be handled in this batch
+    self->m_idle_queued = false;
+
+    Handler handler = self->m_toggle_handler;
+    while (self->handle_toggle(handler))
         ;
 
     return G_SOURCE_REMOVE;
 }
 
-void
-ToggleQueue::idle_destroy_notify(void *data)
-{
-    auto self = static_cast<ToggleQueue *>(data);
-    std::lock_guard<std::mutex> hold(self->lock);
-    self->m_idle_id = 0;
-    self->m_toggle_handler = nullptr;
-}
-
 std::pair<bool, bool>
 ToggleQueue::is_queued(GObject *gobj) const
 {
-    std::lock_guard<std::mutex> hold(lock);
-    bool has_toggle_down = find_operation_locked(gobj, DOWN) != q.end();
-    bool has_toggle_up = find_operation_locked(gobj, UP) != q.end();
+    bool has_toggle_down = g_object_get_qdata(gobj, item_quark(DOWN));
+    bool has_toggle_up = g_object_get_qdata(gobj, item_quark(UP));
     return {has_toggle_down, has_toggle_up};
 }
 
@@ -75,9 +102,8 @@ std::pair<bool, bool>
 ToggleQueue::cancel(GObject *gobj)
 {
     debug("cancel", gobj);
-    std::lock_guard<std::mutex> hold(lock);
-    bool had_toggle_down = find_and_erase_operation_locked(gobj, DOWN);
-    bool had_toggle_up = find_and_erase_operation_locked(gobj, UP);
+    bool had_toggle_down = cancel_operation(gobj, DOWN);
+    bool had_toggle_up = cancel_operation(gobj, UP);
     gjs_debug_lifecycle(GJS_DEBUG_GOBJECT, "ToggleQueue: %p (%s) was %s", gobj,
                         G_OBJECT_TYPE_NAME(gobj),
                         had_toggle_down && had_toggle_up ? "queued to toggle BOTH"
@@ -90,21 +116,24 @@ ToggleQueue::cancel(GObject *gobj)
 bool
 ToggleQueue::handle_toggle(Handler handler)
 {
-    Item item;
-    {
-        std::lock_guard<std::mutex> hold(lock);
-        if (q.empty())
-            return false;
-
-        item = q.front();
-        handler(item.gobj, item.direction);
-        q.pop_front();
+    Item* item;
+    while ((item = pop()) && item->cancelled) {
+        debug("skip cancelled", item);
+        delete item;
     }
+    if (!item)
+        return false;
 
-    debug("handle", item.gobj);
-    if (item.needs_unref)
-        g_object_unref(item.gobj);
+    handler(item->gobj, item->direction);
+    // Only detach the item if it's still the one attached to the object
+    g_object_replace_qdata(item->gobj, item_quark(item->direction), item,
+                           nullptr, nullptr, nullptr);
 
+    debug("handle", item->gobj);
+    if (item->needs_unref)
+        g_object_unref(item->gobj);
+
+    delete item;
     return true;
 }
 
@@ -113,7 +142,7 @@ ToggleQueue::shutdown(void)
 {
     debug("shutdown", nullptr);
     g_assert(((void)"Queue should have been emptied before shutting down",
-              q.empty()));
+              m_tail == &m_stub && !m_stub.next.load()));
     m_shutdown = true;
 }
 
@@ -130,7 +159,12 @@ ToggleQueue::enqueue(GObject               *gobj,
         return;
     }
 
-    Item item{gobj, direction};
+    auto* item = new Item;
+    item->gobj = gobj;
+    item->direction = direction;
+    item->needs_unref = false;
+    item->cancelled = false;
+
     /* If we're toggling up we take a reference to the object now,
      * so it won't toggle down before we process it. This ensures we
      * only ever have at most two toggle notifications queued.
@@ -139,7 +173,7 @@ ToggleQueue::enqueue(GObject               *gobj,
     if (direction == UP) {
         debug("enqueue UP", gobj);
         g_object_ref(gobj);
-        item.needs_unref = true;
+        item->needs_unref = true;
     } else {
         debug("enqueue DOWN", gobj);
     }
@@ -150,18 +184,16 @@ ToggleQueue::enqueue(GObject               *gobj,
      *
      * Taking a reference now would be bad anyway, since it would force
      * the object to toggle back up again.
-     */   
-
-    std::lock_guard<std::mutex> hold(lock);
-    q.push_back(item);
-    
-    if (m_idle_id) {
-        g_assert(((void) "Should always enqueue with the same handler",
-                  m_toggle_handler == handler));
-        return;
-    }
+     */
+
+    // Attach the item before it becomes visible to the main thread
+    g_object_set_qdata(gobj, item_quark(direction), item);
+    push(item);
+
+    [[maybe_unused]] Handler old_handler = m_toggle_handler.exchange(handler);
+    g_assert(((void) "Should always enqueue with the same handler",
+              !old_handler || old_handler == handler));
 
-    m_toggle_handler = handler;
-    m_idle_id = g_idle_add_full(G_PRIORITY_HIGH, idle_handle_toggle, this,
-                                idle_destroy_notify);
+    if (!m_idle_queued.exchange(true))
+        g_idle_add_full(G_PRIORITY_HIGH, idle_handle_toggle, this, nullptr);
 }
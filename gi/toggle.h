@@ -8,8 +8,6 @@
 #define GI_TOGGLE_H_
 
 #include <atomic>
-#include <deque>
-#include <mutex>
 #include <utility>  // for pair
 
 #include <glib-object.h>
@@ -19,7 +17,15 @@
 
 /* Thread-safe queue for enqueueing toggle-up or toggle-down events on GObjects
  * from any thread. For more information, see object.cpp, comments near
- * wrapped_gobj_toggle_notify(). */
+ * wrapped_gobj_toggle_notify().
+ *
+ * Any thread may enqueue, but only the main thread dequeues, queries, or
+ * cancels. The queue is an intrusive multiple-producer single-consumer linked
+ * list, so enqueueing never takes a lock. Each queued item is also attached to
+ * its GObject as qdata, one key per direction, so is_queued() and cancel() look
+ * at the object instead of searching the queue. Cancelled items stay in the
+ * queue and are skipped (without touching their GObject, which may be gone by
+ * then) when they reach the front. */
 class ToggleQueue {
 public:
     enum Direction {
@@ -31,17 +37,26 @@ public:
 
 private:
     struct Item {
-        GObject *gobj;
+        std::atomic<Item*> next = ATOMIC_VAR_INIT(nullptr);
+        GObject* gobj;
         ToggleQueue::Direction direction;
         unsigned needs_unref : 1;
+        unsigned cancelled : 1;
     };
 
-    mutable std::mutex lock;
-    std::deque<Item> q;
+    // The producers' end of the queue; the consumer's end is m_tail. m_stub
+    // makes sure the list is never empty, so producers never need to touch
+    // m_tail.
+    std::atomic<Item*> m_head;
+    Item* m_tail;
+    Item m_stub;
+
+    std::atomic_bool m_idle_queued = ATOMIC_VAR_INIT(false);
     std::atomic_bool m_shutdown = ATOMIC_VAR_INIT(false);
 
-    unsigned m_idle_id;
-    Handler m_toggle_handler;
+    std::atomic<Handler> m_toggle_handler = ATOMIC_VAR_INIT(nullptr);
+
+    ToggleQueue();
 
     /* No-op unless GJS_VERBOSE_ENABLE_LIFECYCLE is defined to 1. */
     inline void debug(const char* did GJS_USED_VERBOSE_LIFECYCLE,
@@ -49,17 +64,15 @@ private:
         gjs_debug_lifecycle(GJS_DEBUG_GOBJECT, "ToggleQueue %s %p", did, what);
     }
 
-    [[nodiscard]] std::deque<Item>::iterator find_operation_locked(
-        const GObject* gobj, Direction direction);
+    [[nodiscard]] static GQuark item_quark(Direction direction);
 
-    [[nodiscard]] std::deque<Item>::const_iterator find_operation_locked(
-        const GObject* gobj, Direction direction) const;
+    void push(Item* item);
+    [[nodiscard]] Item* pop(void);
 
-    [[nodiscard]] bool find_and_erase_operation_locked(const GObject* gobj,
-                                                       Direction direction);
+    [[nodiscard]] static bool cancel_operation(GObject* gobj,
+                                               Direction direction);
 
     static gboolean idle_handle_toggle(void *data);
-    static void idle_destroy_notify(void *data);
 
  public:
     /* These two functions return a pair DOWN, UP signifying whether toggles
@@ -7,6 +7,10 @@
 #include <stdint.h>
 #include <string.h>  // for memset
 
+#include <memory>  // for unique_ptr
+#include <unordered_map>
+#include <vector>
+
 #include <girepository.h>
 #include <glib-object.h>
 #include <glib.h>
@@ -42,12 +46,55 @@
 #include "gjs/jsapi-util.h"
 #include "util/log.h"
 
+// Marshalling information for one parameter of a signal. Index 0 is the
+// instance parameter.
+struct GjsSignalParamPlan {
+    GITypeInfo type_info;
+    // Index of the parameter holding this array's length, or -1
+    int array_length_index;
+    bool has_type_info : 1;
+    // Array lengths are passed to JS together with the array, not separately
+    bool skip : 1;
+    bool no_copy : 1;
+};
+
+// Marshalling plan for a signal, computed the first time a JS handler is
+// connected to the signal and shared by all of its closures, so that emitting
+// the signal does not need to query the signal or its introspection info.
+struct GjsSignalMarshalPlan {
+    GSignalQuery query;
+    std::vector<GjsSignalParamPlan> params;
+};
+
+// Signal IDs are unique across all types, and GLib never reuses the ID of a
+// signal that was destroyed along with its dynamic type, so they are enough as
+// a key. Plans are intentionally leaked: one for such a signal stays in the map
+// until the process exits, but can never be found again.
+static std::unordered_map<unsigned, std::unique_ptr<GjsSignalMarshalPlan>>
+    signal_marshal_plans;
+
+/*
+ * gjs_signal_marshal_plans_size:
+ *
+ * Returns the approximate number of bytes used by the signal marshalling plans
+ * and the map that holds them.
+ */
+size_t gjs_signal_marshal_plans_size(void) {
+    size_t size = signal_marshal_plans.bucket_count() * sizeof(void*);
+    for (auto& it : signal_marshal_plans) {
+        size += sizeof(decltype(signal_marshal_plans)::value_type) +
+                sizeof(void*) + sizeof(GjsSignalMarshalPlan) +
+                it.second->params.capacity() * sizeof(GjsSignalParamPlan);
+    }
+    return size;
+}
+
 GJS_JSAPI_RETURN_CONVENTION
 static bool gjs_value_from_g_value_internal(JSContext             *context,
                                             JS::MutableHandleValue value_p,
                                             const GValue          *gvalue,
                                             bool                   no_copy,
-                                            GSignalQuery          *signal_query,
+                                            GjsSignalMarshalPlan  *signal_plan,
                                             int                    arg_n);
 
 /*
@@ -80,6 +127,56 @@ static bool gjs_value_from_g_value_internal(JSContext             *context,
     return signal_info;
 }
 
+[[nodiscard]] static GjsSignalMarshalPlan* get_signal_marshal_plan(
+    unsigned signal_id) {
+    auto it = signal_marshal_plans.find(signal_id);
+    if (it != signal_marshal_plans.end())
+        return it->second.get();
+
+    auto plan = std::make_unique<GjsSignalMarshalPlan>();
+    g_signal_query(signal_id, &plan->query);
+    if (!plan->query.signal_id)
+        return nullptr;
+
+    unsigned n_param_values = plan->query.n_params + 1;
+    plan->params.resize(n_param_values);
+
+    for (unsigned i = 0; i < n_param_values; i++) {
+        GjsSignalParamPlan& param = plan->params[i];
+        param.array_length_index = -1;
+        param.has_type_info = false;
+        param.skip = false;
+        param.no_copy =
+            i >= 1 &&
+            (plan->query.param_types[i - 1] & G_SIGNAL_TYPE_STATIC_SCOPE) != 0;
+    }
+
+    /* Check if any parameters, such as array lengths, need to be eliminated
+     * before we invoke the closure.
+     */
+    GjsAutoBaseInfo signal_info = get_signal_info_if_available(&plan->query);
+    if (signal_info) {
+        /* Start at argument 1, skip the instance parameter */
+        for (unsigned i = 1; i < n_param_values; ++i) {
+            GjsSignalParamPlan& param = plan->params[i];
+            GjsAutoBaseInfo arg_info =
+                g_callable_info_get_arg(signal_info, i - 1);
+            g_arg_info_load_type(arg_info, &param.type_info);
+            param.has_type_info = true;
+
+            int array_len_pos = g_type_info_get_array_length(&param.type_info);
+            if (array_len_pos != -1) {
+                plan->params[array_len_pos + 1].skip = true;
+                param.array_length_index = array_len_pos + 1;
+            }
+        }
+    }
+
+    GjsSignalMarshalPlan* retval = plan.get();
+    signal_marshal_plans.emplace(signal_id, std::move(plan));
+    return retval;
+}
+
 /*
  * Fill in value_p with a JS array, converted from a C array stored as a pointer
  * in array_value, with its length stored in array_length_value.
@@ -92,7 +189,7 @@ gjs_value_from_array_and_length_values(JSContext             *context,
                                        const GValue          *array_value,
                                        const GValue          *array_length_value,
                                        bool                   no_copy,
-                                       GSignalQuery          *signal_query,
+                                       GjsSignalMarshalPlan  *signal_plan,
                                        int                    array_length_arg_n)
 {
     JS::RootedValue array_length(context);
@@ -103,7 +200,7 @@ gjs_value_from_array_and_length_values(JSContext             *context,
 
     if (!gjs_value_from_g_value_internal(context, &array_length,
                                          array_length_value, no_copy,
-                                         signal_query, array_length_arg_n))
+                                         signal_plan, array_length_arg_n))
         return false;
 
     gjs_arg_set(&array_arg, g_value_get_pointer(array_value));
@@ -122,8 +219,6 @@ closure_marshal(GClosure        *closure,
 {
     JSContext *context;
     unsigned i;
-    GSignalQuery signal_query = { 0, };
-    GISignalInfo *signal_info;
 
     gjs_debug_marshal(GJS_DEBUG_GCLOSURE,
                       "Marshal closure %p",
@@ -146,6 +241,7 @@ closure_marshal(GClosure        *closure,
                    "Because it would crash the application, it has been "
                    "blocked and the JS callback not invoked.");
         if (hint) {
+            GSignalQuery signal_query = { 0, };
             gpointer instance;
             g_signal_query(hint->signal_id, &signal_query);
 
@@ -160,57 +256,14 @@ closure_marshal(GClosure        *closure,
     JSFunction* func = gjs_closure_get_callable(closure);
     JSAutoRealm ar(context, JS_GetFunctionObject(func));
 
-    if (marshal_data) {
-        /* we are used for a signal handler */
-        guint signal_id;
-
-        signal_id = GPOINTER_TO_UINT(marshal_data);
-
-        g_signal_query(signal_id, &signal_query);
-
-        if (!signal_query.signal_id) {
-            gjs_debug(GJS_DEBUG_GCLOSURE,
-                      "Signal handler being called on invalid signal");
-            return;
-        }
-
-        if (signal_query.n_params + 1 != n_param_values) {
-            gjs_debug(GJS_DEBUG_GCLOSURE,
-                      "Signal handler being called with wrong number of parameters");
-            return;
-        }
-    }
-
-    /* Check if any parameters, such as array lengths, need to be eliminated
-     * before we invoke the closure.
-     */
-    GjsAutoPointer<bool> skip = g_new0(bool, n_param_values);
-    GjsAutoPointer<int> array_len_indices_for = g_new(int, n_param_values);
-    for(i = 0; i < n_param_values; i++)
-        array_len_indices_for[i] = -1;
-    GjsAutoPointer<GITypeInfo> type_info_for =
-        g_new0(GITypeInfo, n_param_values);
-
-    signal_info = get_signal_info_if_available(&signal_query);
-    if (signal_info) {
-        /* Start at argument 1, skip the instance parameter */
-        for (i = 1; i < n_param_values; ++i) {
-            GIArgInfo *arg_info;
-            int array_len_pos;
-
-            arg_info = g_callable_info_get_arg(signal_info, i - 1);
-            g_arg_info_load_type(arg_info, &type_info_for[i]);
-
-            array_len_pos = g_type_info_get_array_length(&type_info_for[i]);
-            if (array_len_pos != -1) {
-                skip[array_len_pos + 1] = true;
-                array_len_indices_for[i] = array_len_pos + 1;
-            }
-
-            g_base_info_unref((GIBaseInfo *)arg_info);
-        }
-
-        g_base_info_unref((GIBaseInfo *)signal_info);
+    // If we are used for a signal handler, then the marshalling plan was
+    // computed when the closure was created
+    auto* signal_plan = static_cast<GjsSignalMarshalPlan*>(marshal_data);
+    if (signal_plan &&
+        signal_plan->query.n_params + 1 != n_param_values) {
+        gjs_debug(GJS_DEBUG_GCLOSURE,
+                  "Signal handler being called with wrong number of parameters");
+        return;
     }
 
     JS::RootedValueVector argv(context);
@@ -220,29 +273,27 @@ closure_marshal(GClosure        *closure,
     JS::RootedValue argv_to_append(context);
     for (i = 0; i < n_param_values; ++i) {
         const GValue *gval = &param_values[i];
+        GjsSignalParamPlan* param =
+            signal_plan ? &signal_plan->params[i] : nullptr;
         bool no_copy;
         int array_len_index;
         bool res;
 
-        if (skip[i])
+        if (param && param->skip)
             continue;
 
-        no_copy = false;
+        no_copy = param && param->no_copy;
 
-        if (i >= 1 && signal_query.signal_id) {
-            no_copy = (signal_query.param_types[i - 1] & G_SIGNAL_TYPE_STATIC_SCOPE) != 0;
-        }
-
-        array_len_index = array_len_indices_for[i];
+        array_len_index = param ? param->array_length_index : -1;
         if (array_len_index != -1) {
             const GValue *array_len_gval = &param_values[array_len_index];
             res = gjs_value_from_array_and_length_values(
-                context, &argv_to_append, &type_info_for[i], gval,
-                array_len_gval, no_copy, &signal_query, array_len_index);
+                context, &argv_to_append, &param->type_info, gval,
+                array_len_gval, no_copy, signal_plan, array_len_index);
         } else {
             res = gjs_value_from_g_value_internal(context,
                                                   &argv_to_append,
-                                                  gval, no_copy, &signal_query,
+                                                  gval, no_copy, signal_plan,
                                                   i);
         }
 
@@ -280,9 +331,15 @@ GClosure* gjs_closure_new_for_signal(JSContext* context, JSFunction* callable,
                                      const char* description, guint signal_id) {
     GClosure *closure;
 
+    GjsSignalMarshalPlan* plan = get_signal_marshal_plan(signal_id);
+    if (!plan) {
+        gjs_throw(context, "Invalid signal ID %u", signal_id);
+        return nullptr;
+    }
+
     closure = gjs_closure_new(context, callable, description, false);
 
-    g_closure_set_meta_marshal(closure, GUINT_TO_POINTER(signal_id), closure_marshal);
+    g_closure_set_meta_marshal(closure, plan, closure_marshal);
 
     return closure;
 }
@@ -386,7 +443,7 @@ gjs_value_to_g_value_internal(JSContext      *context,
             g_value_set_string(gvalue, NULL);
         } else if (value.isString()) {
             JS::RootedString str(context, value.toString());
-            JS::UniqueChars utf8_string(JS_EncodeStringToUTF8(context, str));
+            JS::UniqueChars utf8_string = gjs_string_to_utf8(context, str);
             if (!utf8_string)
                 return false;
 
@@ -758,7 +815,7 @@ gjs_value_from_g_value_internal(JSContext             *context,
                                 JS::MutableHandleValue value_p,
                                 const GValue          *gvalue,
                                 bool                   no_copy,
-                                GSignalQuery          *signal_query,
+                                GjsSignalMarshalPlan  *signal_plan,
                                 int                    arg_n)
 {
     GType gtype;
@@ -912,33 +969,23 @@ gjs_value_from_g_value_internal(JSContext             *context,
 
         obj = gjs_param_from_g_param(context, gparam);
         value_p.setObjectOrNull(obj);
-    } else if (signal_query && g_type_is_a(gtype, G_TYPE_POINTER)) {
-        bool res;
+    } else if (signal_plan && g_type_is_a(gtype, G_TYPE_POINTER)) {
         GArgument arg;
-        GIArgInfo *arg_info;
-        GISignalInfo *signal_info;
-        GITypeInfo type_info;
+        GjsSignalParamPlan* param = &signal_plan->params[arg_n];
 
-        signal_info = get_signal_info_if_available(signal_query);
-        if (!signal_info) {
+        if (!param->has_type_info) {
             gjs_throw(context, "Unknown signal.");
             return false;
         }
 
-        arg_info = g_callable_info_get_arg(signal_info, arg_n - 1);
-        g_arg_info_load_type(arg_info, &type_info);
-
         g_assert(((void) "Check gjs_value_from_array_and_length_values() before"
                   " calling gjs_value_from_g_value_internal()",
-                  g_type_info_get_array_length(&type_info) == -1));
+                  param->array_length_index == -1));
 
         gjs_arg_set(&arg, g_value_get_pointer(gvalue));
 
-        res = gjs_value_from_g_argument(context, value_p, &type_info, &arg, true);
-
-        g_base_info_unref((GIBaseInfo*)arg_info);
-        g_base_info_unref((GIBaseInfo*)signal_info);
-        return res;
+        return gjs_value_from_g_argument(context, value_p, &param->type_info,
+                                         &arg, true);
     } else if (g_type_is_a(gtype, G_TYPE_POINTER)) {
         gpointer pointer;
 
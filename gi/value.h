@@ -7,6 +7,8 @@
 
 #include <config.h>
 
+#include <stddef.h>  // for size_t
+
 #include <glib-object.h>
 
 #include <js/TypeDecls.h>
@@ -35,4 +37,6 @@ bool gjs_value_from_g_value(JSContext             *context,
                                                    const char* description,
                                                    unsigned signal_id);
 
+[[nodiscard]] size_t gjs_signal_marshal_plans_size(void);
+
 #endif  // GI_VALUE_H_
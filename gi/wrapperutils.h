@@ -59,6 +59,8 @@ enum Tag { Enum, Interface, Object, Struct, Union };
 
 namespace MemoryUse {
 constexpr JS::MemoryUse GObjectInstanceStruct = JS::MemoryUse::Embedding1;
+constexpr JS::MemoryUse BoxedInstanceStruct = JS::MemoryUse::Embedding2;
+constexpr JS::MemoryUse FunctionArgumentCache = JS::MemoryUse::Embedding3;
 }
 
 struct GjsTypecheckNoThrow {};
@@ -203,6 +205,19 @@ class GIWrapperBase {
         return static_cast<Base*>(JS_GetPrivate(wrapper));
     }
 
+    /*
+     * GIWrapperBase::for_js_if_wrapper:
+     *
+     * Like for_js_nocheck(), but returns null if the object does not have the
+     * right JSClass (Base::klass) instead of assuming that it does. For code
+     * that walks arbitrary objects in the heap, such as heap snapshots.
+     */
+    [[nodiscard]] static Base* for_js_if_wrapper(JSObject* wrapper) {
+        if (JS_GetClass(wrapper) != &Base::klass)
+            return nullptr;
+        return for_js_nocheck(wrapper);
+    }
+
     // Methods implementing our CRTP polymorphism scheme follow below. We don't
     // use standard C++ polymorphism because that would occupy another 8 bytes
     // for a vtable.
@@ -0,0 +1,338 @@
+/* -*- mode: C++; c-basic-offset: 4; indent-tabs-mode: nil; -*- */
+// SPDX-License-Identifier: MIT OR LGPL-2.0-or-later
+// SPDX-FileCopyrightText: 2020 GNOME Foundation
+
+#include <config.h>
+
+#include <stdint.h>
+#include <stdio.h>  // for FILE, fclose, fread
+#include <string.h>    // for memcmp, memcpy, memset, strlen
+#include <sys/stat.h>  // for S_ISREG
+#include <time.h>      // for time_t
+
+#include <algorithm>  // for sort
+#include <string>     // for u16string
+#include <utility>    // for move
+#include <vector>
+
+#include <gio/gio.h>  // for g_resources_lookup_data
+#include <glib.h>
+#include <glib/gstdio.h>  // for GStatBuf, g_fopen, g_stat, g_unlink, g_utime
+
+#include <js/CompilationAndEvaluation.h>
+#include <js/CompileOptions.h>
+#include <js/RootingAPI.h>
+#include <js/SourceText.h>
+#include <js/Transcoding.h>
+#include <js/TypeDecls.h>
+#include <jsapi.h>  // for JS_ClearPendingException
+
+#include "gjs/bytecode-cache.h"
+#include "gjs/context-private.h"
+#include "gjs/jsapi-util.h"
+#include "gjs/module-prefetch.h"
+#include "util/log.h"
+
+static constexpr char MAGIC[] = "GJSXDR1";
+static constexpr size_t CHECKSUM_LENGTH = 20;  // SHA-1
+static constexpr size_t MAX_CACHE_SIZE = 64 * 1024 * 1024;
+
+using GjsAutoChecksum = GjsAutoPointer<GChecksum, GChecksum, g_checksum_free>;
+
+// Written in native byte order, since the cache never leaves the machine
+struct GjsBytecodeCacheHeader {
+    char magic[sizeof(MAGIC)];
+    int64_t mtime;
+    uint64_t size;
+    uint8_t checksum[CHECKSUM_LENGTH];
+    uint32_t reserved;
+};
+// The XDR data that follows needs the same alignment as malloc()'s
+static_assert(sizeof(GjsBytecodeCacheHeader) % 16 == 0);
+
+[[nodiscard]] static bool fill_header(const char* path, const char* script,
+                                      size_t script_len,
+                                      GjsBytecodeCacheHeader* header) {
+    GStatBuf st;
+    if (g_stat(path, &st) != 0 || !S_ISREG(st.st_mode))
+        return false;
+    // The file changed since it was read
+    if (size_t(st.st_size) != script_len)
+        return false;
+
+    memset(header, 0, sizeof(*header));
+    memcpy(header->magic, MAGIC, sizeof(MAGIC));
+    header->mtime = st.st_mtime;
+    header->size = script_len;
+
+    GjsAutoChecksum checksum = g_checksum_new(G_CHECKSUM_SHA1);
+    g_checksum_update(checksum, reinterpret_cast<const uint8_t*>(script),
+                      script_len);
+    gsize digest_len = CHECKSUM_LENGTH;
+    g_checksum_get_digest(checksum, header->checksum, &digest_len);
+    return true;
+}
+
+bool GjsBytecodeCache::s_disabled = false;
+
+GjsBytecodeCache::GjsBytecodeCache()
+    : m_dir_created(false), m_use_precompiled(false) {
+    // XDR data is stamped with the build ID, and refused by other builds
+    JS::SetProcessBuildIdOp(get_build_id);
+
+    if (s_disabled || g_getenv("GJS_DISABLE_BYTECODE_CACHE"))
+        return;
+
+    m_dir = g_build_filename(g_get_user_cache_dir(), "gjs", "bytecode",
+                             nullptr);
+    m_use_precompiled = true;
+}
+
+char* GjsBytecodeCache::entry_path(const char* path) const {
+    // Different versions don't overwrite each other's entries
+    const char* version = engine_version();
+    GjsAutoChecksum checksum = g_checksum_new(G_CHECKSUM_SHA1);
+    g_checksum_update(checksum, reinterpret_cast<const uint8_t*>(version),
+                      strlen(version) + 1);
+    g_checksum_update(checksum, reinterpret_cast<const uint8_t*>(path),
+                      strlen(path));
+
+    GjsAutoChar name =
+        g_strconcat(g_checksum_get_string(checksum), ".jsc", nullptr);
+    return g_build_filename(m_dir, name.get(), nullptr);
+}
+
+[[nodiscard]] static bool lookup(JSContext* cx,
+                                 const JS::ReadOnlyCompileOptions& options,
+                                 const char* cache_path,
+                                 const GjsBytecodeCacheHeader& header,
+                                 JS::MutableHandleScript script) {
+    char* unowned_data;
+    gsize len;
+    if (!g_file_get_contents(cache_path, &unowned_data, &len, nullptr))
+        return false;
+    GjsAutoChar data = unowned_data;  // steals ownership
+
+    // A stale entry is overwritten once the script is compiled again
+    if (len <= sizeof(header) || memcmp(data, &header, sizeof(header)) != 0)
+        return false;
+
+    JS::TranscodeRange range(reinterpret_cast<uint8_t*>(data.get()) +
+                                 sizeof(header),
+                             len - sizeof(header));
+    JS::TranscodeResult result = JS::DecodeScript(cx, options, range, script);
+    if (result == JS::TranscodeResult_Ok) {
+        // Mark the entry as recently used, for trim()
+        g_utime(cache_path, nullptr);
+        return true;
+    }
+
+    if (result == JS::TranscodeResult_Throw)
+        JS_ClearPendingException(cx);
+    gjs_debug(GJS_DEBUG_IMPORTER,
+              "Discarding bytecode cache entry %s, which could not be decoded "
+              "(%d)",
+              cache_path, result);
+    g_unlink(cache_path);
+    return false;
+}
+
+void GjsBytecodeCache::store(JSContext* cx, JS::HandleScript script,
+                             const char* cache_path,
+                             const GjsBytecodeCacheHeader& header) {
+    JS::TranscodeBuffer buffer;
+    if (!buffer.append(reinterpret_cast<const uint8_t*>(&header),
+                       sizeof(header)))
+        return;
+
+    JS::TranscodeResult result = JS::EncodeScript(cx, buffer, script);
+    if (result != JS::TranscodeResult_Ok) {
+        if (result == JS::TranscodeResult_Throw)
+            JS_ClearPendingException(cx);
+        gjs_debug(GJS_DEBUG_IMPORTER, "Could not encode %s for caching (%d)",
+                  cache_path, result);
+        return;
+    }
+
+    if (!m_dir_created) {
+        if (g_mkdir_with_parents(m_dir, 0755) != 0) {
+            gjs_debug(GJS_DEBUG_IMPORTER,
+                      "Could not create %s, disabling the bytecode cache",
+                      m_dir.get());
+            m_dir = nullptr;
+            return;
+        }
+        m_dir_created = true;
+    }
+
+    // Writes to a temporary file, and renames that over the entry
+    GjsAutoError error;
+    if (!g_file_set_contents(cache_path,
+                             reinterpret_cast<const char*>(buffer.begin()),
+                             buffer.length(), error.out())) {
+        gjs_debug(GJS_DEBUG_IMPORTER, "Could not write %s: %s", cache_path,
+                  error->message);
+        return;
+    }
+
+    m_bytes_written += buffer.length();
+}
+
+bool GjsBytecodeCache::has_entry(const char* path, const char* script,
+                                 size_t script_len) const {
+    GjsBytecodeCacheHeader header;
+    if (!m_dir || !fill_header(path, script, script_len, &header))
+        return false;
+
+    GjsAutoChar cache_path = entry_path(path);
+    FILE* fp = g_fopen(cache_path, "rb");
+    if (!fp)
+        return false;
+
+    GjsBytecodeCacheHeader cached;
+    bool matches = fread(&cached, sizeof(cached), 1, fp) == 1 &&
+                   memcmp(&cached, &header, sizeof(header)) == 0;
+    fclose(fp);
+    return matches;
+}
+
+bool GjsBytecodeCache::load_precompiled(
+    JSContext* cx, const JS::ReadOnlyCompileOptions& options,
+    JS::MutableHandleScript script) {
+    static constexpr char URI_PREFIX[] = "resource:///org/gnome/gjs/";
+
+    const char* filename = options.filename();
+    if (!m_use_precompiled || !filename ||
+        !g_str_has_prefix(filename, URI_PREFIX))
+        return false;
+
+    GjsAutoChar resource_path =
+        g_strconcat("/org/gnome/gjs/bytecode/",
+                    filename + strlen(URI_PREFIX), nullptr);
+    GjsAutoPointer<GBytes, GBytes, g_bytes_unref> bytecode =
+        g_resources_lookup_data(resource_path, G_RESOURCE_LOOKUP_FLAGS_NONE,
+                                nullptr);
+    if (!bytecode)
+        return false;
+
+    size_t len;
+    const void* data = g_bytes_get_data(bytecode, &len);
+    JS::TranscodeRange range(
+        static_cast<uint8_t*>(const_cast<void*>(data)), len);
+    JS::TranscodeResult result = JS::DecodeScript(cx, options, range, script);
+    if (result == JS::TranscodeResult_Ok)
+        return true;
+
+    if (result == JS::TranscodeResult_Throw)
+        JS_ClearPendingException(cx);
+    // All the built-in modules were compiled by the same engine
+    if (result == JS::TranscodeResult_Failure_BadBuildId)
+        m_use_precompiled = false;
+    gjs_debug(GJS_DEBUG_IMPORTER,
+              "Could not decode the precompiled bytecode of %s (%d), compiling "
+              "it from source",
+              filename, result);
+    return false;
+}
+
+JSScript* GjsBytecodeCache::compile(JSContext* cx,
+                                    const JS::ReadOnlyCompileOptions& options,
+                                    const char* path, const char* script,
+                                    ssize_t script_len) {
+    JS::RootedScript precompiled(cx);
+    if (!path && load_precompiled(cx, options, &precompiled))
+        return precompiled;
+
+    size_t len = script_len < 0 ? strlen(script) : script_len;
+
+    GjsBytecodeCacheHeader header;
+    GjsAutoChar cache_path;
+    if (m_dir && path && fill_header(path, script, len, &header))
+        cache_path = entry_path(path);
+
+    GjsModulePrefetcher& prefetcher =
+        GjsContextPrivate::from_cx(cx)->module_prefetcher();
+    JS::RootedScript compiled(cx);
+    if (prefetcher.take(cx, options.filename(), script, len, &compiled)) {
+        gjs_debug(GJS_DEBUG_IMPORTER, "Using %s, compiled on a helper thread",
+                  options.filename());
+    } else {
+        if (cache_path && lookup(cx, options, cache_path, header, &compiled)) {
+            gjs_debug(GJS_DEBUG_IMPORTER, "Loaded %s from the bytecode cache",
+                      path);
+            return compiled;
+        }
+
+        std::u16string utf16_string = gjs_utf8_script_to_utf16(script, len);
+        // COMPAT: This could use JS::SourceText<mozilla::Utf8Unit> directly,
+        // but that messes up code coverage. See bug
+        // https://bugzilla.mozilla.org/show_bug.cgi?id=1404784
+        JS::SourceText<char16_t> buf;
+        if (!buf.init(cx, utf16_string.c_str(), utf16_string.size(),
+                      JS::SourceOwnership::Borrowed))
+            return nullptr;
+
+        compiled = JS::CompileForNonSyntacticScope(cx, options, buf);
+        if (!compiled)
+            return nullptr;
+    }
+
+    // Encoded before running, so that the entry doesn't depend on which
+    // functions the script happened to call
+    if (cache_path)
+        store(cx, compiled, cache_path, header);
+
+    return compiled;
+}
+
+void GjsBytecodeCache::trim(void) {
+    if (!m_dir || m_bytes_written == 0)
+        return;
+    m_bytes_written = 0;
+
+    GDir* dir = g_dir_open(m_dir, 0, nullptr);
+    if (!dir)
+        return;
+
+    struct Entry {
+        GjsAutoChar path;
+        time_t last_used;
+        size_t size;
+    };
+    std::vector<Entry> entries;
+    size_t total_size = 0;
+
+    while (const char* name = g_dir_read_name(dir)) {
+        GjsAutoChar path = g_build_filename(m_dir, name, nullptr);
+        GStatBuf st;
+        if (g_stat(path, &st) != 0 || !S_ISREG(st.st_mode))
+            continue;
+        total_size += st.st_size;
+        entries.push_back({std::move(path), st.st_mtime, size_t(st.st_size)});
+    }
+    g_dir_close(dir);
+
+    if (total_size <= MAX_CACHE_SIZE)
+        return;
+
+    std::sort(entries.begin(), entries.end(),
+              [](const Entry& a, const Entry& b) {
+                  return a.last_used < b.last_used;
+              });
+
+    // Leave some room, so that the next few new entries don't trim again
+    size_t n_removed = 0;
+    for (const Entry& entry : entries) {
+        if (total_size <= MAX_CACHE_SIZE / 4 * 3)
+            break;
+        if (g_unlink(entry.path) == 0) {
+            total_size -= entry.size;
+            n_removed++;
+        }
+    }
+
+    gjs_debug(GJS_DEBUG_IMPORTER,
+              "Removed %zu least recently used bytecode cache entries, %zu "
+              "bytes left",
+              n_removed, total_size);
+}
@@ -0,0 +1,114 @@
+/* -*- mode: C++; c-basic-offset: 4; indent-tabs-mode: nil; -*- */
+// SPDX-License-Identifier: MIT OR LGPL-2.0-or-later
+// SPDX-FileCopyrightText: 2020 GNOME Foundation
+
+#ifndef GJS_BYTECODE_CACHE_H_
+#define GJS_BYTECODE_CACHE_H_
+
+#include <config.h>
+
+#include <stddef.h>     // for size_t
+#include <sys/types.h>  // for ssize_t
+
+#include <string.h>  // for strlen
+
+#include <js/BuildId.h>
+#include <js/TypeDecls.h>
+#include <jsapi.h>  // for JS_GetImplementationVersion
+
+#include "gjs/jsapi-util.h"
+#include "gjs/macros.h"
+
+namespace JS {
+class ReadOnlyCompileOptions;
+}
+struct GjsBytecodeCacheHeader;
+
+/*
+ * GjsBytecodeCache:
+ *
+ * Keeps compiled scripts on disk, so that modules don't have to be transcoded
+ * to UTF-16 and parsed again every time a program starts. Entries are
+ * SpiderMonkey's XDR encoding of the script, which includes its source, in
+ * $XDG_CACHE_HOME/gjs/bytecode, one file per source file.
+ *
+ * An entry is named after the path of the source file and the version of GJS
+ * and SpiderMonkey, and starts with the source file's modification time, size
+ * and SHA-1 checksum; it is only used if all of those still match. Entries
+ * are written to a temporary file and renamed into place, so that concurrent
+ * processes never see a partial one. Using an entry updates its modification
+ * time; when the cache grows beyond its size limit, the least recently used
+ * entries are removed.
+ *
+ * Only scripts loaded from local files are cached. The built-in modules in
+ * GJS's own resources are compiled when GJS is built instead; their bytecode
+ * is under /org/gnome/gjs/bytecode, at the same path as their source under
+ * /org/gnome/gjs, and is used unless it was built by a different engine.
+ *
+ * When a program's main script misses the cache, the modules that it imports
+ * are compiled on helper threads; see GjsModulePrefetcher.
+ *
+ * Both are disabled if GJS_DISABLE_BYTECODE_CACHE is set, and while code
+ * coverage is collected.
+ */
+class GjsBytecodeCache {
+    // Null if the cache is disabled
+    GjsAutoChar m_dir;
+    size_t m_bytes_written = 0;
+    bool m_dir_created : 1;
+    bool m_use_precompiled : 1;
+
+    static bool s_disabled;
+
+    [[nodiscard]] char* entry_path(const char* path) const;
+    void store(JSContext* cx, JS::HandleScript script, const char* cache_path,
+               const GjsBytecodeCacheHeader& header);
+
+ public:
+    GjsBytecodeCache();
+
+    // Disables caching in every context created afterwards
+    static void disable(void) { s_disabled = true; }
+
+    // Decodes the bytecode compiled at build time for the built-in module
+    // whose resource URI is the filename in @options, if there is any
+    [[nodiscard]] bool load_precompiled(
+        JSContext* cx, const JS::ReadOnlyCompileOptions& options,
+        JS::MutableHandleScript script);
+
+    // Whether there is an up-to-date entry for @script, loaded from @path
+    [[nodiscard]] bool has_entry(const char* path, const char* script,
+                                 size_t script_len) const;
+
+    // Compiles @script, which was loaded from the file at @path, to be run in
+    // a non-syntactic scope; @path may be null if it didn't come from a file
+    GJS_JSAPI_RETURN_CONVENTION
+    JSScript* compile(JSContext* cx, const JS::ReadOnlyCompileOptions& options,
+                      const char* path, const char* script, ssize_t script_len);
+
+    // Removes the least recently used entries if the cache is too big; only
+    // does anything if this cache added entries
+    void trim(void);
+
+    // Defined here, so that gjs-compile-bytecode stamps its output with the
+    // same build ID without linking to libgjs
+
+    [[nodiscard]] static const char* engine_version(void) {
+        static const GjsAutoChar version = g_strdup_printf(
+            "GJS %s, %s%s", VERSION, JS_GetImplementationVersion(),
+#ifdef DEBUG
+            " (debug)"
+#else
+            ""
+#endif
+        );
+        return version;
+    }
+
+    [[nodiscard]] static bool get_build_id(JS::BuildIdCharVector* build_id) {
+        const char* version = engine_version();
+        return build_id->append(version, strlen(version));
+    }
+};
+
+#endif  // GJS_BYTECODE_CACHE_H_
@@ -0,0 +1,149 @@
+/* -*- mode: C++; c-basic-offset: 4; indent-tabs-mode: nil; -*- */
+// SPDX-License-Identifier: MIT OR LGPL-2.0-or-later
+// SPDX-FileCopyrightText: 2020 GNOME Foundation
+
+// gjs-compile-bytecode: Compiles one of GJS's built-in modules to SpiderMonkey
+// bytecode when GJS is built. The output is embedded in GJS's resources, and
+// decoded by GjsBytecodeCache::load_precompiled() instead of compiling the
+// module's source.
+//
+// Usage: gjs-compile-bytecode [--global] URI SOURCE OUTPUT
+//
+// URI is the resource URI that the module is loaded from. Modules are compiled
+// to run in a non-syntactic scope, as the importer runs them; with --global, as
+// a global script, as the bootstrap scripts are run. The source is not part of
+// the output; it is loaded from the resource if it is needed.
+
+#include <config.h>
+
+#include <stdio.h>  // for stderr
+
+#include <glib.h>
+
+#include <js/Class.h>  // for DefaultGlobalClassOps
+#include <js/CompilationAndEvaluation.h>
+#include <js/CompileOptions.h>
+#include <js/ErrorReport.h>
+#include <js/Exception.h>
+#include <js/Initialization.h>
+#include <js/RealmOptions.h>
+#include <js/RootingAPI.h>
+#include <js/SourceText.h>
+#include <js/Transcoding.h>
+#include <js/TypeDecls.h>
+#include <jsapi.h>  // for JS_NewGlobalObject, JSAutoRealm, ...
+#include <mozilla/Utf8.h>  // for Utf8Unit
+
+#include "gjs/bytecode-cache.h"
+#include "gjs/jsapi-util.h"
+
+static constexpr JSClass global_class = {
+    "GjsCompileBytecodeGlobal",
+    JSCLASS_GLOBAL_FLAGS,
+    &JS::DefaultGlobalClassOps,
+};
+
+static void report_exception(JSContext* cx) {
+    JS::ExceptionStack exn_stack(cx);
+    JS::ErrorReportBuilder report(cx);
+    if (!JS::StealPendingExceptionStack(cx, &exn_stack) ||
+        !report.init(cx, exn_stack, JS::ErrorReportBuilder::NoSideEffects)) {
+        g_printerr("(Unable to print exception)\n");
+        JS_ClearPendingException(cx);
+        return;
+    }
+
+    JS::PrintError(cx, stderr, report, /* reportWarnings = */ false);
+}
+
+[[nodiscard]] static bool compile(JSContext* cx, bool global, const char* uri,
+                                  const char* source_path,
+                                  const char* output_path) {
+    char* unowned_source;
+    size_t source_len;
+    GjsAutoError error;
+    if (!g_file_get_contents(source_path, &unowned_source, &source_len,
+                             error.out())) {
+        g_printerr("%s\n", error->message);
+        return false;
+    }
+    GjsAutoChar source = unowned_source;  // steals ownership
+
+    JS::CompileOptions options(cx);
+    options.setFileAndLine(uri, 1).setSourceIsLazy(true);
+
+    JS::SourceText<mozilla::Utf8Unit> buf;
+    if (!buf.init(cx, source.get(), source_len,
+                  JS::SourceOwnership::Borrowed)) {
+        report_exception(cx);
+        return false;
+    }
+
+    JS::RootedScript script(
+        cx, global ? JS::Compile(cx, options, buf)
+                   : JS::CompileForNonSyntacticScope(cx, options, buf));
+    if (!script) {
+        report_exception(cx);
+        return false;
+    }
+
+    JS::TranscodeBuffer buffer;
+    JS::TranscodeResult result = JS::EncodeScript(cx, buffer, script);
+    if (result != JS::TranscodeResult_Ok) {
+        if (result == JS::TranscodeResult_Throw)
+            report_exception(cx);
+        g_printerr("Could not encode %s (%d)\n", source_path, result);
+        return false;
+    }
+
+    if (!g_file_set_contents(output_path,
+                             reinterpret_cast<const char*>(buffer.begin()),
+                             buffer.length(), error.out())) {
+        g_printerr("%s\n", error->message);
+        return false;
+    }
+
+    return true;
+}
+
+int main(int argc, char** argv) {
+    bool global = argc > 1 && g_str_equal(argv[1], "--global");
+    if (global) {
+        argc--;
+        argv++;
+    }
+
+    if (argc != 4) {
+        g_printerr("Usage: gjs-compile-bytecode [--global] URI SOURCE OUTPUT\n");
+        return 2;
+    }
+
+    if (!JS_Init())
+        g_error("Could not initialize Javascript");
+
+    JSContext* cx = JS_NewContext(8 * 1024 * 1024 /* max bytes */);
+    if (!cx)
+        g_error("Could not create Javascript context");
+    if (!JS::InitSelfHostedCode(cx))
+        g_error("Could not initialize Javascript self-hosted code");
+
+    // Must be the same build ID as libgjs uses when decoding
+    JS::SetProcessBuildIdOp(GjsBytecodeCache::get_build_id);
+
+    bool ok;
+    {
+        JS::RealmOptions realm_options;
+        JS::RootedObject global_obj(
+            cx, JS_NewGlobalObject(cx, &global_class, nullptr,
+                                   JS::FireOnNewGlobalHook, realm_options));
+        if (!global_obj)
+            g_error("Could not create global object");
+
+        JSAutoRealm ar(cx, global_obj);
+        ok = compile(cx, global, argv[1], argv[2], argv[3]);
+    }
+
+    JS_DestroyContext(cx);
+    JS_ShutDown();
+    return ok ? 0 : 1;
+}
@@ -7,12 +7,14 @@
 
 #include <config.h>
 
+#include <stddef.h>  // for size_t
 #include <stdint.h>
 #include <sys/types.h>  // for ssize_t
 
 #include <type_traits>  // for is_same
 #include <unordered_map>
 
+#include <gio/gio.h>
 #include <glib-object.h>
 #include <glib.h>
 
@@ -28,9 +30,13 @@
 #include <jsapi.h>        // for JS_GetContextPrivate
 #include <jsfriendapi.h>  // for ScriptEnvironmentPreparer
 
+#include "gjs/bytecode-cache.h"
 #include "gjs/context.h"
+#include "gjs/gc-policy.h"
+#include "gjs/import-path-cache.h"
 #include "gjs/jsapi-util.h"
 #include "gjs/macros.h"
+#include "gjs/module-prefetch.h"
 #include "gjs/profiler.h"
 
 namespace js {
@@ -78,6 +84,20 @@ class GjsContextPrivate : public JS::JobQueue {
     char** m_search_path;
 
     unsigned m_auto_gc_id;
+    GjsGCPolicy m_gc_policy;
+    // Filled in from construct properties, before the constructor runs
+    GjsGCPolicy::Config m_gc_config;
+    // Optional object with an "after-paint" signal, such as a GdkFrameClock,
+    // that incremental GC slices are aligned to; not owned
+    GObject* m_gc_frame_clock = nullptr;
+    unsigned long m_gc_after_paint_id = 0;  // NOLINT(runtime/int)
+
+#if GLIB_CHECK_VERSION(2, 64, 0)
+    // Created from the main loop, since the default monitor connects to the
+    // system bus, which isn't worth it for scripts that never run one
+    GjsAutoUnref<GMemoryMonitor> m_memory_monitor;
+    unsigned m_memory_monitor_id = 0;
+#endif
 
     GjsAtoms* m_atoms;
 
@@ -86,8 +106,16 @@ class GjsContextPrivate : public JS::JobQueue {
 
     std::unordered_map<uint64_t, GjsAutoChar> m_unhandled_rejection_stacks;
 
+    // Pinned atoms for C strings with static storage, keyed by the address of
+    // the C string; see gjs_string_from_static_utf8()
+    std::unordered_map<const char*, JSString*> m_static_strings;
+
     GjsProfiler* m_profiler;
 
+    GjsBytecodeCache m_bytecode_cache;
+    GjsModulePrefetcher m_module_prefetcher;
+    GjsImportPathCache m_import_path_cache;
+
     /* Environment preparer needed for debugger, taken from SpiderMonkey's
      * JS shell */
     struct EnvironmentPreparer final : protected js::ScriptEnvironmentPreparer {
@@ -116,15 +144,24 @@ class GjsContextPrivate : public JS::JobQueue {
     bool m_destroying : 1;
     bool m_in_gc_sweep : 1;
     bool m_should_exit : 1;
-    bool m_force_gc : 1;
     bool m_draining_job_queue : 1;
     bool m_should_profile : 1;
     bool m_should_listen_sigusr2 : 1;
 
     int64_t m_sweep_begin_time;
 
-    void schedule_gc_internal(bool force_gc);
+    void schedule_gc_check(void);
+    void schedule_gc_slice(void);
     static gboolean trigger_gc_if_needed(void* data);
+    static void on_gc_frame_clock_after_paint(GObject* frame_clock, void* data);
+    static void on_gc_frame_clock_finalized(void* data,
+                                            GObject* where_the_object_was);
+#if GLIB_CHECK_VERSION(2, 64, 0)
+    static gboolean watch_memory_monitor(void* data);
+    static void on_low_memory_warning(GMemoryMonitor* monitor,
+                                      GMemoryMonitorWarningLevel level,
+                                      void* data);
+#endif
 
     class SavedQueue;
     void start_draining_job_queue(void);
@@ -175,6 +212,17 @@ class GjsContextPrivate : public JS::JobQueue {
     void set_should_listen_sigusr2(bool value) {
         m_should_listen_sigusr2 = value;
     }
+    [[nodiscard]] GjsGCPolicy::Config& gc_config() { return m_gc_config; }
+    [[nodiscard]] GjsGCPolicy& gc_policy() { return m_gc_policy; }
+    [[nodiscard]] GjsBytecodeCache& bytecode_cache() {
+        return m_bytecode_cache;
+    }
+    [[nodiscard]] GjsModulePrefetcher& module_prefetcher() {
+        return m_module_prefetcher;
+    }
+    [[nodiscard]] GjsImportPathCache& import_path_cache() {
+        return m_import_path_cache;
+    }
     [[nodiscard]] bool is_owner_thread() const {
         return m_owner_thread == g_thread_self();
     }
@@ -187,6 +235,16 @@ class GjsContextPrivate : public JS::JobQueue {
     [[nodiscard]] ObjectInitList& object_init_list() {
         return m_object_init_list;
     }
+    [[nodiscard]] std::unordered_map<const char*, JSString*>& static_strings() {
+        return m_static_strings;
+    }
+    // Bytes used by the map, not counting the atoms, which are in the GC heap
+    [[nodiscard]] size_t static_strings_size() const {
+        return m_static_strings.bucket_count() * sizeof(void*) +
+               m_static_strings.size() *
+                   (sizeof(decltype(m_static_strings)::value_type) +
+                    sizeof(void*));
+    }
     [[nodiscard]] static const GjsAtoms& atoms(JSContext* cx) {
         return *(from_cx(cx)->m_atoms);
     }
@@ -203,8 +261,10 @@ class GjsContextPrivate : public JS::JobQueue {
                        const JS::HandleValueArray& args,
                        JS::MutableHandleValue rval);
 
-    void schedule_gc(void) { schedule_gc_internal(true); }
+    void note_wrapper_toggled_down(void);
     void schedule_gc_if_needed(void);
+    [[nodiscard]] bool set_gc_frame_clock(GObject* frame_clock);
+    size_t release_memory(void);
 
     void exit(uint8_t exit_code);
     [[nodiscard]] bool should_exit(uint8_t* exit_code_p) const;
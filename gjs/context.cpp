@@ -7,7 +7,7 @@
 #include <signal.h>  // for sigaction, SIGUSR1, sa_handler
 #include <stdint.h>
 #include <stdio.h>      // for FILE, fclose, size_t
-#include <string.h>     // for memset
+#include <string.h>     // for memset, strlen
 
 #ifdef HAVE_UNISTD_H
 #    include <unistd.h>  // for getpid
@@ -15,8 +15,12 @@
 #    include <process.h>
 #endif
 
+#ifdef __GLIBC__
+#    include <malloc.h>  // for malloc_trim
+#endif
+
 #include <new>
-#include <string>       // for u16string
+#include <string>
 #include <unordered_map>
 #include <utility>  // for move
 #include <vector>
@@ -41,7 +45,6 @@
 #include <js/Promise.h>             // for JobQueue::SavedJobQueue
 #include <js/PropertyDescriptor.h>  // for JSPROP_PERMANENT, JSPROP_RE...
 #include <js/RootingAPI.h>
-#include <js/SourceText.h>
 #include <js/TracingAPI.h>
 #include <js/TypeDecls.h>
 #include <js/UniquePtr.h>
@@ -51,6 +54,8 @@
 #include <jsfriendapi.h>  // for DumpHeap, IgnoreNurseryObjects
 #include <mozilla/UniquePtr.h>
 
+#include "gi/boxed.h"
+#include "gi/function.h"
 #include "gi/object.h"
 #include "gi/private.h"
 #include "gi/repo.h"
@@ -61,6 +66,7 @@
 #include "gjs/engine.h"
 #include "gjs/error-types.h"
 #include "gjs/global.h"
+#include "gjs/heap-snapshot.h"
 #include "gjs/importer.h"
 #include "gjs/jsapi-util.h"
 #include "gjs/mem.h"
@@ -123,12 +129,17 @@ enum {
     PROP_PROGRAM_NAME,
     PROP_PROFILER_ENABLED,
     PROP_PROFILER_SIGUSR2,
+    PROP_GC_CHECK_INTERVAL,
+    PROP_GC_SLICE_BUDGET,
+    PROP_GC_TOGGLE_THRESHOLD,
+    PROP_GC_INCREMENTAL_THRESHOLD,
 };
 
 static GMutex contexts_lock;
 static GList *all_contexts = NULL;
 
 static GjsAutoChar dump_heap_output;
+static bool dump_heap_snapshot = false;
 static unsigned dump_heap_idle_id = 0;
 
 #ifdef G_OS_UNIX
@@ -145,13 +156,16 @@ gjs_context_dump_heaps(void)
                                            intmax_t(getpid()), counter);
     ++counter;
 
-    FILE *fp = fopen(filename, "w");
+    FILE *fp = fopen(filename, dump_heap_snapshot ? "wb" : "w");
     if (!fp)
         return;
 
     for (GList *l = all_contexts; l; l = g_list_next(l)) {
         auto* gjs = static_cast<GjsContextPrivate*>(l->data);
-        js::DumpHeap(gjs->context(), fp, js::IgnoreNurseryObjects);
+        if (!dump_heap_snapshot)
+            js::DumpHeap(gjs->context(), fp, js::IgnoreNurseryObjects);
+        else if (!gjs_write_heap_snapshot(gjs->context(), fp))
+            g_warning("Failed to write heap snapshot to %s", filename.get());
     }
 
     fclose(fp);
@@ -186,6 +200,8 @@ setup_dump_heap(void)
             struct sigaction sa;
 
             dump_heap_output = g_strdup(heap_output);
+            dump_heap_snapshot =
+                g_strcmp0(g_getenv("GJS_DEBUG_HEAP_FORMAT"), "binary") == 0;
 
             memset(&sa, 0, sizeof(sa));
             sa.sa_handler = dump_heap_signal_handler;
@@ -272,6 +288,78 @@ gjs_context_class_init(GjsContextClass *klass)
     g_object_class_install_property(object_class, PROP_PROFILER_SIGUSR2, pspec);
     g_param_spec_unref(pspec);
 
+    /**
+     * GjsContext:gc-check-interval:
+     *
+     * Interval, in milliseconds, at which the context checks whether a garbage
+     * collection is needed, in addition to the collections that the JS engine
+     * schedules by itself. 0 means the default, 10 seconds.
+     *
+     * The value of this property is superseded by the GJS_GC_CHECK_INTERVAL
+     * environment variable.
+     */
+    pspec = g_param_spec_uint("gc-check-interval", "GC check interval",
+                              "Milliseconds between checks for garbage", 0,
+                              G_MAXUINT, 0,
+                              GParamFlags(G_PARAM_WRITABLE | G_PARAM_CONSTRUCT_ONLY));
+    g_object_class_install_property(object_class, PROP_GC_CHECK_INTERVAL, pspec);
+    g_param_spec_unref(pspec);
+
+    /**
+     * GjsContext:gc-slice-budget:
+     *
+     * Maximum time, in milliseconds, that one slice of an incremental garbage
+     * collection started by the context may take. 0 means the default, 10
+     * milliseconds.
+     *
+     * The value of this property is superseded by the GJS_GC_SLICE_BUDGET
+     * environment variable.
+     */
+    pspec = g_param_spec_uint("gc-slice-budget", "GC slice budget",
+                              "Milliseconds per incremental GC slice", 0,
+                              G_MAXUINT, 0,
+                              GParamFlags(G_PARAM_WRITABLE | G_PARAM_CONSTRUCT_ONLY));
+    g_object_class_install_property(object_class, PROP_GC_SLICE_BUDGET, pspec);
+    g_param_spec_unref(pspec);
+
+    /**
+     * GjsContext:gc-toggle-threshold:
+     *
+     * Estimated number of GObject wrappers, among those that lost their last
+     * reference from C, that a garbage collection would clean up, before the
+     * context starts one. The estimate is based on how many such wrappers
+     * previous collections cleaned up. 0 means the default, 32.
+     *
+     * The value of this property is superseded by the GJS_GC_TOGGLE_THRESHOLD
+     * environment variable.
+     */
+    pspec = g_param_spec_uint("gc-toggle-threshold", "GC toggle threshold",
+                              "Wrappers toggled down before collecting", 0,
+                              G_MAXUINT, 0,
+                              GParamFlags(G_PARAM_WRITABLE | G_PARAM_CONSTRUCT_ONLY));
+    g_object_class_install_property(object_class, PROP_GC_TOGGLE_THRESHOLD,
+                                    pspec);
+    g_param_spec_unref(pspec);
+
+    /**
+     * GjsContext:gc-incremental-threshold:
+     *
+     * Size of the JS heap, in MiB, above which garbage collections started by
+     * the context are always incremental. Smaller heaps are collected all at
+     * once if the main loop is idle. 0 means the default, 32 MiB.
+     *
+     * The value of this property is superseded by the
+     * GJS_GC_INCREMENTAL_THRESHOLD environment variable.
+     */
+    pspec = g_param_spec_uint("gc-incremental-threshold",
+                              "GC incremental threshold",
+                              "JS heap MiB above which GC is incremental", 0,
+                              G_MAXUINT, 0,
+                              GParamFlags(G_PARAM_WRITABLE | G_PARAM_CONSTRUCT_ONLY));
+    g_object_class_install_property(object_class,
+                                    PROP_GC_INCREMENTAL_THRESHOLD, pspec);
+    g_param_spec_unref(pspec);
+
     /* For GjsPrivate */
     {
 #ifdef G_OS_WIN32
@@ -355,6 +443,7 @@ void GjsContextPrivate::dispose(void) {
         gjs_debug(GJS_DEBUG_CONTEXT, "Releasing cached JS wrappers");
         m_fundamental_table->clear();
         m_gtype_table->clear();
+        m_static_strings.clear();
 
         /* Do a full GC here before tearing down, since once we do
          * that we may not have the JS_GetPrivate() to access the
@@ -363,6 +452,13 @@ void GjsContextPrivate::dispose(void) {
         gjs_debug(GJS_DEBUG_CONTEXT, "Final triggered GC");
         JS_GC(m_cx);
 
+        m_module_prefetcher.cancel_all(m_cx);
+        m_bytecode_cache.trim();
+
+        gjs_debug(GJS_DEBUG_CONTEXT, "Import path cache: %u hits, %u misses",
+                  m_import_path_cache.hits(), m_import_path_cache.misses());
+        m_import_path_cache.clear();
+
         gjs_debug(GJS_DEBUG_CONTEXT, "Destroying JS context");
         m_destroying = true;
 
@@ -378,6 +474,17 @@ void GjsContextPrivate::dispose(void) {
             g_source_remove(m_auto_gc_id);
             m_auto_gc_id = 0;
         }
+        (void)set_gc_frame_clock(nullptr);
+#if GLIB_CHECK_VERSION(2, 64, 0)
+        if (m_memory_monitor_id > 0) {
+            g_source_remove(m_memory_monitor_id);
+            m_memory_monitor_id = 0;
+        }
+        if (m_memory_monitor) {
+            g_signal_handlers_disconnect_by_data(m_memory_monitor, this);
+            m_memory_monitor = nullptr;
+        }
+#endif
 
         gjs_debug(GJS_DEBUG_CONTEXT, "Ending trace on global object");
         JS_RemoveExtraGCRootsTracer(m_cx, &GjsContextPrivate::trace, this);
@@ -445,6 +552,7 @@ GjsContextPrivate::GjsContextPrivate(JSContext* cx, GjsContext* public_context)
       m_cx(cx),
       m_environment_preparer(cx) {
     m_owner_thread = g_thread_self();
+    m_gc_policy.configure(m_gc_config);
 
     const char *env_profiler = g_getenv("GJS_ENABLE_PROFILER");
     if (env_profiler || m_should_listen_sigusr2)
@@ -506,6 +614,11 @@ GjsContextPrivate::GjsContextPrivate(JSContext* cx, GjsContext* public_context)
         gjs_log_exception(m_cx);
         g_error("Failed to define properties on global object");
     }
+
+#if GLIB_CHECK_VERSION(2, 64, 0)
+    m_memory_monitor_id =
+        g_idle_add_full(G_PRIORITY_LOW, watch_memory_monitor, this, nullptr);
+#endif
 }
 
 static void
@@ -547,6 +660,18 @@ gjs_context_set_property (GObject      *object,
     case PROP_PROFILER_SIGUSR2:
         gjs->set_should_listen_sigusr2(g_value_get_boolean(value));
         break;
+    case PROP_GC_CHECK_INTERVAL:
+        gjs->gc_config().check_interval_ms = g_value_get_uint(value);
+        break;
+    case PROP_GC_SLICE_BUDGET:
+        gjs->gc_config().slice_budget_ms = g_value_get_uint(value);
+        break;
+    case PROP_GC_TOGGLE_THRESHOLD:
+        gjs->gc_config().toggle_threshold = g_value_get_uint(value);
+        break;
+    case PROP_GC_INCREMENTAL_THRESHOLD:
+        gjs->gc_config().incremental_threshold_mb = g_value_get_uint(value);
+        break;
     default:
         G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
         break;
@@ -572,43 +697,219 @@ gboolean GjsContextPrivate::trigger_gc_if_needed(void* data) {
     auto* gjs = static_cast<GjsContextPrivate*>(data);
     gjs->m_auto_gc_id = 0;
 
-    if (gjs->m_force_gc) {
-        gjs_debug_lifecycle(GJS_DEBUG_CONTEXT, "Big Hammer hit");
-        JS_GC(gjs->m_cx);
-    } else {
-        gjs_gc_if_needed(gjs->m_cx);
-    }
-    gjs->m_force_gc = false;
+    // With a frame clock, the UI may be animating, so never stop the world
+    // for a whole collection
+    bool main_loop_idle =
+        !gjs->m_gc_frame_clock && !g_main_context_pending(nullptr);
+    GjsGCPolicy::Decision decision =
+        gjs->m_gc_policy.decide(gjs->m_cx, main_loop_idle);
+    gjs_debug_lifecycle(GJS_DEBUG_CONTEXT, "GC policy decided: %s",
+                        GjsGCPolicy::decision_name(decision));
+
+    if (gjs->m_gc_policy.run(gjs->m_cx, decision, gjs->m_profiler))
+        gjs->schedule_gc_slice();
+    else if (gjs->m_gc_policy.has_toggled_down_wrappers())
+        gjs->schedule_gc_check();  // look again later, even if no more come
 
     return G_SOURCE_REMOVE;
 }
 
-void GjsContextPrivate::schedule_gc_internal(bool force_gc) {
-    m_force_gc |= force_gc;
+// If no frame is painted within this many milliseconds, run the next slice
+// anyway so that the collection doesn't stall while the UI is static
+static const unsigned GC_FRAME_FALLBACK_MS = 100;
 
+/*
+ * GjsContextPrivate::schedule_gc_slice:
+ *
+ * Schedules the next slice of an incremental GC that is in progress. Without a
+ * frame clock, the slice runs as soon as the main loop has nothing else to do.
+ * With one, it runs right after the next frame is painted, so that GC pauses
+ * fall in the time between frames instead of delaying one.
+ */
+void GjsContextPrivate::schedule_gc_slice(void) {
+    // A check may have been scheduled during the GC, e.g. by a finalizer; the
+    // slice replaces it
     if (m_auto_gc_id > 0)
+        g_source_remove(m_auto_gc_id);
+
+    if (m_gc_frame_clock)
+        m_auto_gc_id =
+            g_timeout_add_full(G_PRIORITY_LOW, GC_FRAME_FALLBACK_MS,
+                               trigger_gc_if_needed, this, nullptr);
+    else
+        m_auto_gc_id = g_idle_add_full(G_PRIORITY_LOW, trigger_gc_if_needed,
+                                       this, nullptr);
+}
+
+void GjsContextPrivate::on_gc_frame_clock_after_paint(GObject*, void* data) {
+    auto* gjs = static_cast<GjsContextPrivate*>(data);
+    if (gjs->m_destroying || !JS::IsIncrementalGCInProgress(gjs->m_cx))
         return;
 
-    if (force_gc)
-        gjs_debug_lifecycle(GJS_DEBUG_CONTEXT, "Big Hammer scheduled");
+    if (gjs->m_auto_gc_id > 0)
+        g_source_remove(gjs->m_auto_gc_id);
+    trigger_gc_if_needed(gjs);
+}
 
-    m_auto_gc_id = g_timeout_add_seconds_full(G_PRIORITY_LOW, 10,
-                                              trigger_gc_if_needed, this,
-                                              nullptr);
+void GjsContextPrivate::on_gc_frame_clock_finalized(void* data, GObject*) {
+    auto* gjs = static_cast<GjsContextPrivate*>(data);
+    gjs->m_gc_frame_clock = nullptr;
+    gjs->m_gc_after_paint_id = 0;
+}
+
+/*
+ * GjsContextPrivate::set_gc_frame_clock:
+ * @frame_clock: (nullable): an object with an "after-paint" signal, such as a
+ *   GdkFrameClock or a ClutterStage, or %NULL
+ *
+ * Aligns the slices of incremental garbage collections to the painting of
+ * frames by @frame_clock, instead of running them from idle time. Passing
+ * %NULL goes back to idle time. The frame clock is not kept alive.
+ *
+ * Returns: false if @frame_clock has no "after-paint" signal.
+ */
+bool GjsContextPrivate::set_gc_frame_clock(GObject* frame_clock) {
+    if (frame_clock &&
+        !g_signal_lookup("after-paint", G_OBJECT_TYPE(frame_clock)))
+        return false;
+
+    if (m_gc_frame_clock) {
+        g_signal_handler_disconnect(m_gc_frame_clock, m_gc_after_paint_id);
+        g_object_weak_unref(m_gc_frame_clock, on_gc_frame_clock_finalized,
+                            this);
+        m_gc_frame_clock = nullptr;
+        m_gc_after_paint_id = 0;
+    }
+
+    if (frame_clock) {
+        m_gc_frame_clock = frame_clock;
+        m_gc_after_paint_id = g_signal_connect(
+            frame_clock, "after-paint",
+            G_CALLBACK(on_gc_frame_clock_after_paint), this);
+        g_object_weak_ref(frame_clock, on_gc_frame_clock_finalized, this);
+    }
+
+    return true;
+}
+
+void GjsContextPrivate::schedule_gc_check(void) {
+    if (m_auto_gc_id > 0)
+        return;
+
+    m_auto_gc_id = g_timeout_add_full(
+        G_PRIORITY_LOW, m_gc_policy.check_interval_ms(), trigger_gc_if_needed,
+        this, nullptr);
+}
+
+/*
+ * GjsContextPrivate::note_wrapper_toggled_down:
+ *
+ * Tells the GC policy that a GObject wrapper is no longer kept alive from C,
+ * and so may be garbage. Toggle-downs are batched; only the first one of a
+ * batch schedules a check, which then looks at the whole batch.
+ */
+void GjsContextPrivate::note_wrapper_toggled_down(void) {
+    if (m_gc_policy.note_wrapper_toggled_down())
+        schedule_gc_check();
+}
+
+#if GLIB_CHECK_VERSION(2, 64, 0)
+gboolean GjsContextPrivate::watch_memory_monitor(void* data) {
+    auto* gjs = static_cast<GjsContextPrivate*>(data);
+    gjs->m_memory_monitor_id = 0;
+
+    gjs->m_memory_monitor = g_memory_monitor_dup_default();
+    g_signal_connect(gjs->m_memory_monitor, "low-memory-warning",
+                     G_CALLBACK(on_low_memory_warning), gjs);
+    return G_SOURCE_REMOVE;
+}
+
+void GjsContextPrivate::on_low_memory_warning(GMemoryMonitor*,
+                                              GMemoryMonitorWarningLevel level,
+                                              void* data) {
+    auto* gjs = static_cast<GjsContextPrivate*>(data);
+    gjs_debug(GJS_DEBUG_CONTEXT, "Low memory warning, level %d", level);
+    gjs->release_memory();
+}
+#endif
+
+/*
+ * GjsContextPrivate::release_memory:
+ *
+ * Drops everything that GJS keeps around only to be faster, and runs a
+ * shrinking garbage collection so that memory held by garbage, including
+ * GObjects kept alive by their wrappers, is returned to the system. Called
+ * when the system warns that memory is low.
+ *
+ * Returns: the number of bytes that the process's resident memory shrank by,
+ * or, where that can't be measured, that the JS heap shrank by.
+ */
+size_t GjsContextPrivate::release_memory(void) {
+    if (m_destroying)
+        return 0;
+
+    int64_t begin_time = g_get_monotonic_time();
+    uint64_t rss_before = gjs_get_process_rss();
+    uint32_t heap_before = JS_GetGCParameter(m_cx, JSGC_BYTES);
+
+    // Unroot wrappers of objects that have been released from C, so that
+    // this collection can already get rid of them
+    gjs_object_clear_toggles();
+    gjs_function_clear_async_closures();
+    // Modules compiled in the background for imports that haven't happened
+    // yet are compiled again if they do
+    size_t n_cache_entries = ObjectPrototype::release_all_caches() +
+                             BoxedPrototype::release_all_field_maps() +
+                             m_import_path_cache.clear() +
+                             m_module_prefetcher.cancel_all(m_cx);
+
+    JS::PrepareForFullGC(m_cx);
+    JS::NonIncrementalGC(m_cx, GC_SHRINK, JS::GCReason::MEM_PRESSURE);
+
+#ifdef __GLIBC__
+    // Give the pages freed by the collection back to the system
+    malloc_trim(0);
+#endif
+
+    uint64_t rss_after = gjs_get_process_rss();
+    uint32_t heap_after = JS_GetGCParameter(m_cx, JSGC_BYTES);
+    size_t released;
+    if (rss_before > 0)
+        released = rss_before > rss_after ? rss_before - rss_after : 0;
+    else
+        released = heap_before > heap_after ? heap_before - heap_after : 0;
+
+    gjs_debug(GJS_DEBUG_CONTEXT,
+              "Released %zu bytes: dropped %zu cache entries, JS heap went "
+              "from %u to %u bytes",
+              released, n_cache_entries, heap_before, heap_after);
+
+    if (m_profiler && _gjs_profiler_is_running(m_profiler)) {
+        int64_t now = g_get_monotonic_time();
+        GjsAutoChar message = g_strdup_printf(
+            "Released %zu bytes, %zu cache entries", released, n_cache_entries);
+        _gjs_profiler_add_mark(m_profiler, begin_time * 1000L,
+                               (now - begin_time) * 1000L, "GJS",
+                               "Release memory", message);
+    }
+
+    return released;
 }
 
 /*
  * GjsContextPrivate::schedule_gc_if_needed:
  *
  * Does a minor GC immediately if the JS engine decides one is needed, but also
- * schedules a full GC in the next idle time.
+ * schedules a check with the GC policy in the next idle time.
  */
 void GjsContextPrivate::schedule_gc_if_needed(void) {
     // We call JS_MaybeGC immediately, but defer a check for a full GC cycle
-    // to an idle handler.
-    JS_MaybeGC(m_cx);
+    // to an idle handler. While an incremental GC is in progress, its slices
+    // are already scheduled.
+    if (!JS::IsIncrementalGCInProgress(m_cx))
+        JS_MaybeGC(m_cx);
 
-    schedule_gc_internal(false);
+    schedule_gc_check();
 }
 
 void GjsContextPrivate::set_sweeping(bool value) {
@@ -928,6 +1229,14 @@ bool GjsContextPrivate::eval(const char* script, ssize_t script_len,
     if (auto_profile)
         gjs_profiler_start(m_profiler);
 
+    // Whatever a program imports is likely to miss the bytecode cache if the
+    // program itself does, so compile it in the background while the program
+    // compiles and starts running
+    size_t len = script_len < 0 ? strlen(script) : script_len;
+    GjsAutoChar path = g_canonicalize_filename(filename, nullptr);
+    if (!m_bytecode_cache.has_entry(path, script, len))
+        m_module_prefetcher.prefetch_imports(m_cx, script, len);
+
     JS::RootedValue retval(m_cx);
     bool ok = eval_with_scope(nullptr, script, script_len, filename, &retval);
 
@@ -1032,15 +1341,6 @@ bool GjsContextPrivate::eval_with_scope(JS::HandleObject scope_object,
     if (!eval_obj)
         eval_obj = JS_NewPlainObject(m_cx);
 
-    std::u16string utf16_string = gjs_utf8_script_to_utf16(script, script_len);
-    // COMPAT: This could use JS::SourceText<mozilla::Utf8Unit> directly,
-    // but that messes up code coverage. See bug
-    // https://bugzilla.mozilla.org/show_bug.cgi?id=1404784
-    JS::SourceText<char16_t> buf;
-    if (!buf.init(m_cx, utf16_string.c_str(), utf16_string.size(),
-                  JS::SourceOwnership::Borrowed))
-        return false;
-
     JS::RootedObjectVector scope_chain(m_cx);
     if (!scope_chain.append(eval_obj)) {
         JS_ReportOutOfMemory(m_cx);
@@ -1050,14 +1350,19 @@ bool GjsContextPrivate::eval_with_scope(JS::HandleObject scope_object,
     JS::CompileOptions options(m_cx);
     options.setFileAndLine(filename, 1);
 
-    if (!JS::Evaluate(m_cx, scope_chain, options, buf, retval))
+    // If @filename doesn't name a file, the script is just not cached
+    GjsAutoChar path = g_canonicalize_filename(filename, nullptr);
+    JS::RootedScript compiled(
+        m_cx,
+        m_bytecode_cache.compile(m_cx, options, path, script, script_len));
+    if (!compiled || !JS_ExecuteScript(m_cx, scope_chain, compiled, retval))
         return false;
 
     schedule_gc_if_needed();
 
     if (JS_IsExceptionPending(m_cx)) {
         g_warning(
-            "JS::Evaluate() returned true but exception was pending; "
+            "JS_ExecuteScript() returned true but exception was pending; "
             "did somebody call gjs_throw() without returning false?");
         return false;
     }
@@ -24,6 +24,7 @@
 #include <jsfriendapi.h>  // for GetCodeCoverageSummary
 
 #include "gjs/atoms.h"
+#include "gjs/bytecode-cache.h"
 #include "gjs/context-private.h"
 #include "gjs/context.h"
 #include "gjs/coverage.h"
@@ -498,4 +499,6 @@ gjs_coverage_new (const char * const *prefixes,
 void gjs_coverage_enable() {
     js::EnableCodeCoverage();
     s_coverage_enabled = true;
+    // Scripts must be compiled from source to be instrumented
+    GjsBytecodeCache::disable();
 }
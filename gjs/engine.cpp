@@ -84,8 +84,13 @@ static void gjs_finalize_callback(JSFreeOp*, JSFinalizeStatus status,
         gjs->set_sweeping(false);
 }
 
-static void on_garbage_collect(JSContext*, JSGCStatus status, JS::GCReason,
-                               void*) {
+static void on_garbage_collect(JSContext* cx, JSGCStatus status, JS::GCReason,
+                               void* data) {
+    auto* gjs = static_cast<GjsContextPrivate*>(data);
+
+    // These are called for every slice of an incremental collection
+    bool cycle_in_progress = JS::IsIncrementalGCInProgress(cx);
+
     /* We finalize any pending toggle refs before doing any garbage collection,
      * so that we can collect the JS wrapper objects, and in order to minimize
      * the chances of objects having a pending toggle up queued when they are
@@ -94,8 +99,13 @@ static void on_garbage_collect(JSContext*, JSGCStatus status, JS::GCReason,
         gjs_debug_lifecycle(GJS_DEBUG_CONTEXT, "Begin garbage collection");
         gjs_object_clear_toggles();
         gjs_function_clear_async_closures();
+        if (!cycle_in_progress)
+            gjs->gc_policy().note_collection_started();
     } else if (status == JSGC_END) {
         gjs_debug_lifecycle(GJS_DEBUG_CONTEXT, "End garbage collection");
+        if (!cycle_in_progress)
+            gjs->gc_policy().note_collection_finished(
+                ObjectInstance::take_num_wrappers_collected());
     }
 }
 
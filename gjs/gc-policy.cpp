@@ -0,0 +1,247 @@
+/* -*- mode: C++; c-basic-offset: 4; indent-tabs-mode: nil; -*- */
+// SPDX-License-Identifier: MIT OR LGPL-2.0-or-later
+// SPDX-FileCopyrightText: 2020 GNOME Foundation
+
+#include <config.h>
+
+#include <stdint.h>
+#include <stdlib.h>  // for strtoul
+
+#include <algorithm>  // for max, min
+
+#include <glib.h>
+
+#include <js/GCAPI.h>  // for IsIncrementalGCInProgress, StartIncrementalGC
+#include <jsapi.h>     // for JS_GetGCParameter
+
+#include "gjs/gc-policy.h"
+#include "gjs/jsapi-util.h"
+#include "gjs/profiler-private.h"
+#include "util/log.h"
+
+// Toggled-down wrappers that the estimate says aren't worth a collection are
+// collected anyway after this many check intervals. This also measures the
+// reclaim ratio again, in case it has gone up.
+static constexpr unsigned STALE_CHECK_INTERVALS = 6;
+
+static void override_from_env(unsigned* value, const char* env_name) {
+    const char* env_value = g_getenv(env_name);
+    if (!env_value)
+        return;
+
+    char* end;
+    unsigned long parsed = strtoul(env_value, &end, 10);  // NOLINT(runtime/int)
+    if (*env_value == '\0' || *end != '\0' || parsed > G_MAXUINT) {
+        g_warning("Ignoring invalid value '%s' for %s", env_value, env_name);
+        return;
+    }
+    *value = parsed;
+}
+
+void GjsGCPolicy::configure(const GjsGCPolicy::Config& config) {
+    if (config.check_interval_ms)
+        m_config.check_interval_ms = config.check_interval_ms;
+    if (config.slice_budget_ms)
+        m_config.slice_budget_ms = config.slice_budget_ms;
+    if (config.toggle_threshold)
+        m_config.toggle_threshold = config.toggle_threshold;
+    if (config.incremental_threshold_mb)
+        m_config.incremental_threshold_mb = config.incremental_threshold_mb;
+
+    override_from_env(&m_config.check_interval_ms, "GJS_GC_CHECK_INTERVAL");
+    override_from_env(&m_config.slice_budget_ms, "GJS_GC_SLICE_BUDGET");
+    override_from_env(&m_config.toggle_threshold, "GJS_GC_TOGGLE_THRESHOLD");
+    override_from_env(&m_config.incremental_threshold_mb,
+                      "GJS_GC_INCREMENTAL_THRESHOLD");
+
+    // Zero would mean checking in a busy loop, or slices that do nothing
+    if (m_config.check_interval_ms == 0)
+        m_config.check_interval_ms = 1;
+    if (m_config.slice_budget_ms == 0)
+        m_config.slice_budget_ms = 1;
+}
+
+const char* GjsGCPolicy::decision_name(GjsGCPolicy::Decision decision) {
+    switch (decision) {
+        case Decision::NONE:
+            return "none";
+        case Decision::MINOR:
+            return "minor";
+        case Decision::INCREMENTAL_SLICE:
+            return "incremental slice";
+        case Decision::FULL:
+            return "full";
+        default:
+            g_assert_not_reached();
+    }
+}
+
+GjsGCPolicy::Decision GjsGCPolicy::decide(JSContext* cx, bool main_loop_idle) {
+    return decide({JS::IsIncrementalGCInProgress(cx),
+                   JS_GetGCParameter(cx, JSGC_BYTES), gjs_get_process_rss(),
+                   g_get_monotonic_time()},
+                  main_loop_idle);
+}
+
+GjsGCPolicy::Decision GjsGCPolicy::decide(const GjsGCPolicy::Sample& sample,
+                                          bool main_loop_idle) {
+    // Once started, an incremental collection has to be driven to the end.
+    // The batch still ends here, so that the next toggle-down schedules a
+    // check; otherwise, after a collection that SpiderMonkey started, they
+    // would stop doing so.
+    if (sample.collection_in_progress) {
+        m_last_batch = m_batch;
+        m_batch = 0;
+        return Decision::INCREMENTAL_SLICE;
+    }
+
+    uint64_t heap_bytes = sample.heap_bytes;
+    uint64_t rss = sample.rss;
+    int64_t now = sample.time;
+
+    bool heap_grew = heap_bytes > m_heap_bytes_at_last_check;
+    int64_t elapsed_us = now - m_last_check_time;
+    if (m_last_collection_time == 0)
+        m_last_collection_time = now;
+
+    // Close the batch of toggle-downs since the last check
+    double batch_rate = m_batch * 1e6 / std::max(elapsed_us, int64_t(1));
+    bool accelerating =
+        m_last_check_time != 0 && m_batch > 0 && batch_rate > m_toggle_rate;
+    m_toggle_rate = (m_toggle_rate + batch_rate) / 2;
+    m_last_batch = m_batch;
+    m_batch = 0;
+
+    unsigned collectable = estimated_collectable_wrappers();
+    gjs_debug_lifecycle(
+        GJS_DEBUG_CONTEXT, "GC policy: JS heap %" G_GUINT64_FORMAT
+        " bytes, grew %" G_GINT64_FORMAT " bytes in %" G_GINT64_FORMAT
+        " us; RSS %" G_GUINT64_FORMAT " bytes; %u wrapper(s) toggled down, "
+        "%u in the last batch (%.1f/s), about %u collectable",
+        heap_bytes, int64_t(heap_bytes - m_heap_bytes_at_last_check),
+        elapsed_us, rss, m_toggled_down, m_last_batch, batch_rate,
+        collectable);
+    m_heap_bytes_at_last_check = heap_bytes;
+    m_last_check_time = now;
+
+    int64_t stale_us = int64_t(m_config.check_interval_ms) * 1000 *
+                       STALE_CHECK_INTERVALS;
+    bool stale = m_toggled_down > 0 && now - m_last_collection_time >= stale_us;
+    bool churn = collectable >= m_config.toggle_threshold || stale;
+
+    // Malloc memory from C libraries is invisible to the JS engine's own
+    // heuristics, but shows up in RSS
+    bool rss_grew = rss > m_rss_trigger;
+    if (rss_grew) {
+        m_rss_trigger = rss * 5 / 4;
+    } else if (rss < m_rss_trigger / 2) {
+        // Memory was released by something else; lower the trigger
+        m_rss_trigger = rss * 5 / 4;
+    }
+
+    if (!churn && !rss_grew)
+        return heap_grew ? Decision::MINOR : Decision::NONE;
+
+    // If a lot of wrappers are being toggled down, for example because a big
+    // part of the UI is being destroyed, and it's still speeding up, wait for
+    // one more batch so that one collection gets all of them
+    if (!rss_grew && accelerating && !m_deferred) {
+        m_deferred = true;
+        return heap_grew ? Decision::MINOR : Decision::NONE;
+    }
+    m_deferred = false;
+
+    m_shrink = rss_grew;
+
+    uint64_t incremental_threshold =
+        uint64_t(m_config.incremental_threshold_mb) * 1024 * 1024;
+    if (main_loop_idle && heap_bytes < incremental_threshold)
+        return Decision::FULL;
+    return Decision::INCREMENTAL_SLICE;
+}
+
+void GjsGCPolicy::note_collection_started(void) {
+    m_toggled_down_before_collection = m_toggled_down;
+    m_toggled_down = 0;
+}
+
+void GjsGCPolicy::note_collection_finished(size_t wrappers_collected) {
+    m_last_collection_time = g_get_monotonic_time();
+    if (m_toggled_down_before_collection == 0)
+        return;
+
+    // Wrappers that were never toggled up are collected too, so this can be
+    // more than 1
+    double ratio = std::min(
+        1.0, double(wrappers_collected) / m_toggled_down_before_collection);
+    m_reclaim_ratio = (m_reclaim_ratio + ratio) / 2;
+    m_toggled_down_before_collection = 0;
+
+    gjs_debug_lifecycle(GJS_DEBUG_CONTEXT,
+                        "GC policy: %zu wrapper(s) collected, reclaim ratio "
+                        "now %.2f",
+                        wrappers_collected, m_reclaim_ratio);
+}
+
+bool GjsGCPolicy::run(JSContext* cx, GjsGCPolicy::Decision decision,
+                      GjsProfiler* profiler) {
+    if (profiler && _gjs_profiler_is_running(profiler)) {
+        int64_t now_ns = g_get_monotonic_time() * 1000L;
+        _gjs_profiler_set_counter(profiler, now_ns,
+                                  GJS_COUNTER_TOGGLE_DOWN_BATCH, m_last_batch);
+        _gjs_profiler_set_counter(profiler, now_ns,
+                                  GJS_COUNTER_TOGGLE_DOWN_RATE,
+                                  int64_t(m_toggle_rate));
+        _gjs_profiler_set_counter(profiler, now_ns,
+                                  GJS_COUNTER_COLLECTABLE_WRAPPERS,
+                                  estimated_collectable_wrappers());
+    }
+
+    if (decision == Decision::NONE)
+        return false;
+
+    int64_t begin_time = g_get_monotonic_time();
+    JSGCInvocationKind kind = m_shrink ? GC_SHRINK : GC_NORMAL;
+    unsigned toggled_down = m_toggled_down;
+
+    switch (decision) {
+        case Decision::MINOR:
+            JS_MaybeGC(cx);
+            break;
+        case Decision::INCREMENTAL_SLICE:
+            if (JS::IsIncrementalGCInProgress(cx)) {
+                JS::PrepareForIncrementalGC(cx);
+                JS::IncrementalGCSlice(cx, JS::GCReason::API,
+                                       m_config.slice_budget_ms);
+            } else {
+                JS::PrepareForFullGC(cx);
+                JS::StartIncrementalGC(cx, kind, JS::GCReason::API,
+                                       m_config.slice_budget_ms);
+            }
+            break;
+        case Decision::FULL:
+            JS::PrepareForFullGC(cx);
+            JS::NonIncrementalGC(cx, kind, JS::GCReason::API);
+            break;
+        default:
+            g_assert_not_reached();
+    }
+
+    bool in_progress = JS::IsIncrementalGCInProgress(cx);
+    if (!in_progress)
+        m_shrink = false;
+
+    if (profiler && _gjs_profiler_is_running(profiler)) {
+        int64_t now = g_get_monotonic_time();
+        GjsAutoChar message = g_strdup_printf(
+            "%s%s: %u wrapper(s) toggled down, JS heap %u bytes%s",
+            decision_name(decision), kind == GC_SHRINK ? " (shrinking)" : "",
+            toggled_down, JS_GetGCParameter(cx, JSGC_BYTES),
+            in_progress ? ", more slices to go" : "");
+        _gjs_profiler_add_mark(profiler, begin_time * 1000L,
+                               (now - begin_time) * 1000L, "GJS",
+                               "GC policy", message);
+    }
+
+    return in_progress;
+}
@@ -0,0 +1,141 @@
+/* -*- mode: C++; c-basic-offset: 4; indent-tabs-mode: nil; -*- */
+// SPDX-License-Identifier: MIT OR LGPL-2.0-or-later
+// SPDX-FileCopyrightText: 2020 GNOME Foundation
+
+#ifndef GJS_GC_POLICY_H_
+#define GJS_GC_POLICY_H_
+
+#include <config.h>
+
+#include <stddef.h>  // for size_t
+#include <stdint.h>
+
+#include <js/TypeDecls.h>
+
+#include "gjs/profiler.h"
+
+/*
+ * GjsGCPolicy:
+ *
+ * Decides what kind of garbage collection GJS should trigger, on top of the
+ * collections that SpiderMonkey schedules by itself. GjsContextPrivate asks
+ * the policy periodically, from a low-priority main loop source, and whenever
+ * a wrapped GObject is toggled down.
+ *
+ * The decision is based on:
+ *  - how fast the JS heap has been growing since the last check,
+ *  - how many GObject wrappers were toggled down (and so may now be garbage)
+ *    since the last collection, scaled by how many of the wrappers toggled
+ *    down before previous collections were actually collected by them,
+ *  - how much the process's resident memory, which includes memory allocated
+ *    with malloc() by C libraries, has grown since the last collection,
+ *  - and whether the main loop has other work pending.
+ *
+ * Small heaps are collected all at once. Large heaps, or any heap while the
+ * main loop is busy, are collected incrementally in time-limited slices.
+ */
+class GjsGCPolicy {
+ public:
+    enum class Decision {
+        NONE,
+        // Let SpiderMonkey collect whatever has crossed its own thresholds;
+        // normally only the nursery
+        MINOR,
+        // Start or continue an incremental collection, for one slice
+        INCREMENTAL_SLICE,
+        // Collect everything now, without yielding
+        FULL,
+    };
+
+    // All values are "use the default" when zero, so that this can be filled
+    // in from construct properties before the policy exists
+    struct Config {
+        // Interval between checks, in milliseconds
+        unsigned check_interval_ms;
+        // Time budget of an incremental slice, in milliseconds
+        unsigned slice_budget_ms;
+        // Estimated number of collectable toggled-down wrappers that triggers
+        // a collection
+        unsigned toggle_threshold;
+        // JS heap size above which collections are always incremental, in MiB
+        unsigned incremental_threshold_mb;
+    };
+
+ private:
+    Config m_config = {10'000, 10, 32, 32};
+
+    // Toggle-downs are counted in batches, one per check. They are collected
+    // by the next collection, whoever starts it.
+    unsigned m_toggled_down = 0;  // since the last collection started
+    unsigned m_toggled_down_before_collection = 0;
+    unsigned m_batch = 0;  // since the last check
+    unsigned m_last_batch = 0;
+    double m_toggle_rate = 0.0;  // per second, smoothed over several checks
+    // Fraction of toggled-down wrappers that the last collections collected;
+    // low if toggled-down objects tend to still be used from JS
+    double m_reclaim_ratio = 1.0;
+
+    uint64_t m_heap_bytes_at_last_check = 0;
+    int64_t m_last_check_time = 0;
+    int64_t m_last_collection_time = 0;
+    // A collection is triggered when RSS grows above this; 0 means that the
+    // first check always collects
+    uint64_t m_rss_trigger = 0;
+    bool m_shrink : 1;
+    // Whether the last check put off a collection because toggle-downs were
+    // still coming in faster and faster
+    bool m_deferred : 1;
+
+ public:
+    GjsGCPolicy() : m_shrink(false), m_deferred(false) {}
+
+    // Overrides the defaults with the non-zero values from @config, and then
+    // with the GJS_GC_* environment variables
+    void configure(const Config& config);
+
+    [[nodiscard]] unsigned check_interval_ms() const {
+        return m_config.check_interval_ms;
+    }
+    [[nodiscard]] unsigned slice_budget_ms() const {
+        return m_config.slice_budget_ms;
+    }
+
+    // Returns true for the first toggle-down of a batch; the caller should then
+    // make sure that a check is scheduled
+    bool note_wrapper_toggled_down(void) {
+        m_toggled_down++;
+        return m_batch++ == 0;
+    }
+    [[nodiscard]] bool has_toggled_down_wrappers(void) const {
+        return m_toggled_down > 0;
+    }
+    [[nodiscard]] unsigned estimated_collectable_wrappers(void) const {
+        return unsigned(m_toggled_down * m_reclaim_ratio);
+    }
+
+    // Called at the start and end of every major collection, including those
+    // that SpiderMonkey starts by itself
+    void note_collection_started(void);
+    void note_collection_finished(size_t wrappers_collected);
+
+    // What a decision is based on, besides the toggle-down counts
+    struct Sample {
+        bool collection_in_progress;
+        uint64_t heap_bytes;
+        uint64_t rss;
+        int64_t time;  // g_get_monotonic_time()
+    };
+
+    [[nodiscard]] Decision decide(JSContext* cx, bool main_loop_idle);
+    // Same, with the state of the heap and process given; for testing
+    [[nodiscard]] Decision decide(const Sample& sample, bool main_loop_idle);
+
+    // Carries out @decision, and reports the toggle-down statistics to the
+    // profiler. Returns true if an incremental collection is still in progress
+    // afterwards, and so the caller should schedule another slice.
+    bool run(JSContext* cx, Decision decision, GjsProfiler* profiler);
+
+    [[nodiscard]] static const char* decision_name(Decision decision);
+};
+
+#endif  // GJS_GC_POLICY_H_
@@ -28,6 +28,7 @@
 #include <jsapi.h>       // for AutoSaveExceptionState, ...
 
 #include "gjs/atoms.h"
+#include "gjs/bytecode-cache.h"
 #include "gjs/context-private.h"
 #include "gjs/engine.h"
 #include "gjs/global.h"
@@ -87,19 +88,24 @@ class GjsBaseGlobal {
         JS::CompileOptions options(cx);
         options.setFileAndLine(uri, 1).setSourceIsLazy(true);
 
-        char* script;
-        size_t script_len;
-        if (!gjs_load_internal_source(cx, uri, &script, &script_len))
-            return false;
+        GjsContextPrivate* gjs = GjsContextPrivate::from_cx(cx);
+        JS::RootedScript compiled_script(cx);
+        if (!gjs->bytecode_cache().load_precompiled(cx, options,
+                                                    &compiled_script)) {
+            char* script;
+            size_t script_len;
+            if (!gjs_load_internal_source(cx, uri, &script, &script_len))
+                return false;
 
-        JS::SourceText<mozilla::Utf8Unit> source;
-        if (!source.init(cx, script, script_len,
-                         JS::SourceOwnership::TakeOwnership))
-            return false;
+            JS::SourceText<mozilla::Utf8Unit> source;
+            if (!source.init(cx, script, script_len,
+                             JS::SourceOwnership::TakeOwnership))
+                return false;
 
-        JS::RootedScript compiled_script(cx, JS::Compile(cx, options, source));
-        if (!compiled_script)
-            return false;
+            compiled_script = JS::Compile(cx, options, source);
+            if (!compiled_script)
+                return false;
+        }
 
         JS::RootedValue ignored(cx);
         return JS::CloneAndExecuteScript(cx, compiled_script, &ignored);
@@ -0,0 +1,281 @@
+/* -*- mode: C++; c-basic-offset: 4; indent-tabs-mode: nil; -*- */
+// SPDX-License-Identifier: MIT OR LGPL-2.0-or-later
+// SPDX-FileCopyrightText: 2020 GNOME Foundation
+
+#include <config.h>
+
+#include <stddef.h>  // for size_t
+#include <stdint.h>
+#include <stdio.h>  // for FILE, fwrite, ferror, fflush
+
+#ifdef __GLIBC__
+#    include <malloc.h>  // for malloc_usable_size
+#endif
+
+#include <string>
+#include <unordered_map>
+#include <utility>  // for pair
+#include <vector>
+
+#include <glib.h>
+
+#include <js/GCAPI.h>  // for AutoCheckCannotGC
+#include <js/TypeDecls.h>
+#include <js/UbiNode.h>
+#include <js/UbiNodeBreadthFirst.h>
+#include <js/UniquePtr.h>
+#include <mozilla/Maybe.h>
+
+#include "gi/boxed.h"
+#include "gi/object.h"
+#include "gjs/heap-snapshot.h"
+#include "util/log.h"
+
+static constexpr char MAGIC[] = "GJSHEAP";
+static constexpr unsigned VERSION = 1;
+static constexpr size_t FLUSH_THRESHOLD = 64 * 1024;
+
+static size_t malloc_size_of(const void* ptr) {
+#ifdef __GLIBC__
+    // SpiderMonkey only asks about pointers it got from its allocator, which
+    // is the system malloc() in the mozjs builds we support
+    return ptr ? malloc_usable_size(const_cast<void*>(ptr)) : 0;
+#else
+    return 0;
+#endif
+}
+
+static void append_utf16(std::string* out, const char16_t* str) {
+    for (; *str; str++) {
+        gunichar c = *str;
+        if (c >= 0xd800 && c < 0xdc00 && str[1] >= 0xdc00 && str[1] < 0xe000) {
+            c = 0x10000 + ((c - 0xd800) << 10) + (str[1] - 0xdc00);
+            str++;
+        } else if (c >= 0xd800 && c < 0xe000) {
+            c = 0xfffd;  // unpaired surrogate
+        }
+        char buf[6];
+        out->append(buf, g_unichar_to_utf8(c, buf));
+    }
+}
+
+class HeapSnapshotWriter {
+    FILE* m_fp;
+    std::string m_buffer;
+
+    // Strings that live as long as the process, such as JSClass names, C++
+    // type names and GType names, are looked up by address; edge names are
+    // freshly allocated for every edge, and have to be looked up by contents
+    std::unordered_map<const void*, uint32_t> m_static_strings;
+    std::unordered_map<std::string, uint32_t> m_strings;
+    uint32_t m_n_strings = 0;
+    std::string m_scratch;
+
+    std::vector<std::pair<uint64_t, uint32_t>> m_edges;
+    uint64_t m_n_nodes = 0;
+    uint64_t m_n_edges = 0;
+
+    void write_varint(uint64_t value) {
+        while (value >= 0x80) {
+            m_buffer.push_back(char((value & 0x7f) | 0x80));
+            value >>= 7;
+        }
+        m_buffer.push_back(char(value));
+    }
+
+    void write_tag(char tag) { m_buffer.push_back(tag); }
+
+    uint32_t write_string(const std::string& str) {
+        write_tag('S');
+        write_varint(str.size());
+        m_buffer.append(str);
+        return ++m_n_strings;
+    }
+
+    uint32_t intern(const std::string& str) {
+        auto it = m_strings.find(str);
+        if (it != m_strings.end())
+            return it->second;
+        uint32_t index = write_string(str);
+        m_strings.emplace(str, index);
+        return index;
+    }
+
+    uint32_t intern_static(const char* str) {
+        if (!str)
+            return 0;
+        auto it = m_static_strings.find(str);
+        if (it != m_static_strings.end())
+            return it->second;
+        uint32_t index = intern(str);
+        m_static_strings.emplace(str, index);
+        return index;
+    }
+
+    uint32_t intern_static(const char16_t* str) {
+        if (!str)
+            return 0;
+        auto it = m_static_strings.find(str);
+        if (it != m_static_strings.end())
+            return it->second;
+        m_scratch.clear();
+        append_utf16(&m_scratch, str);
+        uint32_t index = intern(m_scratch);
+        m_static_strings.emplace(str, index);
+        return index;
+    }
+
+    uint32_t intern_edge_name(const char16_t* name) {
+        if (!name)
+            return 0;
+        m_scratch.clear();
+        append_utf16(&m_scratch, name);
+        return intern(m_scratch);
+    }
+
+    // Returns the GType name of a GObject or boxed wrapper, and the C memory
+    // that it owns, or null if the object is not one of those wrappers
+    static const char* describe_wrapper(JSObject* obj, size_t* native_size) {
+        if (ObjectBase* priv = ObjectBase::for_js_if_wrapper(obj)) {
+            *native_size =
+                priv->is_prototype() ? 0 : priv->to_instance()->native_size();
+            return priv->type_name();
+        }
+        if (BoxedBase* priv = BoxedBase::for_js_if_wrapper(obj)) {
+            *native_size =
+                priv->is_prototype() ? 0 : priv->to_instance()->native_size();
+            return priv->gtype() != G_TYPE_NONE ? priv->type_name()
+                                                : priv->name();
+        }
+        return nullptr;
+    }
+
+ public:
+    explicit HeapSnapshotWriter(FILE* fp) : m_fp(fp) {}
+
+    void write_header(uint64_t root_id) {
+        m_buffer.append(MAGIC, sizeof(MAGIC));
+        write_varint(VERSION);
+        write_varint(root_id);
+    }
+
+    [[nodiscard]] bool write_node(JSContext* cx, const JS::ubi::Node& node) {
+        uint32_t type;
+        uint32_t gtype_name = 0;
+        size_t native_size = 0;
+
+        if (node.is<JSObject>()) {
+            JSObject* obj = node.as<JSObject>();
+            const char* class_name = node.jsObjectClassName();
+            type = class_name ? intern_static(class_name)
+                              : intern_static(node.typeName());
+            gtype_name = intern_static(describe_wrapper(obj, &native_size));
+        } else {
+            type = intern_static(node.typeName());
+        }
+
+        js::UniquePtr<JS::ubi::EdgeRange> edges =
+            node.edges(cx, /* wantNames = */ true);
+        if (!edges)
+            return false;
+
+        // Names must be written before the node record that refers to them
+        m_edges.clear();
+        for (; !edges->empty(); edges->popFront()) {
+            const JS::ubi::Edge& edge = edges->front();
+            m_edges.emplace_back(edge.referent.identifier(),
+                                 intern_edge_name(edge.name.get()));
+        }
+
+        write_tag('N');
+        write_varint(node.identifier());
+        write_varint(type);
+        write_varint(gtype_name);
+        write_varint(node.size(malloc_size_of));
+        write_varint(native_size);
+        write_varint(m_edges.size());
+        for (const auto& edge : m_edges) {
+            write_varint(edge.first);
+            write_varint(edge.second);
+        }
+
+        m_n_nodes++;
+        m_n_edges += m_edges.size();
+        return flush_if_needed();
+    }
+
+    [[nodiscard]] bool finish(void) {
+        write_tag('E');
+        write_varint(m_n_nodes);
+        write_varint(m_n_edges);
+        return flush();
+    }
+
+    [[nodiscard]] bool flush(void) {
+        if (!m_buffer.empty() &&
+            fwrite(m_buffer.data(), 1, m_buffer.size(), m_fp) !=
+                m_buffer.size())
+            return false;
+        m_buffer.clear();
+        return fflush(m_fp) == 0;
+    }
+
+    [[nodiscard]] bool flush_if_needed(void) {
+        if (m_buffer.size() < FLUSH_THRESHOLD)
+            return true;
+        return flush();
+    }
+
+    [[nodiscard]] uint64_t n_nodes(void) const { return m_n_nodes; }
+    [[nodiscard]] uint64_t n_edges(void) const { return m_n_edges; }
+};
+
+// Writes each node the first time the breadth-first traversal reaches it
+struct HeapSnapshotHandler {
+    struct NodeData {};
+    using Traversal = JS::ubi::BreadthFirst<HeapSnapshotHandler>;
+
+    JSContext* cx;
+    HeapSnapshotWriter* writer;
+
+    bool operator()(Traversal&, JS::ubi::Node, const JS::ubi::Edge& edge,
+                    NodeData*, bool first) {
+        if (!first)
+            return true;
+        return writer->write_node(cx, edge.referent);
+    }
+};
+
+bool gjs_write_heap_snapshot(JSContext* cx, FILE* fp) {
+    int64_t begin_time = g_get_monotonic_time();
+    HeapSnapshotWriter writer(fp);
+
+    // Collects the roots, after emptying the nursery. No GC may happen from
+    // then until the traversal is done, or the node ids would be stale.
+    mozilla::Maybe<JS::AutoCheckCannotGC> nogc;
+    JS::ubi::RootList roots(cx, nogc, /* wantNames = */ true);
+    if (!roots.init())
+        return false;
+
+    JS::ubi::Node root(&roots);
+    writer.write_header(root.identifier());
+    if (!writer.write_node(cx, root))
+        return false;
+
+    HeapSnapshotHandler handler{cx, &writer};
+    HeapSnapshotHandler::Traversal traversal(cx, handler, nogc.ref());
+    // Edge names are fetched when writing the node, not needed for traversal
+    traversal.wantNames = false;
+    if (!traversal.addStartVisited(root) || !traversal.traverse())
+        return false;
+
+    if (!writer.finish())
+        return false;
+
+    gjs_debug(GJS_DEBUG_CONTEXT,
+              "Heap snapshot: %" G_GUINT64_FORMAT " nodes, %" G_GUINT64_FORMAT
+              " edges written in %" G_GINT64_FORMAT " ms",
+              writer.n_nodes(), writer.n_edges(),
+              (g_get_monotonic_time() - begin_time) / 1000);
+    return true;
+}
@@ -0,0 +1,47 @@
+/* -*- mode: C++; c-basic-offset: 4; indent-tabs-mode: nil; -*- */
+// SPDX-License-Identifier: MIT OR LGPL-2.0-or-later
+// SPDX-FileCopyrightText: 2020 GNOME Foundation
+
+#ifndef GJS_HEAP_SNAPSHOT_H_
+#define GJS_HEAP_SNAPSHOT_H_
+
+#include <config.h>
+
+#include <stdio.h>  // for FILE
+
+#include <js/TypeDecls.h>
+
+/*
+ * Compact binary heap snapshots
+ *
+ * js::DumpHeap() writes a line of text for every GC thing and edge, which for
+ * a large application adds up to hundreds of megabytes that take minutes to
+ * write and to parse. A snapshot records the same graph in a binary format, with
+ * sizes, and with the GType of every GObject and boxed wrapper, so that
+ * tools/heapsnapshot.py can compute retained sizes offline.
+ *
+ * All integers are unsigned LEB128 varints. A snapshot is:
+ *
+ *   "GJSHEAP" '\0'                      magic
+ *   version                             currently 1
+ *   root node id
+ *   record*
+ *   'E' node count, edge count          end of snapshot
+ *
+ * where each record is one of:
+ *
+ *   'S' length, UTF-8 bytes             string; strings are numbered from 1 in
+ *                                       order of appearance, 0 means "none"
+ *   'N' id, type, GType, size,          node; type and GType are string
+ *       native size, edge count,        numbers, size is the JS engine's idea
+ *       (referent id, name)*            of the node's own size, native size is
+ *                                       C memory owned by a GI wrapper
+ *
+ * Node ids are addresses, and are only meaningful within one snapshot. A
+ * string is always written before the first record that refers to it. Several
+ * snapshots may be concatenated in one file, one per GjsContext.
+ */
+
+[[nodiscard]] bool gjs_write_heap_snapshot(JSContext* cx, FILE* fp);
+
+#endif  // GJS_HEAP_SNAPSHOT_H_
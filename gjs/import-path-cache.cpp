@@ -0,0 +1,168 @@
+/* -*- mode: C++; c-basic-offset: 4; indent-tabs-mode: nil; -*- */
+// SPDX-License-Identifier: MIT OR LGPL-2.0-or-later
+// SPDX-FileCopyrightText: 2020 GNOME Foundation
+
+#include <config.h>
+
+#include <string.h>  // for strchr
+
+#include <memory>  // for unique_ptr, make_unique
+#include <string>
+#include <utility>  // for move
+
+#include <gio/gio.h>
+#include <glib-object.h>
+#include <glib.h>
+
+#include "gjs/import-path-cache.h"
+#include "gjs/jsapi-util.h"
+#include "util/log.h"
+
+GjsImportPathCache::GjsImportPathCache()
+    : m_enabled(!g_getenv("GJS_DISABLE_IMPORT_CACHE")) {}
+
+void GjsImportPathCache::on_directory_changed(GFileMonitor*, GFile* file,
+                                              GFile* other_file,
+                                              GFileMonitorEvent event_type,
+                                              void* data) {
+    auto* dir = static_cast<Directory*>(data);
+
+    // Changes to the contents of a file don't change what the importer finds
+    if (event_type == G_FILE_MONITOR_EVENT_CHANGED ||
+        event_type == G_FILE_MONITOR_EVENT_CHANGES_DONE_HINT ||
+        event_type == G_FILE_MONITOR_EVENT_ATTRIBUTE_CHANGED)
+        return;
+
+    // Something may have appeared that isn't in the listing
+    dir->complete = false;
+
+    for (GFile* changed : {file, other_file}) {
+        if (!changed)
+            continue;
+
+        // The directory itself went away or was replaced
+        if (g_file_equal(changed, dir->file)) {
+            dir->entries.clear();
+            continue;
+        }
+
+        GjsAutoChar name = g_file_get_basename(changed);
+        gjs_debug(GJS_DEBUG_IMPORTER,
+                  "'%s' changed, dropping it from the import path cache",
+                  name.get());
+        dir->entries.erase(name.get());
+    }
+}
+
+GjsImportPathCache::Directory* GjsImportPathCache::lookup_directory(
+    GFile* dir) {
+    GjsAutoChar uri = g_file_get_uri(dir);
+    auto it = m_dirs.find(uri.get());
+    if (it != m_dirs.end())
+        return it->second.get();
+
+    auto directory = std::make_unique<Directory>();
+    directory->file = static_cast<GFile*>(g_object_ref(dir));
+    if (!g_file_has_uri_scheme(dir, "resource")) {
+        directory->monitor = g_file_monitor_directory(
+            dir, G_FILE_MONITOR_WATCH_MOVES, nullptr, nullptr);
+        if (!directory->monitor) {
+            gjs_debug(GJS_DEBUG_IMPORTER,
+                      "Can't watch %s, not caching import paths in it",
+                      uri.get());
+            // Remembered, so that it isn't tried again
+            m_dirs.emplace(uri.get(), nullptr);
+            return nullptr;
+        }
+        g_signal_connect(directory->monitor, "changed",
+                         G_CALLBACK(on_directory_changed), directory.get());
+    }
+
+    Directory* retval = directory.get();
+    m_dirs.emplace(uri.get(), std::move(directory));
+    return retval;
+}
+
+GFileType GjsImportPathCache::query_file_type(const char* dirname,
+                                              const char* name) {
+    // new_for_commandline_arg handles resource:/// paths
+    GjsAutoUnref<GFile> dir = g_file_new_for_commandline_arg(dirname);
+
+    // Names with a separator aren't directly in the directory
+    Directory* cached = nullptr;
+    if (m_enabled && !strchr(name, G_DIR_SEPARATOR))
+        cached = lookup_directory(dir);
+
+    if (cached) {
+        auto it = cached->entries.find(name);
+        if (it != cached->entries.end()) {
+            m_hits++;
+            return it->second;
+        }
+        if (cached->complete) {
+            m_hits++;
+            return G_FILE_TYPE_UNKNOWN;
+        }
+    }
+
+    m_misses++;
+    GjsAutoUnref<GFile> file = g_file_get_child(dir, name);
+    GFileType type =
+        g_file_query_file_type(file, G_FILE_QUERY_INFO_NONE, nullptr);
+    if (cached)
+        cached->entries.emplace(name, type);
+    return type;
+}
+
+void GjsImportPathCache::enumerate(const char* dirname) {
+    if (!m_enabled)
+        return;
+
+    GjsAutoUnref<GFile> dir = g_file_new_for_commandline_arg(dirname);
+    Directory* cached = lookup_directory(dir);
+    if (!cached || cached->complete)
+        return;
+
+    m_misses++;
+    cached->entries.clear();
+
+    GjsAutoError error;
+    GjsAutoUnref<GFileEnumerator> direnum = g_file_enumerate_children(
+        dir, G_FILE_ATTRIBUTE_STANDARD_NAME "," G_FILE_ATTRIBUTE_STANDARD_TYPE,
+        G_FILE_QUERY_INFO_NONE, nullptr, error.out());
+    if (!direnum) {
+        // Nothing is in a directory that doesn't exist; the monitor notices
+        // if it is created
+        cached->complete =
+            g_error_matches(error, G_IO_ERROR, G_IO_ERROR_NOT_FOUND);
+        return;
+    }
+
+    while (true) {
+        GFileInfo* info;
+        if (!g_file_enumerator_iterate(direnum, &info, nullptr, nullptr,
+                                       nullptr))
+            return;  // incomplete; names not found are looked up one by one
+        if (!info)
+            break;
+        cached->entries[g_file_info_get_name(info)] =
+            g_file_info_get_file_type(info);
+    }
+    cached->complete = true;
+}
+
+size_t GjsImportPathCache::clear(void) {
+    size_t n_entries = 0;
+    for (auto& it : m_dirs) {
+        Directory* dir = it.second.get();
+        if (!dir)
+            continue;
+        n_entries += dir->entries.size();
+        if (dir->monitor) {
+            g_signal_handlers_disconnect_by_data(dir->monitor, dir);
+            g_file_monitor_cancel(dir->monitor);
+        }
+    }
+    m_dirs.clear();
+    return n_entries;
+}
@@ -0,0 +1,93 @@
+/* -*- mode: C++; c-basic-offset: 4; indent-tabs-mode: nil; -*- */
+// SPDX-License-Identifier: MIT OR LGPL-2.0-or-later
+// SPDX-FileCopyrightText: 2020 GNOME Foundation
+
+#ifndef GJS_IMPORT_PATH_CACHE_H_
+#define GJS_IMPORT_PATH_CACHE_H_
+
+#include <config.h>
+
+#include <stddef.h>  // for size_t
+
+#include <memory>  // for unique_ptr
+#include <string>
+#include <unordered_map>
+
+#include <gio/gio.h>
+#include <glib.h>
+
+#include "gjs/jsapi-util.h"
+
+/*
+ * GjsImportPathCache:
+ *
+ * Remembers what the importer found at each path it looked at while resolving
+ * an import: a directory, a file, or nothing. Every import walks the search
+ * path, and without this, each element costs a couple of stat() calls even for
+ * modules that were resolved before, or that are known not to be there.
+ *
+ * Entries are grouped by the directory they are in. Each local directory is
+ * watched with a GFileMonitor, and entries are dropped when something is
+ * created, deleted or moved in it; the monitors are dispatched from the main
+ * loop, so a change made by the program itself is only seen after the main
+ * loop has run. Resources never change and are not watched. Directories that
+ * can't be watched are not cached.
+ *
+ * A directory can also be listed all at once, when most lookups in it are
+ * expected to find nothing, as for GI overrides.
+ *
+ * Set GJS_DISABLE_IMPORT_CACHE while developing, to always look at the file
+ * system instead. The number of lookups that were answered from the cache and
+ * that had to query the file system are logged when the context is disposed.
+ */
+class GjsImportPathCache {
+    struct Directory {
+        GjsAutoUnref<GFile> file;
+        // Null if the directory never changes
+        GjsAutoUnref<GFileMonitor> monitor;
+        // Keyed by basename; G_FILE_TYPE_UNKNOWN if nothing is there
+        std::unordered_map<std::string, GFileType> entries;
+        // Whether entries has everything in the directory, so that names not
+        // in it are known not to be there
+        bool complete = false;
+    };
+
+    // Keyed by the URI of the directory
+    std::unordered_map<std::string, std::unique_ptr<Directory>> m_dirs;
+    unsigned m_hits = 0;
+    unsigned m_misses = 0;
+    bool m_enabled : 1;
+
+    static void on_directory_changed(GFileMonitor*, GFile* file,
+                                     GFile* other_file,
+                                     GFileMonitorEvent event_type,
+                                     void* data);
+    [[nodiscard]] Directory* lookup_directory(GFile* dir);
+
+ public:
+    GjsImportPathCache();
+    ~GjsImportPathCache() { clear(); }
+
+    // Like g_file_query_file_type() on @name in @dirname, where @dirname is a
+    // path or URI as in the importer's search path
+    [[nodiscard]] GFileType query_file_type(const char* dirname,
+                                            const char* name);
+
+    // Whether a file or directory exists at @name in @dirname
+    [[nodiscard]] bool exists(const char* dirname, const char* name) {
+        return query_file_type(dirname, name) != G_FILE_TYPE_UNKNOWN;
+    }
+
+    // Lists @dirname, so that later lookups in it don't query the file system
+    // even for names that aren't there
+    void enumerate(const char* dirname);
+
+    // Drops all entries and stops watching directories; returns the number of
+    // entries dropped
+    size_t clear(void);
+
+    [[nodiscard]] unsigned hits() const { return m_hits; }
+    [[nodiscard]] unsigned misses() const { return m_misses; }
+};
+
+#endif  // GJS_IMPORT_PATH_CACHE_H_
@@ -504,6 +504,8 @@ static bool do_import(JSContext* context, JS::HandleObject obj,
 
     GjsAutoChar filename = g_strdup_printf("%s.js", name.get());
     std::vector<std::string> directories;
+    GjsImportPathCache& path_cache =
+        GjsContextPrivate::from_cx(context)->import_path_cache();
     JS::RootedValue elem(context);
     JS::RootedString str(context);
 
@@ -544,9 +546,9 @@ static bool do_import(JSContext* context, JS::HandleObject obj,
         /* Second try importing a directory (a sub-importer) */
         GjsAutoChar full_path =
             g_build_filename(dirname.get(), name.get(), nullptr);
-        GjsAutoUnref<GFile> gfile = g_file_new_for_commandline_arg(full_path);
 
-        if (g_file_query_file_type(gfile, (GFileQueryInfoFlags) 0, NULL) == G_FILE_TYPE_DIRECTORY) {
+        if (path_cache.query_file_type(dirname.get(), name.get()) ==
+            G_FILE_TYPE_DIRECTORY) {
             gjs_debug(GJS_DEBUG_IMPORTER,
                       "Adding directory '%s' to child importer '%s'",
                       full_path.get(), name.get());
@@ -563,9 +565,7 @@ static bool do_import(JSContext* context, JS::HandleObject obj,
             continue;
 
         /* Third, if it's not a directory, try importing a file */
-        full_path = g_build_filename(dirname.get(), filename.get(), nullptr);
-        gfile = g_file_new_for_commandline_arg(full_path);
-        exists = g_file_query_exists(gfile, NULL);
+        exists = path_cache.exists(dirname.get(), filename.get());
 
         if (!exists) {
             gjs_debug(GJS_DEBUG_IMPORTER, "JS import '%s' not found in %s",
@@ -573,6 +573,9 @@ static bool do_import(JSContext* context, JS::HandleObject obj,
             continue;
         }
 
+        full_path = g_build_filename(dirname.get(), filename.get(), nullptr);
+        GjsAutoUnref<GFile> gfile = g_file_new_for_commandline_arg(full_path);
+
         if (import_file_on_module(context, obj, id, name.get(), gfile)) {
             gjs_debug(GJS_DEBUG_IMPORTER, "successfully imported module '%s'",
                       name.get());
@@ -13,6 +13,7 @@
 #include <cstddef>  // for nullptr_t
 #include <memory>
 #include <new>
+#include <optional>
 #include <type_traits>  // for enable_if_t, is_pointer
 
 #include <glib-object.h>
@@ -102,12 +103,6 @@ class GjsMaybeOwned {
     typedef void (*DestroyNotify)(JS::Handle<T> thing, void *data);
 
  private:
-    /* m_root value controls which of these members we can access. When switching
-     * from one to the other, be careful to call the constructor and destructor
-     * of JS::Heap, since they use post barriers. */
-    JS::Heap<T> m_heap;
-    std::unique_ptr<JS::PersistentRooted<T>> m_root;
-
     struct Notifier {
         Notifier(GjsMaybeOwned<T> *parent, DestroyNotify func, void *data)
             : m_parent(parent)
@@ -144,7 +139,21 @@ class GjsMaybeOwned {
         DestroyNotify m_func;
         void *m_data;
     };
-    std::unique_ptr<Notifier> m_notify;
+
+    // Everything that is only needed while rooted is allocated together, so
+    // that the unrooted case, which is the common one for wrappers of GObjects
+    // without JS state, takes only two words
+    struct Root {
+        Root(JSContext* cx, const T& initial) : thing(cx, initial) {}
+        JS::PersistentRooted<T> thing;
+        std::optional<Notifier> notify;
+    };
+
+    /* m_root value controls which of these members we can access. When switching
+     * from one to the other, be careful to call the constructor and destructor
+     * of JS::Heap, since they use post barriers. */
+    JS::Heap<T> m_heap;
+    std::unique_ptr<Root> m_root;
 
     /* No-op unless GJS_VERBOSE_ENABLE_LIFECYCLE is defined to 1. */
     inline void debug(const char* what GJS_USED_VERBOSE_LIFECYCLE) {
@@ -159,7 +168,6 @@ class GjsMaybeOwned {
         g_assert(m_root);
 
         m_root.reset();
-        m_notify.reset();
 
         new (&m_heap) JS::Heap<T>();
     }
@@ -178,7 +186,7 @@ class GjsMaybeOwned {
      * cast operator. But if you want to call methods on the GC thing, for
      * example if it's a JS::Value, you have to use get(). */
     [[nodiscard]] const T get() const {
-        return m_root ? m_root->get() : m_heap.get();
+        return m_root ? m_root->thing.get() : m_heap.get();
     }
     operator const T() const { return get(); }
 
@@ -186,14 +194,14 @@ class GjsMaybeOwned {
     template <typename U = T>
     [[nodiscard]] const void* debug_addr(
         std::enable_if_t<std::is_pointer_v<U>>* = nullptr) const {
-        return m_root ? m_root->get() : m_heap.unbarrieredGet();
+        return m_root ? m_root->thing.get() : m_heap.unbarrieredGet();
     }
 
     bool
     operator==(const T& other) const
     {
         if (m_root)
-            return m_root->get() == other;
+            return m_root->thing.get() == other;
         return m_heap == other;
     }
     inline bool operator!=(const T& other) const { return !(*this == other); }
@@ -204,7 +212,7 @@ class GjsMaybeOwned {
     operator==(std::nullptr_t) const
     {
         if (m_root)
-            return m_root->get() == nullptr;
+            return m_root->thing.get() == nullptr;
         return m_heap.unbarrieredGet() == nullptr;
     }
     inline bool operator!=(std::nullptr_t) const { return !(*this == nullptr); }
@@ -217,7 +225,7 @@ class GjsMaybeOwned {
      * JSContext can be destroyed while the Handle is live. */
     [[nodiscard]] JS::Handle<T> handle() {
         g_assert(m_root);
-        return *m_root;
+        return m_root->thing;
     }
 
     /* Roots the GC thing. You must not use this if you're already using the
@@ -232,10 +240,10 @@ class GjsMaybeOwned {
         g_assert(!m_root);
         g_assert(m_heap.get() == JS::SafelyInitialized<T>());
         m_heap.~Heap();
-        m_root = std::make_unique<JS::PersistentRooted<T>>(cx, thing);
+        m_root = std::make_unique<Root>(cx, thing);
 
         if (notify)
-            m_notify = std::make_unique<Notifier>(this, notify, data);
+            m_root->notify.emplace(this, notify, data);
     }
 
     /* You can only assign directly to the GjsMaybeOwned wrapper in the
@@ -289,7 +297,7 @@ class GjsMaybeOwned {
 
         /* Prevent the thing from being garbage collected while it is in neither
          * m_heap nor m_root */
-        JS::Rooted<T> thing(cx, *m_root);
+        JS::Rooted<T> thing(cx, m_root->thing);
 
         reset();
         m_heap = thing;
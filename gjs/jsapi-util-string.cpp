@@ -8,6 +8,10 @@
 #include <string.h>     // for size_t, strlen
 #include <sys/types.h>  // for ssize_t
 
+#ifdef __SSE2__
+#    include <emmintrin.h>  // for _mm_loadu_si128, _mm_movemask_epi8
+#endif
+
 #include <algorithm>  // for copy
 #include <iomanip>    // for operator<<, setfill, setw
 #include <sstream>    // for operator<<, basic_ostream, ostring...
@@ -29,15 +33,10 @@
 #include <jsapi.h>        // for JSID_TO_FLAT_STRING, JS_GetTwoByte...
 #include <jsfriendapi.h>  // for FlatStringToLinearString, GetLatin...
 
+#include "gjs/context-private.h"
 #include "gjs/jsapi-util.h"
 #include "gjs/macros.h"
 
-// Avoid static_assert in MSVC builds
-namespace JS {
-template <>
-struct GCPolicy<void*> : public IgnoreGCPolicy<void*> {};
-}
-
 class JSLinearString;
 
 char* gjs_hyphen_to_underscore(const char* str) {
@@ -50,6 +49,83 @@ char* gjs_hyphen_to_underscore(const char* str) {
     return retval;
 }
 
+/**
+ * gjs_ascii_prefix_length:
+ * @str: a buffer of bytes
+ * @len: length of @str in bytes
+ *
+ * Scans @str for the first byte that is not 7-bit ASCII. The scan looks at 16
+ * bytes at a time where SSE2 is available, and otherwise at one 64-bit word at
+ * a time.
+ *
+ * Returns: the number of bytes at the start of @str that are ASCII; equal to
+ * @len if the whole buffer is ASCII.
+ */
+size_t gjs_ascii_prefix_length(const char* str, size_t len) {
+    size_t ix = 0;
+
+#ifdef __SSE2__
+    for (; ix + 16 <= len; ix += 16) {
+        __m128i chunk =
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(str + ix));
+        if (_mm_movemask_epi8(chunk) != 0)
+            break;
+    }
+#endif
+
+    constexpr uint64_t HIGH_BITS = 0x8080808080808080;
+    for (; ix + 8 <= len; ix += 8) {
+        uint64_t word;
+        memcpy(&word, str + ix, sizeof(word));
+        if (word & HIGH_BITS)
+            break;
+    }
+
+    for (; ix < len; ix++) {
+        if (static_cast<unsigned char>(str[ix]) >= 0x80)
+            break;
+    }
+
+    return ix;
+}
+
+/* Decodes the UTF-8 string @str into Latin-1, if all its code points are below
+ * U+0100. The first @ascii_len bytes are already known to be ASCII. Returns
+ * false, without throwing, if @str contains code points that don't fit in
+ * Latin-1 or isn't valid UTF-8; in that case, the caller should fall back to
+ * the general UTF-8 decoder. @latin1 must have room for @len bytes. */
+[[nodiscard]] static bool utf8_to_latin1(const char* str, size_t len,
+                                         size_t ascii_len, char* latin1,
+                                         size_t* latin1_len) {
+    memcpy(latin1, str, ascii_len);
+    size_t out = ascii_len;
+
+    for (size_t ix = ascii_len; ix < len;) {
+        auto lead = static_cast<unsigned char>(str[ix]);
+        if (lead < 0x80) {
+            // Copy the whole run of ASCII at once
+            size_t run = gjs_ascii_prefix_length(str + ix, len - ix);
+            memcpy(latin1 + out, str + ix, run);
+            out += run;
+            ix += run;
+            continue;
+        }
+
+        // U+0080 to U+00FF are encoded as C2 80 to C3 BF
+        if ((lead != 0xc2 && lead != 0xc3) || ix + 1 >= len)
+            return false;
+        auto trail = static_cast<unsigned char>(str[ix + 1]);
+        if ((trail & 0xc0) != 0x80)
+            return false;
+
+        latin1[out++] = static_cast<char>(((lead & 0x1f) << 6) | (trail & 0x3f));
+        ix += 2;
+    }
+
+    *latin1_len = out;
+    return true;
+}
+
 /**
  * gjs_string_to_utf8:
  * @cx: JSContext
@@ -57,10 +133,11 @@ char* gjs_hyphen_to_underscore(const char* str) {
  *
  * Converts the JSString in @value to UTF-8 and puts it in @utf8_string_p.
  *
- * This function is a convenience wrapper around JS_EncodeStringToUTF8() that
- * typechecks the JS::Value and throws an exception if it's the wrong type.
- * Don't use this function if you already have a JS::RootedString, or if you
- * know the value already holds a string; use JS_EncodeStringToUTF8() instead.
+ * This function is a convenience wrapper around the overload taking a
+ * JS::HandleString, that typechecks the JS::Value and throws an exception if
+ * it's the wrong type. Don't use this function if you already have a
+ * JS::RootedString, or if you know the value already holds a string; use the
+ * other overload instead.
  *
  * Returns: Unique UTF8 chars, empty on exception throw.
  */
@@ -71,7 +148,68 @@ JS::UniqueChars gjs_string_to_utf8(JSContext* cx, const JS::Value value) {
     }
 
     JS::RootedString str(cx, value.toString());
-    return JS_EncodeStringToUTF8(cx, str);
+    return gjs_string_to_utf8(cx, str);
+}
+
+/**
+ * gjs_string_to_utf8:
+ * @cx: JSContext
+ * @str: a rooted JSString
+ *
+ * Converts @str to UTF-8. This has the same result as JS_EncodeStringToUTF8(),
+ * but strings stored as Latin-1, which is most strings in practice, are
+ * encoded directly without going through the general-purpose encoder; and
+ * ASCII strings are just copied.
+ *
+ * Returns: Unique UTF8 chars, empty on exception throw.
+ */
+JS::UniqueChars gjs_string_to_utf8(JSContext* cx, JS::HandleString str) {
+    if (!JS_EnsureLinearString(cx, str))
+        return nullptr;
+    if (!JS_StringHasLatin1Chars(str))
+        return JS_EncodeStringToUTF8(cx, str);
+
+    size_t len, ascii_len, utf8_len;
+    {
+        JS::AutoCheckCannotGC nogc;
+        const JS::Latin1Char* chars =
+            JS_GetLatin1StringCharsAndLength(cx, nogc, str, &len);
+        if (!chars)
+            return nullptr;
+
+        ascii_len =
+            gjs_ascii_prefix_length(reinterpret_cast<const char*>(chars), len);
+        utf8_len = len;
+        for (size_t ix = ascii_len; ix < len; ix++) {
+            if (chars[ix] >= 0x80)
+                utf8_len++;
+        }
+    }
+
+    JS::UniqueChars retval(js_pod_malloc<char>(utf8_len + 1));
+    if (!retval) {
+        JS_ReportOutOfMemory(cx);
+        return nullptr;
+    }
+
+    JS::AutoCheckCannotGC nogc;
+    const JS::Latin1Char* chars =
+        JS_GetLatin1StringCharsAndLength(cx, nogc, str, &len);
+    char* out = retval.get();
+    memcpy(out, chars, ascii_len);
+    out += ascii_len;
+    for (size_t ix = ascii_len; ix < len; ix++) {
+        JS::Latin1Char c = chars[ix];
+        if (c < 0x80) {
+            *out++ = static_cast<char>(c);
+        } else {
+            *out++ = static_cast<char>(0xc0 | (c >> 6));
+            *out++ = static_cast<char>(0x80 | (c & 0x3f));
+        }
+    }
+    *out = '\0';
+
+    return retval;
 }
 
 bool
@@ -79,28 +217,91 @@ gjs_string_from_utf8(JSContext             *context,
                      const char            *utf8_string,
                      JS::MutableHandleValue value_p)
 {
-    JS::ConstUTF8CharsZ chars(utf8_string, strlen(utf8_string));
-    JS::RootedString str(context, JS_NewStringCopyUTF8Z(context, chars));
-    if (str)
-        value_p.setString(str);
-
-    return str != nullptr;
+    return gjs_string_from_utf8_n(context, utf8_string, strlen(utf8_string),
+                                  value_p);
 }
 
+/**
+ * gjs_string_from_utf8_n:
+ * @cx: JSContext
+ * @utf8_chars: a UTF-8 string, not necessarily zero-terminated
+ * @len: length of @utf8_chars in bytes
+ * @out: return location for the JS string
+ *
+ * Creates a JS string from UTF-8. Strings that are pure ASCII, or whose code
+ * points all fit in Latin-1, are created as Latin-1 JS strings without going
+ * through UTF-16. Other strings, including invalid UTF-8 which throws, are
+ * handled by SpiderMonkey's UTF-8 decoder.
+ *
+ * Returns: false if an exception was thrown
+ */
 bool
 gjs_string_from_utf8_n(JSContext             *cx,
                        const char            *utf8_chars,
                        size_t                 len,
                        JS::MutableHandleValue out)
 {
-    JS::UTF8Chars chars(utf8_chars, len);
-    JS::RootedString str(cx, JS_NewStringCopyUTF8N(cx, chars));
+    JSString* str;
+    size_t ascii_len = gjs_ascii_prefix_length(utf8_chars, len);
+    if (ascii_len == len) {
+        str = JS_NewStringCopyN(cx, utf8_chars, len);
+    } else {
+        GjsAutoChar latin1 = static_cast<char*>(g_malloc(len));
+        size_t latin1_len;
+        if (utf8_to_latin1(utf8_chars, len, ascii_len, latin1, &latin1_len)) {
+            str = JS_NewStringCopyN(cx, latin1, latin1_len);
+        } else {
+            JS::UTF8Chars chars(utf8_chars, len);
+            str = JS_NewStringCopyUTF8N(cx, chars);
+        }
+    }
+
     if (str)
         out.setString(str);
 
     return !!str;
 }
 
+/**
+ * gjs_string_from_static_utf8:
+ * @cx: JSContext
+ * @utf8_string: a zero-terminated UTF-8 string with static storage
+ * @value_p: return location for the JS string
+ *
+ * Like gjs_string_from_utf8(), but for C strings that are never freed or
+ * modified, such as the return values of g_type_name(), g_quark_to_string(),
+ * g_intern_string(), and g_param_spec_get_name(). The JS string is atomized
+ * and cached by the address of @utf8_string, so converting the same C string
+ * again returns the same JS string without looking at its contents.
+ *
+ * Don't use this for strings that may be freed, since another string could
+ * later be allocated at the same address.
+ *
+ * Returns: false if an exception was thrown
+ */
+bool gjs_string_from_static_utf8(JSContext* cx, const char* utf8_string,
+                                 JS::MutableHandleValue value_p) {
+    auto& cache = GjsContextPrivate::from_cx(cx)->static_strings();
+    auto entry = cache.find(utf8_string);
+    if (entry != cache.end()) {
+        value_p.setString(entry->second);
+        return true;
+    }
+
+    if (!gjs_string_from_utf8(cx, utf8_string, value_p))
+        return false;
+
+    // Pinned atoms are never collected or moved, so they don't need tracing
+    JS::RootedString str(cx, value_p.toString());
+    JSString* atom = JS_AtomizeAndPinJSString(cx, str);
+    if (!atom)
+        return false;
+
+    cache.emplace(utf8_string, atom);
+    value_p.setString(atom);
+    return true;
+}
+
 bool
 gjs_string_to_filename(JSContext      *context,
                        const JS::Value filename_val,
@@ -8,6 +8,10 @@
 #include <stdio.h>   // for sscanf
 #include <string.h>  // for strlen
 
+#ifdef __linux__
+#    include <unistd.h>  // for sysconf
+#endif
+
 #ifdef _WIN32
 #    define WIN32_LEAN_AND_MEAN
 #    include <windows.h>
@@ -586,6 +590,24 @@ gjs_gc_if_needed (JSContext *context)
 #endif
 }
 
+/*
+ * gjs_get_process_rss:
+ *
+ * Returns: the resident set size of the current process in bytes, or 0 if it
+ * can't be determined on this platform.
+ */
+uint64_t gjs_get_process_rss(void) {
+#ifdef __linux__
+    long rss_pages;  // NOLINT(runtime/int)
+    _linux_get_self_process_size(&rss_pages);
+    if (rss_pages < 0)
+        return 0;
+    return uint64_t(rss_pages) * sysconf(_SC_PAGESIZE);
+#else
+    return 0;
+#endif
+}
+
 /**
  * gjs_maybe_gc:
  *
@@ -646,6 +668,13 @@ static std::wstring gjs_win32_vc140_utf8_to_utf16(const char* str,
 #endif
 
 std::u16string gjs_utf8_script_to_utf16(const char* script, ssize_t len) {
+    if (len < 0)
+        len = strlen(script);
+
+    // Most scripts are pure ASCII, which can be widened without decoding
+    if (gjs_ascii_prefix_length(script, len) == size_t(len))
+        return std::u16string(script, script + len);
+
 #if defined(G_OS_WIN32) && (defined(_MSC_VER) && (_MSC_VER >= 1900))
     std::wstring wscript = gjs_win32_vc140_utf8_to_utf16(script, len);
     return std::u16string(reinterpret_cast<const char16_t*>(wscript.c_str()));
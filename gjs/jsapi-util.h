@@ -426,9 +426,13 @@ bool gjs_log_exception_full(JSContext* cx, JS::HandleValue exc,
 
 void gjs_warning_reporter(JSContext*, JSErrorReport* report);
 
+[[nodiscard]] size_t gjs_ascii_prefix_length(const char* str, size_t len);
+
 GJS_JSAPI_RETURN_CONVENTION
 JS::UniqueChars gjs_string_to_utf8(JSContext* cx, const JS::Value string_val);
 GJS_JSAPI_RETURN_CONVENTION
+JS::UniqueChars gjs_string_to_utf8(JSContext* cx, JS::HandleString str);
+GJS_JSAPI_RETURN_CONVENTION
 bool gjs_string_from_utf8(JSContext             *context,
                           const char            *utf8_string,
                           JS::MutableHandleValue value_p);
@@ -437,6 +441,9 @@ bool gjs_string_from_utf8_n(JSContext             *cx,
                             const char            *utf8_chars,
                             size_t                 len,
                             JS::MutableHandleValue out);
+GJS_JSAPI_RETURN_CONVENTION
+bool gjs_string_from_static_utf8(JSContext* cx, const char* utf8_string,
+                                 JS::MutableHandleValue value_p);
 
 GJS_JSAPI_RETURN_CONVENTION
 bool gjs_string_to_filename(JSContext       *cx,
@@ -481,6 +488,7 @@ bool        gjs_unichar_from_string          (JSContext       *context,
 
 void gjs_maybe_gc (JSContext *context);
 void gjs_gc_if_needed(JSContext *cx);
+[[nodiscard]] uint64_t gjs_get_process_rss(void);
 
 [[nodiscard]] std::u16string gjs_utf8_script_to_utf16(const char* script,
                                                       ssize_t len);
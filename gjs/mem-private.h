@@ -51,4 +51,36 @@ GJS_FOR_EACH_COUNTER(GJS_DECLARE_COUNTER)
 
 #define GJS_GET_COUNTER(name) g_atomic_int_get(&gjs_counter_##name.value)
 
+// Native memory held on behalf of JS wrappers, in bytes. Memory that belongs
+// to one JS object is also reported to SpiderMonkey with
+// JS::AddAssociatedMemory(), so that it is taken into account when scheduling
+// GCs. Prototype caches are measured when reporting, instead of counted here.
+typedef struct {
+    volatile gssize value;
+    const char* name;
+} GjsMemByteCounter;
+
+// clang-format off
+#define GJS_FOR_EACH_BYTE_COUNTER(macro) \
+    macro(argument_cache)                \
+    macro(boxed_instance)                \
+    macro(callback_trampoline)           \
+    macro(closure)                       \
+    macro(object_instance)
+// clang-format on
+
+#define GJS_DECLARE_BYTE_COUNTER(name) \
+    extern GjsMemByteCounter gjs_byte_counter_##name;
+
+GJS_FOR_EACH_BYTE_COUNTER(GJS_DECLARE_BYTE_COUNTER)
+
+#define GJS_ADD_BYTES(name, bytes) \
+    g_atomic_pointer_add(&gjs_byte_counter_##name.value, gssize(bytes))
+
+#define GJS_SUB_BYTES(name, bytes) \
+    g_atomic_pointer_add(&gjs_byte_counter_##name.value, -gssize(bytes))
+
+#define GJS_GET_BYTES(name) \
+    gssize(g_atomic_pointer_get(&gjs_byte_counter_##name.value))
+
 #endif  // GJS_MEM_PRIVATE_H_
@@ -21,6 +21,16 @@ GJS_FOR_EACH_COUNTER(GJS_DEFINE_COUNTER)
 
 static GjsMemCounter* counters[] = {GJS_FOR_EACH_COUNTER(GJS_LIST_COUNTER)};
 
+#define GJS_DEFINE_BYTE_COUNTER(name) \
+    GjsMemByteCounter gjs_byte_counter_##name = {0, #name};
+
+GJS_FOR_EACH_BYTE_COUNTER(GJS_DEFINE_BYTE_COUNTER)
+
+#define GJS_LIST_BYTE_COUNTER(name) &gjs_byte_counter_##name,
+
+static GjsMemByteCounter* byte_counters[] = {
+    GJS_FOR_EACH_BYTE_COUNTER(GJS_LIST_BYTE_COUNTER)};
+
 void
 gjs_memory_report(const char *where,
                   bool        die_if_leaks)
@@ -49,6 +59,11 @@ gjs_memory_report(const char *where,
               "  %d objects currently alive",
               GJS_GET_COUNTER(everything));
 
+    for (GjsMemByteCounter* counter : byte_counters) {
+        gjs_debug(GJS_DEBUG_MEMORY, "    %24s = %" G_GSSIZE_FORMAT " bytes",
+                  counter->name, counter->value);
+    }
+
     if (GJS_GET_COUNTER(everything) != 0) {
         for (i = 0; i < n_counters; ++i) {
             gjs_debug(GJS_DEBUG_MEMORY, "    %24s = %d", counters[i]->name,
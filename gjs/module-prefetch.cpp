@@ -0,0 +1,333 @@
+/* -*- mode: C++; c-basic-offset: 4; indent-tabs-mode: nil; -*- */
+// SPDX-License-Identifier: MIT OR LGPL-2.0-or-later
+// SPDX-FileCopyrightText: 2020 GNOME Foundation
+
+#include <config.h>
+
+#include <stdint.h>
+#include <string.h>  // for memcmp
+
+#include <memory>  // for unique_ptr, make_unique
+#include <string>
+#include <string_view>
+#include <utility>  // for move
+#include <vector>
+
+#include <gio/gio.h>
+#include <glib.h>
+
+#include <js/Array.h>  // for IsArrayObject, GetArrayLength
+#include <js/CharacterEncoding.h>
+#include <js/CompileOptions.h>
+#include <js/GCAPI.h>  // for IsIncrementalGCInProgress, FinishIncrementalGC
+#include <js/OffThreadScriptCompilation.h>
+#include <js/RootingAPI.h>
+#include <js/SourceText.h>
+#include <js/TypeDecls.h>
+#include <js/Utility.h>  // for UniqueChars
+#include <js/Value.h>
+#include <jsapi.h>  // for JS_GetElement, JS_ClearPendingException, ...
+
+#include "gjs/atoms.h"
+#include "gjs/bytecode-cache.h"
+#include "gjs/context-private.h"
+#include "gjs/global.h"
+#include "gjs/import-path-cache.h"
+#include "gjs/jsapi-util.h"
+#include "gjs/module-prefetch.h"
+#include "gjs/native.h"
+#include "util/log.h"
+
+// Bounds the work wasted on modules that are never imported
+static constexpr size_t MAX_ENTRIES = 256;
+
+static constexpr std::string_view IMPORTS_PREFIX = "imports.";
+
+[[nodiscard]] static bool is_identifier_char(char c) {
+    return g_ascii_isalnum(c) || c == '_' || c == '$';
+}
+
+// Returns the position after the string or template literal that starts at
+// @pos. Substitutions in template literals are skipped along with the rest. A
+// quote that isn't closed on the same line, such as one in a regular
+// expression literal, only skips to the end of the line.
+[[nodiscard]] static size_t skip_literal(std::string_view source, size_t pos) {
+    char quote = source[pos++];
+    while (pos < source.size()) {
+        char c = source[pos++];
+        if (c == '\\')
+            pos++;
+        else if (c == quote || (c == '\n' && quote != '`'))
+            return pos;
+    }
+    return source.size();
+}
+
+void GjsModulePrefetcher::scan_imports(const char* script, size_t len,
+                                       std::vector<std::string>* names) {
+    std::string_view source(script, len);
+    size_t pos = 0;
+    while (pos < len) {
+        char c = source[pos];
+        if (c == '/' && pos + 1 < len && source[pos + 1] == '/') {
+            pos = source.find('\n', pos);
+            if (pos == std::string_view::npos)
+                break;
+            continue;
+        }
+        if (c == '/' && pos + 1 < len && source[pos + 1] == '*') {
+            pos = source.find("*/", pos + 2);
+            if (pos == std::string_view::npos)
+                break;
+            pos += 2;
+            continue;
+        }
+        if (c == '\'' || c == '"' || c == '`') {
+            pos = skip_literal(source, pos);
+            continue;
+        }
+
+        bool is_member = pos > 0 && (is_identifier_char(source[pos - 1]) ||
+                                     source[pos - 1] == '.');
+        if (is_member || source.compare(pos, IMPORTS_PREFIX.size(),
+                                        IMPORTS_PREFIX) != 0) {
+            pos++;
+            continue;
+        }
+        pos += IMPORTS_PREFIX.size();
+
+        size_t start = pos;
+        while (pos < len && (is_identifier_char(source[pos]) ||
+                             (source[pos] == '.' && pos + 1 < len &&
+                              is_identifier_char(source[pos + 1]))))
+            pos++;
+        if (pos > start)
+            names->emplace_back(source.substr(start, pos - start));
+    }
+}
+
+// Gets the root importer's search path, the same way the importer does
+[[nodiscard]] static bool get_search_path(JSContext* cx,
+                                          std::vector<std::string>* dirs) {
+    JS::RootedObject global(cx, gjs_get_import_global(cx));
+    if (!global)
+        return false;
+    JSAutoRealm ar(cx, global);
+
+    JS::Value v_importer = gjs_get_global_slot(global, GjsGlobalSlot::IMPORTS);
+    if (!v_importer.isObject())
+        return false;
+    JS::RootedObject importer(cx, &v_importer.toObject());
+
+    const GjsAtoms& atoms = GjsContextPrivate::atoms(cx);
+    JS::RootedValue v_search_path(cx);
+    bool is_array;
+    uint32_t len;
+    if (!JS_GetPropertyById(cx, importer, atoms.search_path(),
+                            &v_search_path) ||
+        !v_search_path.isObject())
+        return false;
+    JS::RootedObject search_path(cx, &v_search_path.toObject());
+    if (!JS::IsArrayObject(cx, search_path, &is_array) || !is_array ||
+        !JS::GetArrayLength(cx, search_path, &len))
+        return false;
+
+    JS::RootedValue elem(cx);
+    for (uint32_t i = 0; i < len; i++) {
+        if (!JS_GetElement(cx, search_path, i, &elem))
+            return false;
+        if (!elem.isString())
+            continue;
+
+        JS::RootedString str(cx, elem.toString());
+        JS::UniqueChars dirname(JS_EncodeStringToUTF8(cx, str));
+        if (!dirname)
+            return false;
+        if (dirname[0] != '\0')
+            dirs->push_back(dirname.get());
+    }
+    return true;
+}
+
+// Finds the file that the importer would load for "imports.@name", if it is a
+// module file; returns null otherwise
+[[nodiscard]] static GFile* resolve_import(
+    GjsImportPathCache* path_cache, const std::vector<std::string>& search_path,
+    const std::string& name) {
+    GjsAutoStrv parts = g_strsplit(name.c_str(), ".", -1);
+    // Native modules such as gi, and properties of the importer itself
+    if (gjs_is_registered_native_module(parts[0]) ||
+        g_str_has_prefix(parts[0], "__") || g_str_equal(parts[0], "searchPath"))
+        return nullptr;
+
+    for (const std::string& dir : search_path) {
+        GjsAutoChar base = g_strdup(dir.c_str());
+        for (size_t ix = 0; parts[ix]; ix++) {
+            // A directory is a sub-importer, and takes precedence
+            if (path_cache->query_file_type(base, parts[ix]) ==
+                G_FILE_TYPE_DIRECTORY) {
+                base = g_build_filename(base, parts[ix], nullptr);
+                continue;
+            }
+
+            GjsAutoChar filename = g_strconcat(parts[ix], ".js", nullptr);
+            if (path_cache->exists(base, filename)) {
+                GjsAutoChar full_path =
+                    g_build_filename(base, filename.get(), nullptr);
+                return g_file_new_for_commandline_arg(full_path);
+            }
+            break;
+        }
+    }
+    return nullptr;
+}
+
+GjsModulePrefetcher::GjsModulePrefetcher() {
+    g_mutex_init(&m_lock);
+    g_cond_init(&m_finished);
+}
+
+GjsModulePrefetcher::~GjsModulePrefetcher() {
+    g_assert(m_entries.empty() && "cancel_all() must be called first");
+    g_cond_clear(&m_finished);
+    g_mutex_clear(&m_lock);
+}
+
+// Called on a helper thread
+void GjsModulePrefetcher::on_compiled(JS::OffThreadToken* token, void* data) {
+    auto* entry = static_cast<Entry*>(data);
+    GjsModulePrefetcher* self = entry->prefetcher;
+
+    g_mutex_lock(&self->m_lock);
+    entry->token = token;
+    g_cond_broadcast(&self->m_finished);
+    g_mutex_unlock(&self->m_lock);
+}
+
+void GjsModulePrefetcher::wait_for(JSContext* cx, Entry* entry) {
+    g_mutex_lock(&m_lock);
+    bool finished = entry->token;
+    g_mutex_unlock(&m_lock);
+    if (finished)
+        return;
+
+    // Helper threads don't finish parsing while an incremental GC is in
+    // progress, so waiting without finishing it could deadlock
+    if (JS::IsIncrementalGCInProgress(cx)) {
+        JS::PrepareForIncrementalGC(cx);
+        JS::FinishIncrementalGC(cx, JS::GCReason::API);
+    }
+
+    g_mutex_lock(&m_lock);
+    while (!entry->token)
+        g_cond_wait(&m_finished, &m_lock);
+    g_mutex_unlock(&m_lock);
+}
+
+void GjsModulePrefetcher::prefetch_file(JSContext* cx, GFile* file) {
+    GjsAutoChar filename = g_file_get_parse_name(file);
+    // GJS's own modules are precompiled
+    if (g_str_has_prefix(filename, "resource:///org/gnome/gjs/"))
+        return;
+    if (!m_seen.insert(filename.get()).second || m_seen.size() > MAX_ENTRIES)
+        return;
+
+    char* unowned_source;
+    gsize len;
+    if (!g_file_load_contents(file, nullptr, &unowned_source, &len, nullptr,
+                              nullptr))
+        return;
+    auto entry = std::make_unique<Entry>();
+    entry->prefetcher = this;
+    entry->source = unowned_source;  // steals ownership
+    entry->source_len = len;
+
+    GjsAutoChar path = g_file_get_path(file);
+    GjsContextPrivate* gjs = GjsContextPrivate::from_cx(cx);
+    if (path && gjs->bytecode_cache().has_entry(path, entry->source, len))
+        return;
+
+    entry->utf16_source = gjs_utf8_script_to_utf16(entry->source, len);
+
+    // Same options as the importer compiles the module with
+    JS::CompileOptions options(cx);
+    options.setFileAndLine(filename, 1).setNonSyntacticScope(true);
+    if (!JS::CanCompileOffThread(cx, options, entry->utf16_source.size()))
+        return;
+
+    JS::SourceText<char16_t> buf;
+    if (!buf.init(cx, entry->utf16_source.c_str(), entry->utf16_source.size(),
+                  JS::SourceOwnership::Borrowed) ||
+        !JS::CompileOffThread(cx, options, buf, on_compiled, entry.get())) {
+        JS_ClearPendingException(cx);
+        return;
+    }
+
+    gjs_debug(GJS_DEBUG_IMPORTER, "Compiling %s on a helper thread",
+              filename.get());
+    m_entries.emplace(filename.get(), std::move(entry));
+}
+
+void GjsModulePrefetcher::prefetch_imports(JSContext* cx, const char* script,
+                                           size_t len) {
+    std::vector<std::string> names;
+    scan_imports(script, len, &names);
+    if (names.empty())
+        return;
+
+    GjsImportPathCache& path_cache =
+        GjsContextPrivate::from_cx(cx)->import_path_cache();
+    std::vector<std::string> search_path;
+    if (!get_search_path(cx, &search_path)) {
+        JS_ClearPendingException(cx);
+        return;
+    }
+
+    for (const std::string& name : names) {
+        GjsAutoUnref<GFile> file =
+            resolve_import(&path_cache, search_path, name);
+        if (file)
+            prefetch_file(cx, file);
+    }
+}
+
+bool GjsModulePrefetcher::take(JSContext* cx, const char* filename,
+                               const char* script, size_t len,
+                               JS::MutableHandleScript compiled) {
+    if (!filename)
+        return false;
+    auto it = m_entries.find(filename);
+    if (it == m_entries.end())
+        return false;
+    std::unique_ptr<Entry> entry = std::move(it->second);
+    m_entries.erase(it);
+
+    wait_for(cx, entry.get());
+    compiled.set(JS::FinishOffThreadScript(cx, entry->token));
+    if (!compiled) {
+        // Compiled again on the main thread, which reports the error
+        JS_ClearPendingException(cx);
+        return false;
+    }
+
+    // The file changed between prefetching and importing it
+    if (entry->source_len != len ||
+        memcmp(entry->source, script, len) != 0) {
+        compiled.set(nullptr);
+        return false;
+    }
+
+    m_hits++;
+    return true;
+}
+
+size_t GjsModulePrefetcher::cancel_all(JSContext* cx) {
+    size_t n_cancelled = m_entries.size();
+    for (auto& it : m_entries) {
+        wait_for(cx, it.second.get());
+        JS::CancelOffThreadScript(cx, it.second->token);
+    }
+    m_entries.clear();
+    m_seen.clear();
+    return n_cancelled;
+}
@@ -0,0 +1,104 @@
+/* -*- mode: C++; c-basic-offset: 4; indent-tabs-mode: nil; -*- */
+// SPDX-License-Identifier: MIT OR LGPL-2.0-or-later
+// SPDX-FileCopyrightText: 2020 GNOME Foundation
+
+#ifndef GJS_MODULE_PREFETCH_H_
+#define GJS_MODULE_PREFETCH_H_
+
+#include <config.h>
+
+#include <stddef.h>  // for size_t
+
+#include <memory>  // for unique_ptr
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include <gio/gio.h>
+#include <glib.h>
+
+#include <js/TypeDecls.h>
+
+#include "gjs/jsapi-util.h"
+
+namespace JS {
+class OffThreadToken;
+}
+
+/*
+ * GjsModulePrefetcher:
+ *
+ * Compiles the modules that a script imports on SpiderMonkey's helper threads,
+ * while the main thread is still busy with the script itself.
+ *
+ * When a program's main script isn't in the bytecode cache, GjsContext first
+ * looks for "imports.a.b" in it, and resolves those names against the root
+ * importer's search path the way the importer would. Each module found that
+ * isn't in the bytecode cache either is compiled off the main thread. When the
+ * importer later gets to one of them, and its source is still the same, it
+ * takes the finished script instead of parsing it, waiting for the helper
+ * thread if needed.
+ *
+ * Reading the modules, checking the cache and transcoding them still happens
+ * on the main thread, so only the main script's own imports are prefetched,
+ * and not what those modules import in turn.
+ *
+ * The scan is textual, so it may find imports that are never executed; those
+ * compilations are thrown away when the context is disposed. GJS's own modules
+ * are skipped, since they are compiled when GJS is built.
+ */
+class GjsModulePrefetcher {
+    struct Entry {
+        GjsModulePrefetcher* prefetcher;
+        GjsAutoChar source;
+        size_t source_len;
+        // Borrowed by the compilation, so it must live as long as it
+        std::u16string utf16_source;
+        // Set from the helper thread when the compilation is finished
+        JS::OffThreadToken* token = nullptr;
+    };
+
+    // Keyed by the filename that the importer compiles the module with
+    std::unordered_map<std::string, std::unique_ptr<Entry>> m_entries;
+    // Every file that was considered, whether it was compiled or not
+    std::unordered_set<std::string> m_seen;
+
+    // Number of scripts taken
+    unsigned m_hits = 0;
+
+    GMutex m_lock;
+    GCond m_finished;
+
+    static void on_compiled(JS::OffThreadToken* token, void* data);
+    void wait_for(JSContext* cx, Entry* entry);
+    void prefetch_file(JSContext* cx, GFile* file);
+
+ public:
+    GjsModulePrefetcher();
+    ~GjsModulePrefetcher();
+
+    // Starts compiling the modules that @script imports in the background
+    void prefetch_imports(JSContext* cx, const char* script, size_t len);
+
+    // Gets the script that was compiled in the background from @script, which
+    // was loaded from @filename; false if there is none
+    [[nodiscard]] bool take(JSContext* cx, const char* filename,
+                            const char* script, size_t len,
+                            JS::MutableHandleScript compiled);
+
+    [[nodiscard]] unsigned hits() const { return m_hits; }
+
+    // Waits for and discards the compilations that were never taken, and
+    // returns how many there were; must be called before the JSContext is
+    // destroyed
+    size_t cancel_all(JSContext* cx);
+
+    // Finds the names in "imports.a.b.c" expressions in @script, as "a.b.c",
+    // skipping comments and string and template literals; regular expression
+    // literals are not recognized
+    static void scan_imports(const char* script, size_t len,
+                             std::vector<std::string>* names);
+};
+
+#endif  // GJS_MODULE_PREFETCH_H_
@@ -7,8 +7,6 @@
 #include <stddef.h>     // for size_t
 #include <sys/types.h>  // for ssize_t
 
-#include <string>  // for u16string
-
 #include <gio/gio.h>
 #include <glib.h>
 
@@ -18,7 +16,6 @@
 #include <js/GCVector.h>  // for RootedVector
 #include <js/PropertyDescriptor.h>
 #include <js/RootingAPI.h>
-#include <js/SourceText.h>
 #include <js/TypeDecls.h>
 #include <js/Value.h>
 #include <jsapi.h>  // for JS_DefinePropertyById, ...
@@ -81,17 +78,7 @@ class GjsScriptModule {
     GJS_JSAPI_RETURN_CONVENTION
     bool evaluate_import(JSContext* cx, JS::HandleObject module,
                          const char* script, ssize_t script_len,
-                         const char* filename) {
-        std::u16string utf16_string =
-            gjs_utf8_script_to_utf16(script, script_len);
-        // COMPAT: This could use JS::SourceText<mozilla::Utf8Unit> directly,
-        // but that messes up code coverage. See bug
-        // https://bugzilla.mozilla.org/show_bug.cgi?id=1404784
-        JS::SourceText<char16_t> buf;
-        if (!buf.init(cx, utf16_string.c_str(), utf16_string.size(),
-                      JS::SourceOwnership::Borrowed))
-            return false;
-
+                         const char* filename, const char* path) {
         JS::RootedObjectVector scope_chain(cx);
         if (!scope_chain.append(module)) {
             JS_ReportOutOfMemory(cx);
@@ -101,11 +88,15 @@ class GjsScriptModule {
         JS::CompileOptions options(cx);
         options.setFileAndLine(filename, 1);
 
+        GjsContextPrivate* gjs = GjsContextPrivate::from_cx(cx);
+        JS::RootedScript compiled(
+            cx, gjs->bytecode_cache().compile(cx, options, path, script,
+                                              script_len));
         JS::RootedValue ignored_retval(cx);
-        if (!JS::Evaluate(cx, scope_chain, options, buf, &ignored_retval))
+        if (!compiled ||
+            !JS_ExecuteScript(cx, scope_chain, compiled, &ignored_retval))
             return false;
 
-        GjsContextPrivate* gjs = GjsContextPrivate::from_cx(cx);
         gjs->schedule_gc_if_needed();
 
         gjs_debug(GJS_DEBUG_IMPORTER, "Importing module %s succeeded", m_name);
@@ -132,7 +123,10 @@ class GjsScriptModule {
         g_assert(script);
 
         GjsAutoChar full_path = g_file_get_parse_name(file);
-        return evaluate_import(cx, module, script, script_len, full_path);
+        // Null for files that are not local, which are not cached
+        GjsAutoChar path = g_file_get_path(file);
+        return evaluate_import(cx, module, script, script_len, full_path,
+                               path);
     }
 
     /* JSClass operations */
@@ -20,6 +20,20 @@ void _gjs_profiler_add_mark(GjsProfiler* self, int64_t time, int64_t duration,
 
 [[nodiscard]] bool _gjs_profiler_is_running(GjsProfiler* self);
 
+// Counters that GJS reports to Sysprof, on top of the samples and marks
+enum GjsProfilerCounter {
+    // Wrappers toggled down since the previous check of the GC policy
+    GJS_COUNTER_TOGGLE_DOWN_BATCH,
+    // Wrappers toggled down per second, smoothed
+    GJS_COUNTER_TOGGLE_DOWN_RATE,
+    // Toggled-down wrappers that the GC policy expects a collection to free
+    GJS_COUNTER_COLLECTABLE_WRAPPERS,
+    GJS_N_PROFILER_COUNTERS
+};
+
+void _gjs_profiler_set_counter(GjsProfiler* self, int64_t time,
+                               GjsProfilerCounter counter, int64_t value);
+
 void _gjs_profiler_setup_signals(GjsProfiler *self, GjsContext *context);
 
 #endif  // GJS_PROFILER_PRIVATE_H_
@@ -15,7 +15,7 @@
 #    include <errno.h>
 #    include <stdint.h>
 #    include <stdio.h>      // for sscanf
-#    include <string.h>     // for memcpy, strlen
+#    include <string.h>     // for memcpy, memset, strlen
 #    include <sys/types.h>  // for timer_t
 #    include <syscall.h>    // for __NR_gettid
 #    include <time.h>       // for size_t, CLOCK_MONOTONIC, itimerspec, ...
@@ -34,6 +34,7 @@
 
 #include "gjs/context.h"
 #include "gjs/jsapi-util.h"
+#include "gjs/profiler-private.h"
 #include "gjs/profiler.h"
 
 #define FLUSH_DELAY_SECONDS 3
@@ -104,6 +105,9 @@ struct _GjsProfiler {
 
     /* GLib signal handler ID for SIGUSR2 */
     unsigned sigusr2_id;
+
+    /* ID of the first of our counters in the capture */
+    unsigned counter_base;
 #endif  /* ENABLE_PROFILER */
 
     /* If we are currently sampling */
@@ -113,6 +117,46 @@ struct _GjsProfiler {
 static GjsContext *profiling_context;
 
 #ifdef ENABLE_PROFILER
+static const struct {
+    const char* name;
+    const char* description;
+} counter_info[GJS_N_PROFILER_COUNTERS] = {
+    {"Toggle-down batch", "Wrappers toggled down since the last GC check"},
+    {"Toggle-down rate", "Wrappers toggled down per second"},
+    {"Collectable wrappers", "Toggled-down wrappers a GC is expected to free"},
+};
+
+/*
+ * gjs_profiler_define_counters:
+ *
+ * Declares GJS's counters in the capture file, so that values can be added
+ * with _gjs_profiler_set_counter().
+ *
+ * Returns: %TRUE if successful.
+ */
+[[nodiscard]] static bool gjs_profiler_define_counters(GjsProfiler* self) {
+    int64_t now = g_get_monotonic_time() * 1000L;
+    SysprofCaptureCounter counters[GJS_N_PROFILER_COUNTERS];
+
+    self->counter_base = sysprof_capture_writer_request_counter(
+        self->capture, GJS_N_PROFILER_COUNTERS);
+
+    for (unsigned ix = 0; ix < GJS_N_PROFILER_COUNTERS; ix++) {
+        SysprofCaptureCounter* counter = &counters[ix];
+        memset(counter, 0, sizeof(*counter));
+        g_strlcpy(counter->category, "GJS", sizeof(counter->category));
+        g_strlcpy(counter->name, counter_info[ix].name, sizeof(counter->name));
+        g_strlcpy(counter->description, counter_info[ix].description,
+                  sizeof(counter->description));
+        counter->id = self->counter_base + ix;
+        counter->type = SYSPROF_CAPTURE_COUNTER_INT64;
+        counter->value.v64 = 0;
+    }
+
+    return sysprof_capture_writer_define_counters(
+        self->capture, now, -1, self->pid, counters, GJS_N_PROFILER_COUNTERS);
+}
+
 /*
  * gjs_profiler_extract_maps:
  *
@@ -451,6 +495,9 @@ gjs_profiler_start(GjsProfiler *self)
         return;
     }
 
+    if (!gjs_profiler_define_counters(self))
+        g_warning("Failed to define counters");
+
     /* Setup our signal handler for SIGPROF delivery */
     sa.sa_flags = SA_RESTART | SA_SIGINFO;
     sa.sa_sigaction = gjs_profiler_sigprof;
@@ -720,6 +767,26 @@ void _gjs_profiler_add_mark(GjsProfiler* self, gint64 time_nsec,
 #endif
 }
 
+void _gjs_profiler_set_counter(GjsProfiler* self, int64_t time_nsec,
+                               GjsProfilerCounter counter, int64_t value) {
+    g_return_if_fail(self);
+    g_return_if_fail(counter < GJS_N_PROFILER_COUNTERS);
+
+#ifdef ENABLE_PROFILER
+    if (self->running && self->capture != nullptr) {
+        unsigned id = self->counter_base + counter;
+        SysprofCaptureCounterValue counter_value;
+        counter_value.v64 = value;
+        sysprof_capture_writer_set_counters(self->capture, time_nsec, -1,
+                                            self->pid, &id, &counter_value, 1);
+    }
+#else
+    // Unused in the no-profiler case
+    (void)time_nsec;
+    (void)value;
+#endif
+}
+
 void gjs_profiler_set_fd(GjsProfiler* self, int fd) {
     g_return_if_fail(self);
     g_return_if_fail(!self->filename);
@@ -466,6 +466,18 @@ describe('C array with length', function () {
         expect(() => GIMarshallingTests.array_in_guint8_len([-1, 0, 1, 2])).not.toThrow();
     });
 
+    it('marshals a typed array of the same element type', function () {
+        expect(() => GIMarshallingTests.array_in(new Int32Array([-1, 0, 1, 2])))
+            .not.toThrow();
+    });
+
+    it('marshals a typed array of a different element type', function () {
+        expect(() => GIMarshallingTests.array_in(new Float64Array([-1, 0, 1, 2])))
+            .not.toThrow();
+        expect(() => GIMarshallingTests.array_in(new Int8Array([-1, 0, 1, 2])))
+            .not.toThrow();
+    });
+
     it('can be an out argument along with other arguments', function () {
         let [array, sum] = GIMarshallingTests.array_out_etc(9, 5);
         expect(sum).toEqual(14);
@@ -1743,6 +1755,34 @@ describe('GObject properties', function () {
         ByteArray.fromString('👾'),
         'https://gitlab.gnome.org/GNOME/gjs/issues/276');
 
+    it('converts non-number values when setting numeric properties', function () {
+        obj.some_int = '42';
+        expect(obj.some_int).toEqual(42);
+        obj.some_uint = {valueOf: () => 64};
+        expect(obj.some_uint).toEqual(64);
+        obj.some_double = 2.5;
+        obj.some_int = obj.some_double;
+        expect(obj.some_int).toEqual(2);
+    });
+
+    it('converts truthy and falsy values when setting a boolean property', function () {
+        obj.some_boolean = 'yes';
+        expect(obj.some_boolean).toBe(true);
+        obj.some_boolean = 0;
+        expect(obj.some_boolean).toBe(false);
+    });
+
+    it('sets an object property to null', function () {
+        obj.some_object = new GObject.Object();
+        obj.some_object = null;
+        expect(obj.some_object).toBeNull();
+    });
+
+    it('throws when setting an object property to the wrong type', function () {
+        expect(() => (obj.some_object = 'foo')).toThrow();
+        expect(() => (obj.some_object = new GLib.Variant('b', true))).toThrow();
+    });
+
     it('gets a read-only property', function () {
         expect(obj.some_readonly).toEqual(42);
     });
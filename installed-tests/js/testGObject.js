@@ -28,6 +28,29 @@ describe('GObject overrides', function () {
         expect(o.int).toBe(42);
     });
 
+    it('GObject.set() emits each notification once', function () {
+        const o = new TestObj();
+        const notifySpy = jasmine.createSpy('notifySpy');
+        o.connect('notify', notifySpy);
+        o.set({string: 'Answer', int: 42});
+        expect(notifySpy).toHaveBeenCalledTimes(2);
+    });
+
+    it('GObject.set() also sets non-GObject properties', function () {
+        const o = new TestObj();
+        o.set({int: 42, jsOnly: 'value'});
+        expect(o.int).toBe(42);
+        expect(o.jsOnly).toBe('value');
+    });
+
+    it('GObject.get()', function () {
+        const o = new TestObj({string: 'Answer', int: 42});
+        expect(o.get(['int', 'string'])).toEqual([42, 'Answer']);
+        expect(o.get([])).toEqual([]);
+        expect(() => o.get(['nonexistent'])).toThrow();
+        expect(() => o.get('int')).toThrow();
+    });
+
     describe('Signal alternative syntax', function () {
         let o, handler;
         beforeEach(function () {
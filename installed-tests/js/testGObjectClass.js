@@ -23,6 +23,7 @@ const MyObject = GObject.registerClass({
     Signals: {
         'empty': {},
         'minimal': {param_types: [GObject.TYPE_INT, GObject.TYPE_INT]},
+        'many-args': {param_types: Array(10).fill(GObject.TYPE_INT)},
         'full': {
             flags: GObject.SignalFlags.RUN_LAST,
             accumulator: GObject.AccumulatorType.FIRST_WINS,
@@ -251,6 +252,63 @@ describe('GObject class with decorator', function () {
         expect(minimalSpy).toHaveBeenCalledWith(myInstance, 7, 5);
     });
 
+    it('passes emitted arguments to signals with many parameters', function () {
+        const args = [1, 2, 3, 4, 5, 6, 7, 8, 9, 10];
+        let manyArgsSpy = jasmine.createSpy('manyArgsSpy');
+        myInstance.connect('many-args', manyArgsSpy);
+        myInstance.emit('many-args', ...args);
+
+        expect(manyArgsSpy).toHaveBeenCalledWith(myInstance, ...args);
+    });
+
+    it('emits detailed signals repeatedly with names built at runtime', function () {
+        let detailedSpy = jasmine.createSpy('detailedSpy');
+        myInstance.connect(`detailed::${'one'}`, detailedSpy);
+        for (let i = 0; i < 3; i++) {
+            myInstance.emit(['detailed', 'one'].join('::'), `${i}`);
+            myInstance.emit(['detailed', 'two'].join('::'), `${i}`);
+        }
+
+        expect(detailedSpy).toHaveBeenCalledTimes(3);
+        expect(detailedSpy).toHaveBeenCalledWith(myInstance, '2');
+    });
+
+    it('connects to a detail that was first only emitted', function () {
+        const name = 'detailed::first-emitted-detail';
+        myInstance.emit(name, 'emitted');
+        let detailedSpy = jasmine.createSpy('detailedSpy');
+        myInstance.connect(name, detailedSpy);
+        myInstance.emit('detailed::two', 'other');
+        myInstance.emit(name, 'detailed');
+
+        expect(detailedSpy).toHaveBeenCalledTimes(1);
+        expect(detailedSpy).toHaveBeenCalledWith(myInstance, 'detailed');
+    });
+
+    it('connects to details built at run time', function () {
+        let detailedSpy = jasmine.createSpy('detailedSpy');
+        for (let ix = 0; ix < 10; ix++)
+            myInstance.connect(`detailed::run-time-${ix}`, detailedSpy);
+        myInstance.emit('detailed::run-time-3', 'three');
+
+        expect(detailedSpy).toHaveBeenCalledTimes(1);
+        expect(detailedSpy).toHaveBeenCalledWith(myInstance, 'three');
+    });
+
+    it('rejects details on undetailed signals and empty details', function () {
+        expect(() => myInstance.connect('empty::detail', () => {}))
+            .toThrowError(/No signal 'empty::detail'/);
+        expect(() => myInstance.connect('detailed::', () => {}))
+            .toThrowError(/No signal 'detailed::'/);
+        expect(() => myInstance.connect('detailed:one', () => {}))
+            .toThrowError(/No signal 'detailed:one'/);
+    });
+
+    it('includes the detail in the error for a wrong number of arguments', function () {
+        expect(() => myInstance.emit('detailed::one'))
+            .toThrowError(/'detailed::one'.*requires 1 args got 0/);
+    });
+
     it('can return values from signals', function () {
         let fullSpy = jasmine.createSpy('fullSpy').and.returnValue(42);
         myInstance.connect('full', fullSpy);
@@ -7,7 +7,7 @@
 
 imports.gi.versions.Gdk = '3.0';
 imports.gi.versions.Gtk = '3.0';
-const {Gdk, Gio, GLib, GObject, Gtk} = imports.gi;
+const {Gdk, Gio, GjsPrivate, GLib, GObject, Gtk} = imports.gi;
 const System = imports.system;
 
 describe('GLib.DestroyNotify parameter', function () {
@@ -36,6 +36,47 @@ describe('Unsafe integer marshalling', function () {
     });
 });
 
+describe('Arrays annotated with gjs.typed-array', function () {
+    it('are returned as TypedArrays, taking over the C array', function () {
+        const array = GjsPrivate.test_typed_array_new(4);
+        expect(array).toEqual(jasmine.any(Uint16Array));
+        expect(Array.from(array)).toEqual([0, 1, 2, 3]);
+    });
+
+    it('copy arrays that the caller does not own', function () {
+        const array = GjsPrivate.test_typed_array_get_static();
+        expect(array).toEqual(jasmine.any(Float64Array));
+        expect(Array.from(array)).toEqual([0.5, -1.5, 1e100]);
+
+        array[0] = 42;
+        expect(GjsPrivate.test_typed_array_get_static()[0]).toEqual(0.5);
+    });
+
+    it('are converted in out arguments', function () {
+        const array = GjsPrivate.test_typed_array_out();
+        expect(array).toEqual(jasmine.any(Int32Array));
+        expect(Array.from(array)).toEqual([-1, 0, 2147483647]);
+    });
+
+    it('are converted from GArrays', function () {
+        const array = GjsPrivate.test_typed_array_new_garray();
+        expect(array).toEqual(jasmine.any(Float32Array));
+        expect(Array.from(array)).toEqual([0.25, -2]);
+    });
+
+    it('are converted from GArrays in out arguments', function () {
+        const array = GjsPrivate.test_typed_array_garray_out();
+        expect(array).toEqual(jasmine.any(Uint8Array));
+        expect(Array.from(array)).toEqual([1, 2, 255]);
+    });
+
+    it('are not used without the annotation', function () {
+        const array = GjsPrivate.test_typed_array_new_plain(3);
+        expect(Array.isArray(array)).toBe(true);
+        expect(array).toEqual([0, 1, 2]);
+    });
+});
+
 describe('Marshalling empty flat arrays of structs', function () {
     let widget;
     beforeAll(function () {
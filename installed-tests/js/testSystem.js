@@ -50,8 +50,134 @@ describe('System.gc()', function () {
     });
 });
 
+describe('System.memoryReport()', function () {
+    it('counts wrappers and their native memory', function () {
+        const objects = [];
+        for (let i = 0; i < 10; i++)
+            objects.push(new GObject.Object());
+        const report = System.memoryReport();
+        expect(report.counts.objectInstance).not.toBeLessThan(10);
+        expect(report.bytes.objectInstance).toBeGreaterThan(0);
+        expect(report.bytes.total).not.toBeLessThan(report.bytes.objectInstance);
+        expect(report.js.gcBytes).toBeGreaterThan(0);
+    });
+
+    it('accounts for caches shared by all wrappers', function () {
+        const obj = new GObject.Object();
+        obj.connect('notify', () => {});
+        expect(GObject.Object.$gtype.name).toEqual('GObject');
+        const {bytes} = System.memoryReport();
+        expect(bytes.prototypeCache).toBeGreaterThan(0);
+        expect(bytes.signalPlanCache).toBeGreaterThan(0);
+        expect(bytes.staticStringCache).toBeGreaterThan(0);
+        expect(bytes.total).not.toBeLessThan(bytes.prototypeCache +
+            bytes.signalPlanCache + bytes.staticStringCache);
+    });
+
+    it('counts the weak wrappers examined after a GC', function () {
+        const objects = [];
+        for (let i = 0; i < 10; i++)
+            objects.push(new GObject.Object());
+        System.gc();
+        expect(System.memoryReport().js.weakWrappersExamined)
+            .not.toBeLessThan(objects.length);
+    });
+
+    it('accounts for boxed memory owned by the wrapper', function () {
+        const GLib = imports.gi.GLib;
+        const before = System.memoryReport().bytes.boxedInstance;
+        const pollfd = new GLib.PollFD({fd: 1});
+        expect(System.memoryReport().bytes.boxedInstance).toBeGreaterThan(before);
+        expect(pollfd.fd).toEqual(1);
+    });
+});
+
+describe('System.releaseMemory()', function () {
+    it('returns the number of bytes released', function () {
+        expect(System.releaseMemory()).not.toBeLessThan(0);
+    });
+
+    it('leaves objects and boxed types working afterwards', function () {
+        const GLib = imports.gi.GLib;
+        const o = new GObject.Object();
+        const pollfd = new GLib.PollFD({fd: 1, events: 2});
+        expect(pollfd.fd).toEqual(1);
+        expect(o.not_a_method).toBeUndefined();
+        System.releaseMemory();
+        expect(pollfd.events).toEqual(2);
+        expect(o.not_a_method).toBeUndefined();
+        expect(o.toString()).toMatch(/GObject_Object/);
+    });
+
+    it('leaves introspected GObject fields readable afterwards', function () {
+        const Regress = imports.gi.Regress;
+        const o = new Regress.TestObj();
+        const sub = new Regress.TestSubObj();
+        expect(o.some_int8).toEqual(0);
+        expect(sub.some_double).toEqual(0);
+        System.releaseMemory();
+        expect(o.some_int8).toEqual(0);
+        expect(o.some_double).toEqual(0);
+        expect(sub.some_double).toEqual(0);
+        expect(sub.some_int8).toEqual(0);
+    });
+});
+
+describe('System.setGCFrameClock()', function () {
+    const FakeFrameClock = GObject.registerClass({
+        Signals: {'after-paint': {}},
+    }, class FakeFrameClock extends GObject.Object {});
+
+    afterEach(function () {
+        System.setGCFrameClock(null);
+    });
+
+    it('accepts an object with an after-paint signal', function () {
+        const clock = new FakeFrameClock();
+        System.setGCFrameClock(clock);
+        expect(() => clock.emit('after-paint')).not.toThrow();
+    });
+
+    it('does not keep the frame clock alive', function () {
+        const clock = new FakeFrameClock();
+        System.setGCFrameClock(clock);
+        expect(System.refcount(clock)).toEqual(1);
+    });
+
+    it('throws for objects without an after-paint signal', function () {
+        expect(() => System.setGCFrameClock(new GObject.Object()))
+            .toThrowError(/has no after-paint signal/);
+    });
+});
+
 describe('System.dumpHeap()', function () {
     it('throws but does not crash when given a nonexistent path', function () {
         expect(() => System.dumpHeap('/does/not/exist')).toThrow();
     });
 });
+
+describe('System.dumpHeapSnapshot()', function () {
+    const GLib = imports.gi.GLib;
+    let filename;
+
+    beforeEach(function () {
+        filename = GLib.build_filenamev([GLib.get_tmp_dir(),
+            `gjs-heap-snapshot-${GLib.random_int()}`]);
+    });
+
+    afterEach(function () {
+        GLib.unlink(filename);
+    });
+
+    it('writes a snapshot file', function () {
+        System.dumpHeapSnapshot(filename);
+        const [, contents] = GLib.file_get_contents(filename);
+        const magic = String.fromCharCode(...contents.slice(0, 7));
+        expect(magic).toEqual('GJSHEAP');
+        expect(contents.length).toBeGreaterThan(1000);
+    });
+
+    it('throws but does not crash when given a nonexistent path', function () {
+        expect(() => System.dumpHeapSnapshot('/does/not/exist')).toThrow();
+    });
+});
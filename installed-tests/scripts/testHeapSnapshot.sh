@@ -0,0 +1,70 @@
+#!/bin/sh
+# SPDX-License-Identifier: MIT OR LGPL-2.0-or-later
+# SPDX-FileCopyrightText: 2020 GNOME Foundation
+
+if test "$GJS_USE_UNINSTALLED_FILES" = "1"; then
+    gjs="$TOP_BUILDDIR/gjs-console"
+else
+    gjs="gjs-console"
+fi
+
+# tools/heapsnapshot.py is not installed, so it is only tested uninstalled
+heapsnapshot="$TOP_SRCDIR/tools/heapsnapshot.py"
+
+# Writes one snapshot, and another one with 100 more GObject wrappers alive
+cat <<'EOF' >heapsnapshot.js
+const Gio = imports.gi.Gio;
+const System = imports.system;
+const actions = [];
+function addActions(n) {
+    for (let ix = 0; ix < n; ix++)
+        actions.push(new Gio.SimpleAction({name: 'action'}));
+}
+addActions(10);
+System.dumpHeapSnapshot('before.heapsnapshot');
+addActions(100);
+System.dumpHeapSnapshot('after.heapsnapshot');
+EOF
+
+total=0
+
+report () {
+    exit_code=$?
+    total=$((total + 1))
+    if test $exit_code -eq 0; then
+        echo "ok $total - $1"
+    else
+        echo "not ok $total - $1"
+    fi
+}
+
+skip () {
+    total=$((total + 1))
+    echo "ok $total - $1 # SKIP $2"
+}
+
+$gjs heapsnapshot.js
+report "System.dumpHeapSnapshot() should write snapshots"
+
+if test ! -f "$heapsnapshot" || ! command -v python3 >/dev/null; then
+    reason="heapsnapshot.py or Python is not available"
+    skip "heapsnapshot.py should read a snapshot" "$reason"
+    skip "heapsnapshot.py should group a snapshot by JS type" "$reason"
+    skip "heapsnapshot.py --diff should count the new wrappers" "$reason"
+    skip "heapsnapshot.py should reject files that are not snapshots" "$reason"
+else
+    python3 "$heapsnapshot" after.heapsnapshot | grep -q ' GSimpleAction$'
+    report "heapsnapshot.py should read a snapshot"
+    python3 "$heapsnapshot" --by-type after.heapsnapshot >/dev/null
+    report "heapsnapshot.py should group a snapshot by JS type"
+    python3 "$heapsnapshot" --diff before.heapsnapshot after.heapsnapshot | \
+        grep -q ' +100  GSimpleAction$'
+    report "heapsnapshot.py --diff should count the new wrappers"
+    python3 "$heapsnapshot" heapsnapshot.js 2>&1 | \
+        grep -q 'not a GJS heap snapshot'
+    report "heapsnapshot.py should reject files that are not snapshots"
+fi
+
+rm -f heapsnapshot.js before.heapsnapshot after.heapsnapshot
+
+echo "1..$total"
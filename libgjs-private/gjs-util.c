@@ -8,6 +8,8 @@
 
 #include <locale.h>    /* for setlocale */
 #include <stddef.h>    /* for size_t */
+#include <stdint.h>
+#include <string.h>    /* for memcpy */
 
 #include <gio/gio.h>
 #include <glib-object.h>
@@ -189,6 +191,97 @@ int gjs_open_bytes(GBytes* bytes, GError** error) {
 #endif
 }
 
+/**
+ * gjs_test_typed_array_new:
+ * @n_elements: number of elements
+ * @length: (out): return location for the length of the array
+ *
+ * Creates an array of the numbers from 0 to @n_elements - 1.
+ *
+ * Returns: (array length=length) (transfer full) (attributes gjs.typed-array=1):
+ *   the array, converted to a Uint16Array
+ */
+uint16_t* gjs_test_typed_array_new(unsigned n_elements, size_t* length) {
+    uint16_t* retval = g_new(uint16_t, n_elements);
+    unsigned ix;
+
+    for (ix = 0; ix < n_elements; ix++)
+        retval[ix] = ix;
+    *length = n_elements;
+    return retval;
+}
+
+/**
+ * gjs_test_typed_array_get_static:
+ * @length: (out): return location for the length of the array
+ *
+ * Returns: (array length=length) (transfer none) (attributes gjs.typed-array=1):
+ *   an array owned by the library, copied into a Float64Array
+ */
+const double* gjs_test_typed_array_get_static(size_t* length) {
+    static const double values[] = {0.5, -1.5, 1e100};
+
+    *length = G_N_ELEMENTS(values);
+    return values;
+}
+
+/**
+ * gjs_test_typed_array_out:
+ * @array: (out) (array length=length) (transfer full) (attributes gjs.typed-array=1):
+ *   return location for an array, converted to an Int32Array
+ * @length: (out): return location for the length of @array
+ */
+void gjs_test_typed_array_out(int32_t** array, size_t* length) {
+    static const int32_t values[] = {-1, 0, G_MAXINT32};
+
+    *array = g_new(int32_t, G_N_ELEMENTS(values));
+    memcpy(*array, values, sizeof(values));
+    *length = G_N_ELEMENTS(values);
+}
+
+/**
+ * gjs_test_typed_array_new_garray:
+ *
+ * Returns: (element-type float) (transfer full) (attributes gjs.typed-array=1):
+ *   a #GArray, converted to a Float32Array
+ */
+GArray* gjs_test_typed_array_new_garray(void) {
+    static const float values[] = {0.25f, -2.0f};
+
+    GArray* retval = g_array_sized_new(FALSE, FALSE, sizeof(float),
+                                       G_N_ELEMENTS(values));
+    g_array_append_vals(retval, values, G_N_ELEMENTS(values));
+    return retval;
+}
+
+/**
+ * gjs_test_typed_array_garray_out:
+ * @array: (out) (element-type guint8) (transfer full) (attributes gjs.typed-array=1):
+ *   return location for a #GArray, converted to a Uint8Array
+ */
+void gjs_test_typed_array_garray_out(GArray** array) {
+    static const uint8_t values[] = {1, 2, 255};
+
+    *array = g_array_sized_new(FALSE, FALSE, sizeof(uint8_t),
+                               G_N_ELEMENTS(values));
+    g_array_append_vals(*array, values, G_N_ELEMENTS(values));
+}
+
+/**
+ * gjs_test_typed_array_new_plain:
+ * @n_elements: number of elements
+ * @length: (out): return location for the length of the array
+ *
+ * Like gjs_test_typed_array_new(), without the annotation.
+ *
+ * Returns: (array length=length) (transfer full): the array, converted to an
+ *   Array
+ */
+uint16_t* gjs_test_typed_array_new_plain(unsigned n_elements,
+                                         size_t* length) {
+    return gjs_test_typed_array_new(n_elements, length);
+}
+
 static GParamSpec* gjs_gtk_container_class_find_child_property(
     GIObjectInfo* container_info, GObject* container, const char* property) {
     GIBaseInfo* class_info = NULL;
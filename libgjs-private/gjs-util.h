@@ -8,6 +8,8 @@
 #define LIBGJS_PRIVATE_GJS_UTIL_H_
 
 #include <locale.h>
+#include <stddef.h>  /* for size_t */
+#include <stdint.h>
 
 #include <glib-object.h>
 #include <glib.h>
@@ -61,6 +63,19 @@ void gjs_gtk_container_child_set_property(GObject* container, GObject* child,
 GJS_EXPORT
 int gjs_open_bytes(GBytes* bytes, GError** error);
 
+GJS_EXPORT
+uint16_t* gjs_test_typed_array_new(unsigned n_elements, size_t* length);
+GJS_EXPORT
+const double* gjs_test_typed_array_get_static(size_t* length);
+GJS_EXPORT
+void gjs_test_typed_array_out(int32_t** array, size_t* length);
+GJS_EXPORT
+GArray* gjs_test_typed_array_new_garray(void);
+GJS_EXPORT
+void gjs_test_typed_array_garray_out(GArray** array);
+GJS_EXPORT
+uint16_t* gjs_test_typed_array_new_plain(unsigned n_elements, size_t* length);
+
 G_END_DECLS
 
 #endif /* LIBGJS_PRIVATE_GJS_UTIL_H_ */
@@ -10,6 +10,8 @@
 #include <string.h>  // for strerror
 #include <time.h>    // for tzset
 
+#include <string>
+
 #include <glib-object.h>
 #include <glib.h>
 
@@ -23,11 +25,15 @@
 #include <jsapi.h>        // for JS_DefinePropertyById, JS_DefineF...
 #include <jsfriendapi.h>  // for DumpHeap, IgnoreNurseryObjects
 
+#include "gi/boxed.h"
 #include "gi/object.h"
+#include "gi/value.h"
 #include "gjs/atoms.h"
 #include "gjs/context-private.h"
+#include "gjs/heap-snapshot.h"
 #include "gjs/jsapi-util-args.h"
 #include "gjs/jsapi-util.h"
+#include "gjs/mem-private.h"
 #include "modules/system.h"
 #include "util/log.h"
 
@@ -139,6 +145,37 @@ gjs_dump_heap(JSContext *cx,
     return true;
 }
 
+GJS_JSAPI_RETURN_CONVENTION
+static bool gjs_dump_heap_snapshot(JSContext* cx, unsigned argc,
+                                   JS::Value* vp) {
+    JS::CallArgs args = JS::CallArgsFromVp(argc, vp);
+    GjsAutoChar filename;
+
+    if (!gjs_parse_call_args(cx, "dumpHeapSnapshot", args, "F", "filename",
+                             &filename))
+        return false;
+
+    FILE* fp = fopen(filename, "wb");
+    if (!fp) {
+        gjs_throw(cx, "Cannot write heap snapshot to %s: %s", filename.get(),
+                  strerror(errno));
+        return false;
+    }
+    bool ok = gjs_write_heap_snapshot(cx, fp);
+    if (fclose(fp) != 0)
+        ok = false;
+    if (!ok) {
+        gjs_throw(cx, "Failed to write heap snapshot to %s", filename.get());
+        return false;
+    }
+
+    gjs_debug(GJS_DEBUG_CONTEXT, "Heap snapshot written to %s",
+              filename.get());
+
+    args.rval().setUndefined();
+    return true;
+}
+
 static bool
 gjs_gc(JSContext *context,
        unsigned   argc,
@@ -152,6 +189,126 @@ gjs_gc(JSContext *context,
     return true;
 }
 
+// Defines a number property on @obj, converting @name from snake_case to
+// camelCase
+GJS_JSAPI_RETURN_CONVENTION
+static bool define_report_entry(JSContext* cx, JS::HandleObject obj,
+                                const char* name, double value) {
+    std::string js_name;
+    for (const char* c = name; *c; c++) {
+        if (*c == '_' && c[1])
+            js_name += g_ascii_toupper(*++c);
+        else
+            js_name += *c;
+    }
+    return JS_DefineProperty(cx, obj, js_name.c_str(), value, JSPROP_ENUMERATE);
+}
+
+GJS_JSAPI_RETURN_CONVENTION
+static bool gjs_memory_report(JSContext* cx, unsigned argc, JS::Value* vp) {
+    JS::CallArgs args = JS::CallArgsFromVp(argc, vp);
+    if (!gjs_parse_call_args(cx, "memoryReport", args, ""))
+        return false;
+
+    JS::RootedObject report(cx, JS_NewPlainObject(cx));
+    JS::RootedObject counts(cx, JS_NewPlainObject(cx));
+    JS::RootedObject bytes(cx, JS_NewPlainObject(cx));
+    JS::RootedObject js(cx, JS_NewPlainObject(cx));
+    if (!report || !counts || !bytes || !js)
+        return false;
+
+#define GJS_REPORT_COUNTER(name)                                   \
+    if (!define_report_entry(cx, counts, #name,                    \
+                             GJS_GET_COUNTER(name)))               \
+        return false;
+    GJS_FOR_EACH_COUNTER(GJS_REPORT_COUNTER)
+#undef GJS_REPORT_COUNTER
+
+    double total_bytes = 0;
+#define GJS_REPORT_BYTE_COUNTER(name)                                   \
+    total_bytes += GJS_GET_BYTES(name);                                 \
+    if (!define_report_entry(cx, bytes, #name, GJS_GET_BYTES(name)))    \
+        return false;
+    GJS_FOR_EACH_BYTE_COUNTER(GJS_REPORT_BYTE_COUNTER)
+#undef GJS_REPORT_BYTE_COUNTER
+
+    size_t prototype_cache_bytes = ObjectPrototype::all_caches_size() +
+                                   BoxedPrototype::all_field_maps_size();
+    size_t signal_plan_bytes = gjs_signal_marshal_plans_size();
+    size_t static_string_bytes =
+        GjsContextPrivate::from_cx(cx)->static_strings_size();
+    total_bytes +=
+        prototype_cache_bytes + signal_plan_bytes + static_string_bytes;
+    if (!define_report_entry(cx, bytes, "prototype_cache",
+                             prototype_cache_bytes) ||
+        !define_report_entry(cx, bytes, "signal_plan_cache",
+                             signal_plan_bytes) ||
+        !define_report_entry(cx, bytes, "static_string_cache",
+                             static_string_bytes) ||
+        !define_report_entry(cx, bytes, "total", total_bytes))
+        return false;
+
+    // SpiderMonkey's own view of its heap
+    if (!define_report_entry(cx, js, "gc_bytes",
+                             JS_GetGCParameter(cx, JSGC_BYTES)) ||
+        !define_report_entry(cx, js, "gc_max_bytes",
+                             JS_GetGCParameter(cx, JSGC_MAX_BYTES)) ||
+        !define_report_entry(cx, js, "gc_number",
+                             JS_GetGCParameter(cx, JSGC_NUMBER)) ||
+        !define_report_entry(cx, js, "total_chunks",
+                             JS_GetGCParameter(cx, JSGC_TOTAL_CHUNKS)) ||
+        !define_report_entry(cx, js, "unused_chunks",
+                             JS_GetGCParameter(cx, JSGC_UNUSED_CHUNKS)) ||
+        !define_report_entry(cx, js, "weak_wrappers_examined",
+                             ObjectInstance::num_weak_wrappers_examined()))
+        return false;
+
+    if (!JS_DefineProperty(cx, report, "counts", counts, JSPROP_ENUMERATE) ||
+        !JS_DefineProperty(cx, report, "bytes", bytes, JSPROP_ENUMERATE) ||
+        !JS_DefineProperty(cx, report, "js", js, JSPROP_ENUMERATE))
+        return false;
+
+    args.rval().setObject(*report);
+    return true;
+}
+
+GJS_JSAPI_RETURN_CONVENTION
+static bool gjs_release_memory(JSContext* cx, unsigned argc, JS::Value* vp) {
+    JS::CallArgs args = JS::CallArgsFromVp(argc, vp);
+    if (!gjs_parse_call_args(cx, "releaseMemory", args, ""))
+        return false;
+
+    GjsContextPrivate* gjs = GjsContextPrivate::from_cx(cx);
+    args.rval().setNumber(double(gjs->release_memory()));
+    return true;
+}
+
+GJS_JSAPI_RETURN_CONVENTION
+static bool gjs_set_gc_frame_clock(JSContext* cx, unsigned argc,
+                                   JS::Value* vp) {
+    JS::CallArgs args = JS::CallArgsFromVp(argc, vp);
+    JS::RootedObject frame_clock_obj(cx);
+
+    if (!gjs_parse_call_args(cx, "setGCFrameClock", args, "?o", "frameClock",
+                             &frame_clock_obj))
+        return false;
+
+    GObject* frame_clock = nullptr;
+    if (frame_clock_obj &&
+        !ObjectBase::to_c_ptr(cx, frame_clock_obj, &frame_clock))
+        return false;
+
+    GjsContextPrivate* gjs = GjsContextPrivate::from_cx(cx);
+    if (!gjs->set_gc_frame_clock(frame_clock)) {
+        gjs_throw(cx, "Object of type %s has no after-paint signal",
+                  G_OBJECT_TYPE_NAME(frame_clock));
+        return false;
+    }
+
+    args.rval().setUndefined();
+    return true;
+}
+
 static bool
 gjs_exit(JSContext *context,
          unsigned   argc,
@@ -187,7 +344,12 @@ static JSFunctionSpec module_funcs[] = {
     JS_FN("refcount", gjs_refcount, 1, GJS_MODULE_PROP_FLAGS),
     JS_FN("breakpoint", gjs_breakpoint, 0, GJS_MODULE_PROP_FLAGS),
     JS_FN("dumpHeap", gjs_dump_heap, 1, GJS_MODULE_PROP_FLAGS),
+    JS_FN("dumpHeapSnapshot", gjs_dump_heap_snapshot, 1,
+          GJS_MODULE_PROP_FLAGS),
     JS_FN("gc", gjs_gc, 0, GJS_MODULE_PROP_FLAGS),
+    JS_FN("memoryReport", gjs_memory_report, 0, GJS_MODULE_PROP_FLAGS),
+    JS_FN("releaseMemory", gjs_release_memory, 0, GJS_MODULE_PROP_FLAGS),
+    JS_FN("setGCFrameClock", gjs_set_gc_frame_clock, 1, GJS_MODULE_PROP_FLAGS),
     JS_FN("exit", gjs_exit, 0, GJS_MODULE_PROP_FLAGS),
     JS_FN("clearDateCaches", gjs_clear_date_caches, 0, GJS_MODULE_PROP_FLAGS),
     JS_FS_END};
@@ -0,0 +1,108 @@
+// SPDX-License-Identifier: MIT OR LGPL-2.0-or-later
+// SPDX-FileCopyrightText: 2020 GNOME Foundation
+
+#include <config.h>
+
+#include <stddef.h>  // for size_t
+#include <string.h>  // for strlen
+
+#include <gio/gio.h>
+#include <glib.h>
+
+#include <js/BuildId.h>
+#include <js/CompileOptions.h>
+#include <js/RootingAPI.h>
+#include <js/TypeDecls.h>
+#include <jsapi.h>  // for JS_IsExceptionPending
+
+#include "gjs/bytecode-cache.h"
+#include "gjs/context-private.h"
+#include "gjs/jsapi-util.h"
+#include "test/gjs-test-utils.h"
+
+static const char MODULE_PATH[] = "modules/script/lang.js";
+
+using AutoBytes = GjsAutoPointer<GBytes, GBytes, g_bytes_unref>;
+
+[[nodiscard]] static GBytes* lookup_builtin_module(const char* prefix) {
+    GjsAutoChar path = g_strconcat(prefix, MODULE_PATH, nullptr);
+    return g_resources_lookup_data(path, G_RESOURCE_LOOKUP_FLAGS_NONE,
+                                   nullptr);
+}
+
+// Skips the test if GJS was built without precompiled bytecode
+[[nodiscard]] static GBytes* lookup_precompiled_module(void) {
+    GBytes* retval = lookup_builtin_module("/org/gnome/gjs/bytecode/");
+    if (!retval)
+        g_test_skip("Built without precompiled bytecode");
+    return retval;
+}
+
+static void set_options(JS::CompileOptions* options) {
+    GjsAutoChar uri =
+        g_strconcat("resource:///org/gnome/gjs/", MODULE_PATH, nullptr);
+    options->setFileAndLine(uri, 1).setNonSyntacticScope(true);
+}
+
+static void test_bytecode_cache_load_precompiled(GjsUnitTestFixture* fx,
+                                                 const void*) {
+    AutoBytes bytecode = lookup_precompiled_module();
+    if (!bytecode)
+        return;
+
+    GjsBytecodeCache& cache =
+        GjsContextPrivate::from_cx(fx->cx)->bytecode_cache();
+    JS::CompileOptions options(fx->cx);
+    set_options(&options);
+    JS::RootedScript script(fx->cx);
+    g_assert_true(cache.load_precompiled(fx->cx, options, &script));
+    g_assert_nonnull(script);
+}
+
+[[nodiscard]] static bool get_other_build_id(JS::BuildIdCharVector* build_id) {
+    static const char BUILD_ID[] = "some other engine";
+    return build_id->append(BUILD_ID, strlen(BUILD_ID));
+}
+
+static void test_bytecode_cache_bad_build_id(GjsUnitTestFixture* fx,
+                                             const void*) {
+    AutoBytes bytecode = lookup_precompiled_module();
+    if (!bytecode)
+        return;
+    AutoBytes source = lookup_builtin_module("/org/gnome/gjs/");
+    g_assert_nonnull(source);
+
+    GjsBytecodeCache& cache =
+        GjsContextPrivate::from_cx(fx->cx)->bytecode_cache();
+    JS::CompileOptions options(fx->cx);
+    set_options(&options);
+    JS::RootedScript script(fx->cx);
+
+    JS::SetProcessBuildIdOp(get_other_build_id);
+    g_assert_false(cache.load_precompiled(fx->cx, options, &script));
+    g_assert_false(JS_IsExceptionPending(fx->cx));
+    JS::SetProcessBuildIdOp(GjsBytecodeCache::get_build_id);
+
+    // The other built-in modules were built by the same engine, so the
+    // bytecode isn't tried again
+    g_assert_false(cache.load_precompiled(fx->cx, options, &script));
+
+    size_t len;
+    const void* data = g_bytes_get_data(source, &len);
+    script = cache.compile(fx->cx, options, nullptr,
+                           static_cast<const char*>(data), len);
+    g_assert_nonnull(script);
+}
+
+void gjs_test_add_tests_for_bytecode_cache() {
+#define ADD_BYTECODE_CACHE_TEST(path, func)                                    \
+    g_test_add("/gjs/bytecode-cache/" path, GjsUnitTestFixture, nullptr,       \
+               gjs_unit_test_fixture_setup, func,                              \
+               gjs_unit_test_fixture_teardown)
+
+    ADD_BYTECODE_CACHE_TEST("load-precompiled",
+                            test_bytecode_cache_load_precompiled);
+    ADD_BYTECODE_CACHE_TEST("bad-build-id", test_bytecode_cache_bad_build_id);
+
+#undef ADD_BYTECODE_CACHE_TEST
+}
@@ -0,0 +1,147 @@
+// SPDX-License-Identifier: MIT OR LGPL-2.0-or-later
+// SPDX-FileCopyrightText: 2020 GNOME Foundation
+
+#include <config.h>
+
+#include <stddef.h>  // for size_t
+#include <stdlib.h>  // for free, malloc
+
+#include <atomic>
+#include <new>
+
+#include <girepository.h>
+#include <glib.h>
+
+#include "gi/arg-inl.h"
+#include "gi/function.h"
+#include "gjs/jsapi-util.h"
+#include "test/gjs-test-utils.h"
+
+// COMPAT: https://gitlab.gnome.org/GNOME/glib/-/merge_requests/1553
+#ifdef __clang_analyzer__
+void g_assertion_message(const char*, const char*, int, const char*,
+                         const char*) __attribute__((analyzer_noreturn));
+#endif
+
+// Count every C++ heap allocation made while the flag is set, so that we can
+// check that the call state of an introspected function does not allocate.
+static std::atomic_bool counting_allocations(false);
+static std::atomic_size_t allocation_count(0);
+
+void* operator new(size_t size) {
+    if (counting_allocations)
+        allocation_count++;
+    void* retval = malloc(size);
+    if (!retval)
+        throw std::bad_alloc();
+    return retval;
+}
+
+void operator delete(void* ptr) noexcept { free(ptr); }
+
+class AutoCountAllocations {
+ public:
+    AutoCountAllocations() {
+        allocation_count = 0;
+        counting_allocations = true;
+    }
+    ~AutoCountAllocations() { counting_allocations = false; }
+    size_t count() const { return allocation_count; }
+};
+
+[[nodiscard]] static GICallableInfo* get_glib_function(const char* name) {
+    GError* error = nullptr;
+    if (!g_irepository_require(nullptr, "GLib", "2.0",
+                               GIRepositoryLoadFlags(0), &error))
+        g_error("Failed to load GLib typelib: %s", error->message);
+
+    GIBaseInfo* info = g_irepository_find_by_name(nullptr, "GLib", name);
+    g_assert_nonnull(info);
+    g_assert_true(GI_IS_CALLABLE_INFO(info));
+    return info;
+}
+
+static void fill_call_state(GjsFunctionCallState* state) {
+    // Touch every slot, including the return value and instance parameter,
+    // as gjs_invoke_c_function() would
+    for (int ix = -state->first_arg_offset(); ix < state->gi_argc; ix++) {
+        gjs_arg_set(&state->in_cvalues[ix], ix);
+        gjs_arg_set(&state->out_cvalues[ix], ix);
+        gjs_arg_set(&state->inout_original_cvalues[ix], ix);
+        state->ffi_arg_pointers[ix + state->first_arg_offset()] =
+            &state->in_cvalues[ix];
+    }
+    if (state->gi_argc > 0)
+        state->ignore_release.set(state->gi_argc - 1);
+}
+
+static void test_call_state_inline_no_allocation(GjsUnitTestFixture* fx,
+                                                 const void*) {
+    GjsAutoCallableInfo info = get_glib_function("strcmp0");
+    int n_args = g_callable_info_get_n_args(info);
+    g_assert_cmpint(n_args, <=, GjsFunctionCallState::MAX_INLINE_ARGS);
+
+    AutoCountAllocations counter;
+    for (size_t i = 0; i < 1000; i++) {
+        GjsFunctionCallState state(fx->cx, info, n_args);
+        g_assert_true(state.uses_inline_storage());
+        fill_call_state(&state);
+    }
+    g_assert_cmpuint(counter.count(), ==, 0);
+}
+
+static void test_call_state_heap_fallback(GjsUnitTestFixture* fx,
+                                          const void*) {
+    GjsAutoCallableInfo info = get_glib_function("spawn_async_with_pipes");
+    int n_args = g_callable_info_get_n_args(info);
+    g_assert_cmpint(n_args, >, GjsFunctionCallState::MAX_INLINE_ARGS);
+
+    GjsFunctionCallState state(fx->cx, info, n_args);
+    g_assert_false(state.uses_inline_storage());
+    fill_call_state(&state);
+
+    for (int ix = -state.first_arg_offset(); ix < state.gi_argc; ix++) {
+        g_assert_cmpint(gjs_arg_get<int>(&state.in_cvalues[ix]), ==, ix);
+        g_assert_cmpint(gjs_arg_get<int>(&state.out_cvalues[ix]), ==, ix);
+        g_assert_cmpint(gjs_arg_get<int>(&state.inout_original_cvalues[ix]),
+                        ==, ix);
+    }
+}
+
+static void test_call_state_benchmark(GjsUnitTestFixture* fx, const void*) {
+    if (!g_test_perf()) {
+        g_test_skip("Run with -m perf to run the benchmark");
+        return;
+    }
+
+    GjsAutoCallableInfo info = get_glib_function("strcmp0");
+    int n_args = g_callable_info_get_n_args(info);
+    constexpr size_t n_iterations = 10'000'000;
+
+    AutoCountAllocations counter;
+    g_test_timer_start();
+    for (size_t i = 0; i < n_iterations; i++) {
+        GjsFunctionCallState state(fx->cx, info, n_args);
+        fill_call_state(&state);
+    }
+    double ns_per_call = g_test_timer_elapsed() * 1e9 / n_iterations;
+
+    g_test_minimized_result(ns_per_call, "%.1f ns per call state", ns_per_call);
+    g_test_message("%zu allocations in %zu call states", counter.count(),
+                   n_iterations);
+    g_assert_cmpuint(counter.count(), ==, 0);
+}
+
+void gjs_test_add_tests_for_call_state() {
+#define ADD_CALL_STATE_TEST(path, f)                                  \
+    g_test_add("/gi/function/call-state/" path, GjsUnitTestFixture, \
+               nullptr, gjs_unit_test_fixture_setup, f,             \
+               gjs_unit_test_fixture_teardown)
+
+    ADD_CALL_STATE_TEST("inline-no-allocation",
+                        test_call_state_inline_no_allocation);
+    ADD_CALL_STATE_TEST("heap-fallback", test_call_state_heap_fallback);
+    ADD_CALL_STATE_TEST("benchmark", test_call_state_benchmark);
+
+#undef ADD_CALL_STATE_TEST
+}
@@ -0,0 +1,157 @@
+// SPDX-License-Identifier: MIT OR LGPL-2.0-or-later
+// SPDX-FileCopyrightText: 2020 GNOME Foundation
+
+#include <config.h>
+
+#include <stdint.h>
+
+#include <glib-object.h>
+#include <glib.h>
+
+#include <js/GCAPI.h>
+#include <js/TypeDecls.h>
+
+#include "gjs/context-private.h"
+#include "gjs/context.h"
+#include "test/gjs-test-utils.h"
+
+// Stands in for a GdkFrameClock or a ClutterStage
+struct _GjsTestFrameClock {
+    GObject parent_instance;
+};
+
+G_DECLARE_FINAL_TYPE(GjsTestFrameClock, gjs_test_frame_clock, GJS_TEST,
+                     FRAME_CLOCK, GObject)
+G_DEFINE_TYPE(GjsTestFrameClock, gjs_test_frame_clock, G_TYPE_OBJECT)
+
+static void gjs_test_frame_clock_init(GjsTestFrameClock*) {}
+
+static void gjs_test_frame_clock_class_init(GjsTestFrameClockClass* klass) {
+    g_signal_new("after-paint", G_TYPE_FROM_CLASS(klass), G_SIGNAL_RUN_LAST, 0,
+                 nullptr, nullptr, nullptr, G_TYPE_NONE, 0);
+}
+
+// Enough live objects that marking them takes many 1 ms slices
+static const char FILL_HEAP_SCRIPT[] =
+    "var objects = Array.from({length: 1000000}, (_, ix) => ({ix}));";
+
+static unsigned n_slices;
+static JS::GCSliceCallback previous_slice_callback;
+
+static void count_slice(JSContext* cx, JS::GCProgress progress,
+                        const JS::GCDescription& desc) {
+    if (progress == JS::GC_SLICE_BEGIN)
+        n_slices++;
+    if (previous_slice_callback)
+        previous_slice_callback(cx, progress, desc);
+}
+
+struct FrameClockFixture {
+    GjsContext* gjs_context;
+    JSContext* cx;
+    GjsTestFrameClock* frame_clock;
+};
+
+static void frame_clock_fixture_setup(FrameClockFixture* fx, const void*) {
+    g_unsetenv("GJS_GC_SLICE_BUDGET");
+    fx->gjs_context = GJS_CONTEXT(
+        g_object_new(GJS_TYPE_CONTEXT, "gc-slice-budget", 1, nullptr));
+    fx->cx = static_cast<JSContext*>(
+        gjs_context_get_native_context(fx->gjs_context));
+
+    GError* error = nullptr;
+    int status;
+    bool ok = gjs_context_eval(fx->gjs_context, FILL_HEAP_SCRIPT, -1,
+                               "<input>", &status, &error);
+    g_assert_no_error(error);
+    g_assert_true(ok);
+
+    fx->frame_clock = GJS_TEST_FRAME_CLOCK(
+        g_object_new(gjs_test_frame_clock_get_type(), nullptr));
+    g_assert_true(GjsContextPrivate::from_cx(fx->cx)->set_gc_frame_clock(
+        G_OBJECT(fx->frame_clock)));
+
+    n_slices = 0;
+    previous_slice_callback = JS::SetGCSliceCallback(fx->cx, count_slice);
+}
+
+static void frame_clock_fixture_teardown(FrameClockFixture* fx, const void*) {
+    JS::SetGCSliceCallback(fx->cx, previous_slice_callback);
+    if (JS::IsIncrementalGCInProgress(fx->cx))
+        JS::FinishIncrementalGC(fx->cx, JS::GCReason::API);
+
+    g_assert_true(
+        GjsContextPrivate::from_cx(fx->cx)->set_gc_frame_clock(nullptr));
+    g_object_unref(fx->frame_clock);
+    g_object_unref(fx->gjs_context);
+}
+
+// Runs the first slice of a collection, as the GC policy would
+static void start_collection(FrameClockFixture* fx) {
+    JS::PrepareForFullGC(fx->cx);
+    JS::StartIncrementalGC(fx->cx, GC_NORMAL, JS::GCReason::API, 1);
+    g_assert_true(JS::IsIncrementalGCInProgress(fx->cx));
+    g_assert_cmpuint(n_slices, ==, 1);
+}
+
+static void paint(FrameClockFixture* fx) {
+    g_signal_emit_by_name(fx->frame_clock, "after-paint");
+}
+
+static gboolean set_flag(void* data) {
+    *static_cast<bool*>(data) = true;
+    return G_SOURCE_REMOVE;
+}
+
+static void test_gc_frame_clock_slice_on_paint(FrameClockFixture* fx,
+                                               const void*) {
+    start_collection(fx);
+
+    paint(fx);
+    g_assert_cmpuint(n_slices, ==, 2);
+    g_assert_true(JS::IsIncrementalGCInProgress(fx->cx));
+    paint(fx);
+    g_assert_cmpuint(n_slices, ==, 3);
+}
+
+static void test_gc_frame_clock_no_collection(FrameClockFixture* fx,
+                                              const void*) {
+    // Painting doesn't start a collection
+    paint(fx);
+    g_assert_cmpuint(n_slices, ==, 0);
+    g_assert_false(JS::IsIncrementalGCInProgress(fx->cx));
+}
+
+static void test_gc_frame_clock_fallback(FrameClockFixture* fx, const void*) {
+    start_collection(fx);
+    paint(fx);
+    g_assert_true(JS::IsIncrementalGCInProgress(fx->cx));
+    g_assert_cmpuint(n_slices, ==, 2);
+
+    // The next slice waits for the next frame, rather than for idle time
+    bool waited = false;
+    g_timeout_add(50, set_flag, &waited);
+    while (!waited)
+        g_main_context_iteration(nullptr, true);
+    g_assert_cmpuint(n_slices, ==, 2);
+
+    // ...but not for long, if no frame is painted
+    int64_t deadline = g_get_monotonic_time() + 10 * G_USEC_PER_SEC;
+    while (n_slices == 2) {
+        g_assert_cmpint(g_get_monotonic_time(), <, deadline);
+        g_main_context_iteration(nullptr, true);
+    }
+}
+
+void gjs_test_add_tests_for_gc_frame_clock() {
+#define ADD_GC_FRAME_CLOCK_TEST(path, func)                                  \
+    g_test_add("/gjs/gc-frame-clock/" path, FrameClockFixture, nullptr,      \
+               frame_clock_fixture_setup, func, frame_clock_fixture_teardown)
+
+    ADD_GC_FRAME_CLOCK_TEST("slice-on-paint",
+                            test_gc_frame_clock_slice_on_paint);
+    ADD_GC_FRAME_CLOCK_TEST("no-collection", test_gc_frame_clock_no_collection);
+    ADD_GC_FRAME_CLOCK_TEST("fallback", test_gc_frame_clock_fallback);
+
+#undef ADD_GC_FRAME_CLOCK_TEST
+}
@@ -0,0 +1,270 @@
+// SPDX-License-Identifier: MIT OR LGPL-2.0-or-later
+// SPDX-FileCopyrightText: 2020 GNOME Foundation
+
+#include <config.h>
+
+#include <stdint.h>
+
+#include <glib.h>
+
+#include "gjs/gc-policy.h"
+#include "test/gjs-test-utils.h"
+
+using Decision = GjsGCPolicy::Decision;
+
+static constexpr uint64_t MiB = 1024 * 1024;
+
+#define assert_decision(a, b)                                    \
+    g_assert_cmpstr(GjsGCPolicy::decision_name(a), ==,           \
+                    GjsGCPolicy::decision_name(b))
+
+static const char* const ENV_VARS[] = {
+    "GJS_GC_CHECK_INTERVAL",
+    "GJS_GC_SLICE_BUDGET",
+    "GJS_GC_TOGGLE_THRESHOLD",
+    "GJS_GC_INCREMENTAL_THRESHOLD",
+};
+
+// Drives a policy with made-up heap sizes, RSS, and times; every check is one
+// second after the previous one
+struct PolicyTest {
+    GjsGCPolicy policy;
+    int64_t now = g_get_monotonic_time();
+    uint64_t heap_bytes = 1 * MiB;
+    uint64_t rss = 100 * MiB;
+
+    explicit PolicyTest(const GjsGCPolicy::Config& config) {
+        policy.configure(config);
+
+        // The first check always collects, to find out the baseline RSS
+        g_assert_true(decide() != Decision::NONE);
+        collect(0);
+    }
+
+    Decision decide(bool main_loop_idle = true,
+                    bool collection_in_progress = false) {
+        now += G_USEC_PER_SEC;
+        return policy.decide({collection_in_progress, heap_bytes, rss, now},
+                             main_loop_idle);
+    }
+
+    void toggle_down(unsigned n_wrappers) {
+        for (unsigned ix = 0; ix < n_wrappers; ix++)
+            policy.note_wrapper_toggled_down();
+    }
+
+    void collect(size_t wrappers_collected) {
+        policy.note_collection_started();
+        policy.note_collection_finished(wrappers_collected);
+    }
+};
+
+static void clear_env(void) {
+    for (const char* name : ENV_VARS)
+        g_unsetenv(name);
+}
+
+static void test_gc_policy_config(void) {
+    clear_env();
+
+    GjsGCPolicy defaults;
+    defaults.configure({});
+    g_assert_cmpuint(defaults.check_interval_ms(), ==, 10'000);
+    g_assert_cmpuint(defaults.slice_budget_ms(), ==, 10);
+
+    // Non-zero values from construct properties override the defaults
+    GjsGCPolicy configured;
+    configured.configure({500, 5, 0, 0});
+    g_assert_cmpuint(configured.check_interval_ms(), ==, 500);
+    g_assert_cmpuint(configured.slice_budget_ms(), ==, 5);
+
+    // The environment overrides construct properties, but can't set zero
+    g_setenv("GJS_GC_CHECK_INTERVAL", "250", true);
+    g_setenv("GJS_GC_SLICE_BUDGET", "0", true);
+    GjsGCPolicy from_env;
+    from_env.configure({500, 5, 0, 0});
+    g_assert_cmpuint(from_env.check_interval_ms(), ==, 250);
+    g_assert_cmpuint(from_env.slice_budget_ms(), ==, 1);
+
+    clear_env();
+}
+
+static void test_gc_policy_toggle_threshold(void) {
+    clear_env();
+    PolicyTest test({0, 0, 10, 0});
+
+    test.toggle_down(9);
+    assert_decision(test.decide(), Decision::NONE);
+
+    // The tenth one crosses the threshold, and isn't coming in faster than the
+    // ones before
+    test.toggle_down(1);
+    assert_decision(test.decide(), Decision::FULL);
+    test.collect(10);
+
+    g_assert_false(test.policy.has_toggled_down_wrappers());
+    assert_decision(test.decide(), Decision::NONE);
+}
+
+static void test_gc_policy_toggle_threshold_from_env(void) {
+    clear_env();
+    g_setenv("GJS_GC_TOGGLE_THRESHOLD", "3", true);
+    PolicyTest test({0, 0, 10, 0});
+    clear_env();
+
+    test.toggle_down(2);
+    assert_decision(test.decide(), Decision::NONE);
+    test.toggle_down(1);
+    assert_decision(test.decide(), Decision::FULL);
+}
+
+static void test_gc_policy_minor_when_heap_grows(void) {
+    clear_env();
+    PolicyTest test({});
+
+    assert_decision(test.decide(), Decision::NONE);
+    test.heap_bytes += MiB;
+    assert_decision(test.decide(), Decision::MINOR);
+    assert_decision(test.decide(), Decision::NONE);
+}
+
+static void test_gc_policy_rss_trigger(void) {
+    clear_env();
+    PolicyTest test({});
+
+    // Growing less than a quarter since the last collection is fine
+    test.rss = 120 * MiB;
+    assert_decision(test.decide(), Decision::NONE);
+    test.rss = 130 * MiB;
+    assert_decision(test.decide(), Decision::FULL);
+    test.collect(0);
+    assert_decision(test.decide(), Decision::NONE);
+
+    // After something else releases a lot of memory, the trigger is lowered
+    test.rss = 60 * MiB;
+    assert_decision(test.decide(), Decision::NONE);
+    test.rss = 80 * MiB;
+    assert_decision(test.decide(), Decision::FULL);
+}
+
+static void test_gc_policy_incremental_threshold(void) {
+    clear_env();
+    PolicyTest test({0, 0, 0, 32});
+
+    test.heap_bytes = 16 * MiB;
+    test.rss *= 2;
+    assert_decision(test.decide(), Decision::FULL);
+
+    // Large heaps are collected incrementally even when idle
+    test.heap_bytes = 64 * MiB;
+    test.rss *= 2;
+    assert_decision(test.decide(), Decision::INCREMENTAL_SLICE);
+
+    // Small heaps too, if the main loop has other things to do
+    test.heap_bytes = 16 * MiB;
+    test.rss *= 2;
+    assert_decision(test.decide(/* main_loop_idle = */ false),
+                    Decision::INCREMENTAL_SLICE);
+
+    // An incremental collection is continued no matter what
+    assert_decision(test.decide(true, /* collection_in_progress = */ true),
+                    Decision::INCREMENTAL_SLICE);
+}
+
+static void test_gc_policy_incremental_threshold_from_env(void) {
+    clear_env();
+    g_setenv("GJS_GC_INCREMENTAL_THRESHOLD", "128", true);
+    PolicyTest test({0, 0, 0, 32});
+    clear_env();
+
+    test.heap_bytes = 64 * MiB;
+    test.rss *= 2;
+    assert_decision(test.decide(), Decision::FULL);
+}
+
+static void test_gc_policy_batches(void) {
+    clear_env();
+    PolicyTest test({});
+
+    // Only the first toggle-down of a batch asks for a check
+    g_assert_true(test.policy.note_wrapper_toggled_down());
+    g_assert_false(test.policy.note_wrapper_toggled_down());
+    assert_decision(test.decide(), Decision::NONE);
+    g_assert_true(test.policy.note_wrapper_toggled_down());
+
+    // Also when the check finds a collection that SpiderMonkey started
+    test.policy.note_collection_started();
+    assert_decision(test.decide(true, /* collection_in_progress = */ true),
+                    Decision::INCREMENTAL_SLICE);
+    test.policy.note_collection_finished(3);
+    g_assert_false(test.policy.has_toggled_down_wrappers());
+    g_assert_true(test.policy.note_wrapper_toggled_down());
+}
+
+static void test_gc_policy_defers_while_accelerating(void) {
+    clear_env();
+    PolicyTest test({0, 0, 10, 0});
+
+    // More toggle-downs than the last batch: wait for the rest
+    test.toggle_down(20);
+    assert_decision(test.decide(), Decision::NONE);
+
+    // But only once
+    test.toggle_down(40);
+    assert_decision(test.decide(), Decision::FULL);
+    test.collect(60);
+    assert_decision(test.decide(), Decision::NONE);
+}
+
+static void test_gc_policy_reclaim_ratio(void) {
+    clear_env();
+    PolicyTest test({0, 0, 10, 0});
+
+    test.toggle_down(10);
+    assert_decision(test.decide(), Decision::NONE);  // deferred
+    assert_decision(test.decide(), Decision::FULL);
+    // None of the toggled-down wrappers were garbage
+    test.collect(0);
+
+    // So only half of them are expected to be collectable now
+    test.toggle_down(10);
+    g_assert_cmpuint(test.policy.estimated_collectable_wrappers(), ==, 5);
+    assert_decision(test.decide(), Decision::NONE);
+    test.toggle_down(10);
+    assert_decision(test.decide(), Decision::NONE);  // deferred
+    assert_decision(test.decide(), Decision::FULL);
+}
+
+static void test_gc_policy_stale_toggle_downs(void) {
+    clear_env();
+    PolicyTest test({1000, 0, 0, 0});
+
+    // Below the threshold, but collected after six check intervals anyway
+    test.toggle_down(1);
+    for (unsigned ix = 0; ix < 3; ix++)
+        assert_decision(test.decide(), Decision::NONE);
+    test.now += 2 * G_USEC_PER_SEC;
+    assert_decision(test.decide(), Decision::FULL);
+}
+
+void gjs_test_add_tests_for_gc_policy() {
+    g_test_add_func("/gjs/gc-policy/config", test_gc_policy_config);
+    g_test_add_func("/gjs/gc-policy/toggle-threshold",
+                    test_gc_policy_toggle_threshold);
+    g_test_add_func("/gjs/gc-policy/toggle-threshold-from-env",
+                    test_gc_policy_toggle_threshold_from_env);
+    g_test_add_func("/gjs/gc-policy/minor-when-heap-grows",
+                    test_gc_policy_minor_when_heap_grows);
+    g_test_add_func("/gjs/gc-policy/rss-trigger", test_gc_policy_rss_trigger);
+    g_test_add_func("/gjs/gc-policy/incremental-threshold",
+                    test_gc_policy_incremental_threshold);
+    g_test_add_func("/gjs/gc-policy/incremental-threshold-from-env",
+                    test_gc_policy_incremental_threshold_from_env);
+    g_test_add_func("/gjs/gc-policy/batches", test_gc_policy_batches);
+    g_test_add_func("/gjs/gc-policy/defers-while-accelerating",
+                    test_gc_policy_defers_while_accelerating);
+    g_test_add_func("/gjs/gc-policy/reclaim-ratio",
+                    test_gc_policy_reclaim_ratio);
+    g_test_add_func("/gjs/gc-policy/stale-toggle-downs",
+                    test_gc_policy_stale_toggle_downs);
+}
@@ -0,0 +1,224 @@
+// SPDX-License-Identifier: MIT OR LGPL-2.0-or-later
+// SPDX-FileCopyrightText: 2020 GNOME Foundation
+
+#include <config.h>
+
+#include <stdint.h>
+
+#include <string>
+
+#include <gio/gio.h>
+#include <glib.h>
+#include <glib/gstdio.h>  // for g_mkdir, g_unlink, g_rmdir
+
+#include <jsapi.h>  // for JS_IsExceptionPending
+
+#include "gjs/context-private.h"
+#include "gjs/context.h"
+#include "gjs/import-path-cache.h"
+#include "gjs/jsapi-util.h"
+#include "test/gjs-test-utils.h"
+
+// These have no overrides in GJS itself, and aren't imported by GJS's own
+// modules
+static const char NAMESPACE[] = "GModule";
+static const char OTHER_NAMESPACE[] = "GIRepository";
+
+struct PathCacheFixture {
+    char* dir;
+};
+
+static void path_cache_fixture_setup(PathCacheFixture* fx, const void*) {
+    fx->dir = g_dir_make_tmp("gjs-test-XXXXXX", nullptr);
+    g_assert_nonnull(fx->dir);
+}
+
+static void remove_tree(const char* path) {
+    if (GDir* dir = g_dir_open(path, 0, nullptr)) {
+        while (const char* name = g_dir_read_name(dir)) {
+            GjsAutoChar child = g_build_filename(path, name, nullptr);
+            remove_tree(child);
+        }
+        g_dir_close(dir);
+        g_rmdir(path);
+        return;
+    }
+    g_unlink(path);
+}
+
+static void path_cache_fixture_teardown(PathCacheFixture* fx, const void*) {
+    remove_tree(fx->dir);
+    g_free(fx->dir);
+}
+
+static void write_file(PathCacheFixture* fx, const char* name,
+                       const char* contents) {
+    GjsAutoChar path = g_build_filename(fx->dir, name, nullptr);
+    GError* error = nullptr;
+    g_assert_true(g_file_set_contents(path, contents, -1, &error));
+    g_assert_no_error(error);
+}
+
+static void make_dir(PathCacheFixture* fx, const char* name) {
+    GjsAutoChar path = g_build_filename(fx->dir, name, nullptr);
+    g_assert_cmpint(g_mkdir(path, 0755), ==, 0);
+}
+
+// Runs the main loop until @cache finds @name in the fixture's directory
+static void wait_until_exists(PathCacheFixture* fx, GjsImportPathCache* cache,
+                              const char* name) {
+    int64_t deadline = g_get_monotonic_time() + 10 * G_USEC_PER_SEC;
+    while (!cache->exists(fx->dir, name)) {
+        g_assert_cmpint(g_get_monotonic_time(), <, deadline);
+        while (g_main_context_iteration(nullptr, false)) {
+        }
+        g_usleep(G_USEC_PER_SEC / 100);
+    }
+}
+
+static void test_import_path_cache_enumerate(PathCacheFixture* fx,
+                                             const void*) {
+    write_file(fx, "module.js", "");
+    make_dir(fx, "subdir");
+
+    GjsImportPathCache cache;
+    cache.enumerate(fx->dir);
+    g_assert_cmpuint(cache.misses(), ==, 1);
+
+    g_assert_cmpint(cache.query_file_type(fx->dir, "module.js"), ==,
+                    G_FILE_TYPE_REGULAR);
+    g_assert_cmpint(cache.query_file_type(fx->dir, "subdir"), ==,
+                    G_FILE_TYPE_DIRECTORY);
+    g_assert_false(cache.exists(fx->dir, "missing.js"));
+
+    // All answered from the listing, including the name that isn't there
+    g_assert_cmpuint(cache.misses(), ==, 1);
+    g_assert_cmpuint(cache.hits(), ==, 3);
+
+    // Listed only once
+    cache.enumerate(fx->dir);
+    g_assert_cmpuint(cache.misses(), ==, 1);
+}
+
+static void test_import_path_cache_enumerate_missing_dir(PathCacheFixture* fx,
+                                                         const void*) {
+    GjsAutoChar missing = g_build_filename(fx->dir, "missing", nullptr);
+
+    GjsImportPathCache cache;
+    cache.enumerate(missing);
+    g_assert_false(cache.exists(missing, "module.js"));
+    g_assert_cmpuint(cache.misses(), ==, 1);
+}
+
+static void test_import_path_cache_enumerate_new_file(PathCacheFixture* fx,
+                                                      const void*) {
+    GjsImportPathCache cache;
+    cache.enumerate(fx->dir);
+    g_assert_false(cache.exists(fx->dir, "module.js"));
+
+    // Found once the directory's monitor has seen it appear
+    write_file(fx, "module.js", "");
+    wait_until_exists(fx, &cache, "module.js");
+}
+
+// Imports @ns_name with the fixture's directory as the only overrides
+// directory, and returns the value that its override stored in it, or 0
+static int import_namespace(PathCacheFixture* fx, GjsContext* gjs_context,
+                            const char* ns_name = NAMESPACE) {
+    std::string script = "imports.overrides.searchPath = ['";
+    script += fx->dir;
+    script += "'];\n(imports.gi.";
+    script += ns_name;
+    script += ".overridden || 0);";
+
+    GError* error = nullptr;
+    int status;
+    bool ok = gjs_context_eval(gjs_context, script.c_str(), -1, "<input>",
+                               &status, &error);
+    g_assert_no_error(error);
+    g_assert_true(ok);
+
+    auto* cx =
+        static_cast<JSContext*>(gjs_context_get_native_context(gjs_context));
+    g_assert_false(JS_IsExceptionPending(cx));
+    return status;
+}
+
+static const char OVERRIDE_SCRIPT[] =
+    "var _init = function () { this.overridden = 42; };";
+
+static void test_import_path_cache_no_override(PathCacheFixture* fx,
+                                               const void*) {
+    write_file(fx, "OtherNamespace.js", OVERRIDE_SCRIPT);
+
+    GjsAutoUnref<GjsContext> gjs_context = gjs_context_new();
+    g_assert_cmpint(import_namespace(fx, gjs_context), ==, 0);
+
+    // The directory was listed instead of looked up name by name
+    auto* cx =
+        static_cast<JSContext*>(gjs_context_get_native_context(gjs_context));
+    GjsImportPathCache& cache =
+        GjsContextPrivate::from_cx(cx)->import_path_cache();
+    unsigned misses = cache.misses();
+    g_assert_true(cache.exists(fx->dir, "OtherNamespace.js"));
+    g_assert_cmpuint(cache.misses(), ==, misses);
+}
+
+static void test_import_path_cache_override_module(PathCacheFixture* fx,
+                                                   const void*) {
+    GjsAutoChar filename = g_strconcat(NAMESPACE, ".js", nullptr);
+    write_file(fx, filename, OVERRIDE_SCRIPT);
+
+    GjsAutoUnref<GjsContext> gjs_context = gjs_context_new();
+    g_assert_cmpint(import_namespace(fx, gjs_context), ==, 42);
+}
+
+static void test_import_path_cache_override_directory(PathCacheFixture* fx,
+                                                      const void*) {
+    make_dir(fx, NAMESPACE);
+    GjsAutoChar init_path = g_build_filename(NAMESPACE, "__init__.js", nullptr);
+    write_file(fx, init_path, OVERRIDE_SCRIPT);
+
+    GjsAutoUnref<GjsContext> gjs_context = gjs_context_new();
+    g_assert_cmpint(import_namespace(fx, gjs_context), ==, 42);
+}
+
+static void test_import_path_cache_override_created(PathCacheFixture* fx,
+                                                    const void*) {
+    // Lists the directory while it has no override
+    GjsAutoUnref<GjsContext> gjs_context = gjs_context_new();
+    g_assert_cmpint(import_namespace(fx, gjs_context), ==, 0);
+
+    // The listing is dropped once the directory's monitor has seen the new
+    // override appear
+    GjsAutoChar filename = g_strconcat(OTHER_NAMESPACE, ".js", nullptr);
+    write_file(fx, filename, OVERRIDE_SCRIPT);
+    auto* cx =
+        static_cast<JSContext*>(gjs_context_get_native_context(gjs_context));
+    wait_until_exists(fx, &GjsContextPrivate::from_cx(cx)->import_path_cache(),
+                      filename);
+
+    g_assert_cmpint(import_namespace(fx, gjs_context, OTHER_NAMESPACE), ==, 42);
+}
+
+void gjs_test_add_tests_for_import_path_cache() {
+#define ADD_IMPORT_PATH_CACHE_TEST(path, func)                             \
+    g_test_add("/gjs/import-path-cache/" path, PathCacheFixture, nullptr, \
+               path_cache_fixture_setup, func, path_cache_fixture_teardown)
+
+    ADD_IMPORT_PATH_CACHE_TEST("enumerate", test_import_path_cache_enumerate);
+    ADD_IMPORT_PATH_CACHE_TEST("enumerate-missing-dir",
+                               test_import_path_cache_enumerate_missing_dir);
+    ADD_IMPORT_PATH_CACHE_TEST("enumerate-new-file",
+                               test_import_path_cache_enumerate_new_file);
+    ADD_IMPORT_PATH_CACHE_TEST("no-override",
+                               test_import_path_cache_no_override);
+    ADD_IMPORT_PATH_CACHE_TEST("override-module",
+                               test_import_path_cache_override_module);
+    ADD_IMPORT_PATH_CACHE_TEST("override-directory",
+                               test_import_path_cache_override_directory);
+    ADD_IMPORT_PATH_CACHE_TEST("override-created",
+                               test_import_path_cache_override_created);
+
+#undef ADD_IMPORT_PATH_CACHE_TEST
+}
@@ -0,0 +1,267 @@
+// SPDX-License-Identifier: MIT OR LGPL-2.0-or-later
+// SPDX-FileCopyrightText: 2020 GNOME Foundation
+
+#include <config.h>
+
+#include <string.h>  // for strlen
+
+#include <string>
+#include <vector>
+
+#include <gio/gio.h>
+#include <glib.h>
+#include <glib/gstdio.h>  // for g_unlink, g_rmdir
+
+#include <js/RootingAPI.h>
+#include <js/TypeDecls.h>
+#include <jsapi.h>  // for JS_IsExceptionPending
+
+#include "gjs/context-private.h"
+#include "gjs/context.h"
+#include "gjs/error-types.h"
+#include "gjs/jsapi-util.h"
+#include "gjs/module-prefetch.h"
+#include "test/gjs-test-utils.h"
+
+static const char IMPORT_SCRIPT[] = "imports.big.answer;";
+
+struct PrefetchFixture {
+    char* dir;
+    char* module_path;
+    char* other_module_path;
+    GjsContext* gjs_context;
+    JSContext* cx;
+    JS::Realm* realm;
+};
+
+static void prefetch_fixture_setup(PrefetchFixture* fx, const void*) {
+    fx->dir = g_dir_make_tmp("gjs-test-XXXXXX", nullptr);
+    g_assert_nonnull(fx->dir);
+    fx->module_path = g_build_filename(fx->dir, "big.js", nullptr);
+    fx->other_module_path = g_build_filename(fx->dir, "other.js", nullptr);
+
+    char* search_path[] = {fx->dir, nullptr};
+    fx->gjs_context = gjs_context_new_with_search_path(search_path);
+    fx->cx = static_cast<JSContext*>(
+        gjs_context_get_native_context(fx->gjs_context));
+
+    JS::RootedObject global(fx->cx, gjs_get_import_global(fx->cx));
+    fx->realm = JS::EnterRealm(fx->cx, global);
+}
+
+static void prefetch_fixture_teardown(PrefetchFixture* fx, const void*) {
+    g_assert_false(JS_IsExceptionPending(fx->cx));
+    JS::LeaveRealm(fx->cx, fx->realm);
+    // Disposing the context cancels any compilation that is still running
+    g_object_unref(fx->gjs_context);
+
+    g_unlink(fx->module_path);
+    g_unlink(fx->other_module_path);
+    g_rmdir(fx->dir);
+    g_free(fx->module_path);
+    g_free(fx->other_module_path);
+    g_free(fx->dir);
+}
+
+static GjsModulePrefetcher& prefetcher(PrefetchFixture* fx) {
+    return GjsContextPrivate::from_cx(fx->cx)->module_prefetcher();
+}
+
+// The comment makes the module big enough to be compiled off the main thread
+// even with a single CPU, where SpiderMonkey's threshold is higher
+static void write_module_at(const char* path, const char* body) {
+    std::string source(body);
+    source += "\n// ";
+    source.append(200'000, 'x');
+    source += '\n';
+
+    GError* error = nullptr;
+    g_assert_true(
+        g_file_set_contents(path, source.c_str(), source.size(), &error));
+    g_assert_no_error(error);
+}
+
+static void write_module(PrefetchFixture* fx, const char* body) {
+    write_module_at(fx->module_path, body);
+}
+
+static void prefetch(PrefetchFixture* fx) {
+    prefetcher(fx).prefetch_imports(fx->cx, IMPORT_SCRIPT,
+                                    strlen(IMPORT_SCRIPT));
+    g_assert_false(JS_IsExceptionPending(fx->cx));
+}
+
+// Takes the prefetched script for the current contents of the module at
+// @path, as the importer would
+[[nodiscard]] static bool take_at(PrefetchFixture* fx, const char* path,
+                                  JS::MutableHandleScript script) {
+    char* source;
+    gsize len;
+    GError* error = nullptr;
+    g_assert_true(g_file_get_contents(path, &source, &len, &error));
+    g_assert_no_error(error);
+    GjsAutoChar owned_source = source;
+
+    GjsAutoUnref<GFile> file = g_file_new_for_path(path);
+    GjsAutoChar filename = g_file_get_parse_name(file);
+    bool ok = prefetcher(fx).take(fx->cx, filename, source, len, script);
+    g_assert_false(JS_IsExceptionPending(fx->cx));
+    return ok;
+}
+
+[[nodiscard]] static bool take(PrefetchFixture* fx,
+                               JS::MutableHandleScript script) {
+    return take_at(fx, fx->module_path, script);
+}
+
+static void assert_import_evaluates_to(PrefetchFixture* fx, int expected) {
+    GError* error = nullptr;
+    int status;
+    bool ok = gjs_context_eval(fx->gjs_context, IMPORT_SCRIPT, -1, "<input>",
+                               &status, &error);
+    g_assert_no_error(error);
+    g_assert_true(ok);
+    g_assert_cmpint(status, ==, expected);
+}
+
+static void test_module_prefetch_scan_imports(void) {
+    static const char script[] =
+        "const {Gio, GLib} = imports.gi;\n"
+        "const Foo = imports.foo.bar;\n"
+        "const x = imports.x.y.z();\n"
+        "let a = myimports.notMe, b = foo.imports.notMeEither;\n"
+        "// imports.inComment\n"
+        "/* imports.inBlockComment\n"
+        "   imports.stillInBlockComment */ imports.afterComment;\n"
+        "log('imports.inString', \"imports.inDoubleQuotes\");\n"
+        "log('it\\'s imports.escapedQuote', imports.afterString);\n"
+        "log(`imports.inTemplate ${imports.inSubstitution}\n"
+        "     imports.nextLineOfTemplate`);\n"
+        "imports.$a_1.b\n"
+        "imports.";
+    std::vector<std::string> names;
+    GjsModulePrefetcher::scan_imports(script, strlen(script), &names);
+
+    std::vector<std::string> expected = {"gi",           "foo.bar",
+                                         "x.y.z",        "afterComment",
+                                         "afterString",  "$a_1.b"};
+    g_assert_cmpuint(names.size(), ==, expected.size());
+    for (size_t ix = 0; ix < expected.size(); ix++)
+        g_assert_cmpstr(names[ix].c_str(), ==, expected[ix].c_str());
+}
+
+static void test_module_prefetch_take(PrefetchFixture* fx, const void*) {
+    write_module(fx, "var answer = 42;");
+    prefetch(fx);
+
+    JS::RootedScript script(fx->cx);
+    g_assert_true(take(fx, &script));
+    g_assert_nonnull(script);
+    g_assert_cmpuint(prefetcher(fx).hits(), ==, 1);
+
+    // Only taken once
+    g_assert_false(take(fx, &script));
+    g_assert_cmpuint(prefetcher(fx).hits(), ==, 1);
+}
+
+static void test_module_prefetch_import(PrefetchFixture* fx, const void*) {
+    write_module(fx, "var answer = 42;");
+    // Prefetched and taken while evaluating the script
+    assert_import_evaluates_to(fx, 42);
+    g_assert_cmpuint(prefetcher(fx).hits(), ==, 1);
+
+    // Nothing is left to take
+    JS::RootedScript script(fx->cx);
+    g_assert_false(take(fx, &script));
+}
+
+static void test_module_prefetch_direct_imports_only(PrefetchFixture* fx,
+                                                    const void*) {
+    write_module(fx, "imports.other; var answer = 42;");
+    write_module_at(fx->other_module_path, "var answer = 43;");
+    prefetch(fx);
+
+    // The main script's imports are prefetched, but not what they import
+    JS::RootedScript script(fx->cx);
+    g_assert_false(take_at(fx, fx->other_module_path, &script));
+    g_assert_true(take(fx, &script));
+    g_assert_cmpuint(prefetcher(fx).hits(), ==, 1);
+}
+
+static void test_module_prefetch_source_changed(PrefetchFixture* fx,
+                                                const void*) {
+    write_module(fx, "var answer = 42;");
+    prefetch(fx);
+    write_module(fx, "var answer = 43;");
+
+    JS::RootedScript script(fx->cx);
+    g_assert_false(take(fx, &script));
+    g_assert_null(script);
+}
+
+static void test_module_prefetch_import_source_changed(PrefetchFixture* fx,
+                                                       const void*) {
+    write_module(fx, "var answer = 42;");
+    prefetch(fx);
+    write_module(fx, "var answer = 43;");
+
+    // The import compiles the module again from the new source
+    assert_import_evaluates_to(fx, 43);
+    g_assert_cmpuint(prefetcher(fx).hits(), ==, 0);
+}
+
+static void test_module_prefetch_syntax_error(PrefetchFixture* fx,
+                                              const void*) {
+    write_module(fx, "var answer = ;");
+    prefetch(fx);
+
+    // The error is only reported when the importer compiles it again
+    JS::RootedScript script(fx->cx);
+    g_assert_false(take(fx, &script));
+    g_assert_null(script);
+
+    GError* error = nullptr;
+    int status;
+    g_test_expect_message(G_LOG_DOMAIN, G_LOG_LEVEL_CRITICAL,
+                          "JS ERROR: SyntaxError*");
+    g_assert_false(gjs_context_eval(fx->gjs_context, IMPORT_SCRIPT, -1,
+                                    "<input>", &status, &error));
+    g_test_assert_expected_messages();
+    g_assert_error(error, GJS_ERROR, GJS_ERROR_FAILED);
+    g_clear_error(&error);
+}
+
+static void test_module_prefetch_cancel_all(PrefetchFixture* fx,
+                                            const void*) {
+    write_module(fx, "var answer = 42;");
+    prefetch(fx);
+    prefetcher(fx).cancel_all(fx->cx);
+
+    JS::RootedScript script(fx->cx);
+    g_assert_false(take(fx, &script));
+
+    // Prefetched again, and still compiling when the context is disposed
+    prefetch(fx);
+}
+
+void gjs_test_add_tests_for_module_prefetch() {
+    g_test_add_func("/gjs/module-prefetch/scan-imports",
+                    test_module_prefetch_scan_imports);
+
+#define ADD_MODULE_PREFETCH_TEST(path, func)                                \
+    g_test_add("/gjs/module-prefetch/" path, PrefetchFixture, nullptr,      \
+               prefetch_fixture_setup, func, prefetch_fixture_teardown)
+
+    ADD_MODULE_PREFETCH_TEST("take", test_module_prefetch_take);
+    ADD_MODULE_PREFETCH_TEST("import", test_module_prefetch_import);
+    ADD_MODULE_PREFETCH_TEST("direct-imports-only",
+                             test_module_prefetch_direct_imports_only);
+    ADD_MODULE_PREFETCH_TEST("source-changed",
+                             test_module_prefetch_source_changed);
+    ADD_MODULE_PREFETCH_TEST("import-source-changed",
+                             test_module_prefetch_import_source_changed);
+    ADD_MODULE_PREFETCH_TEST("syntax-error", test_module_prefetch_syntax_error);
+    ADD_MODULE_PREFETCH_TEST("cancel-all", test_module_prefetch_cancel_all);
+
+#undef ADD_MODULE_PREFETCH_TEST
+}
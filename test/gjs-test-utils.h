@@ -32,4 +32,16 @@ void gjs_test_add_tests_for_rooting(void);
 
 void gjs_test_add_tests_for_jsapi_utils();
 
+void gjs_test_add_tests_for_call_state();
+
+void gjs_test_add_tests_for_bytecode_cache();
+
+void gjs_test_add_tests_for_gc_frame_clock();
+
+void gjs_test_add_tests_for_gc_policy();
+
+void gjs_test_add_tests_for_import_path_cache();
+
+void gjs_test_add_tests_for_module_prefetch();
+
 #endif  // TEST_GJS_TEST_UTILS_H_
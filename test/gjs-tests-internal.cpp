@@ -0,0 +1,30 @@
+// SPDX-License-Identifier: MIT OR LGPL-2.0-or-later
+// SPDX-FileCopyrightText: 2020 GNOME Foundation
+
+#include <config.h>
+
+#include <glib.h>
+
+#include "test/gjs-test-utils.h"
+
+// Tests of classes that libgjs doesn't export; linked statically to its
+// internals, so they can't load the GjsPrivate typelib
+int main(int argc, char** argv) {
+    /* Avoid interference in the tests from stray environment variable */
+    g_unsetenv("GJS_ENABLE_PROFILER");
+    g_unsetenv("GJS_TRACE_FD");
+    g_unsetenv("GJS_DISABLE_BYTECODE_CACHE");
+    g_unsetenv("GJS_DISABLE_IMPORT_CACHE");
+
+    g_test_init(&argc, &argv, nullptr);
+
+    gjs_test_add_tests_for_bytecode_cache();
+    gjs_test_add_tests_for_gc_frame_clock();
+    gjs_test_add_tests_for_gc_policy();
+    gjs_test_add_tests_for_import_path_cache();
+    gjs_test_add_tests_for_module_prefetch();
+
+    g_test_run();
+
+    return 0;
+}
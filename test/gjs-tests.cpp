@@ -5,7 +5,8 @@
 #include <config.h>
 
 #include <stdint.h>
-#include <string.h>  // for size_t, strlen
+#include <string.h>  // for size_t, strlen, memcmp
+#include <utime.h>   // for utimbuf
 
 #include <limits>
 #include <random>
@@ -15,7 +16,7 @@
 #include <girepository.h>
 #include <glib-object.h>
 #include <glib.h>
-#include <glib/gstdio.h>  // for g_unlink
+#include <glib/gstdio.h>  // for g_unlink, g_rmdir, g_stat, g_utime, GStatBuf
 
 #include <js/Array.h>
 #include <js/CharacterEncoding.h>
@@ -25,9 +26,11 @@
 #include <js/Value.h>
 #include <js/ValueArray.h>
 #include <jsapi.h>
+#include <jsfriendapi.h>  // for JS_IsFloat64Array, JS_GetTypedArrayLength
 #include <jspubtd.h>  // for JSProto_Number
 
 #include "gi/arg-inl.h"
+#include "gi/arg.h"
 #include "gjs/context.h"
 #include "gjs/error-types.h"
 #include "gjs/jsapi-util.h"
@@ -150,6 +153,152 @@ gjstest_test_func_gjs_context_exit(void)
     g_object_unref(context);
 }
 
+static void eval_file_and_assert_status(const char* filename, int expected) {
+    GjsAutoUnref<GjsContext> context = gjs_context_new();
+    GError* error = nullptr;
+    int status;
+    bool ok = gjs_context_eval_file(context, filename, &status, &error);
+    g_assert_no_error(error);
+    g_assert_true(ok);
+    g_assert_cmpint(status, ==, expected);
+}
+
+// Returns the path of the only entry in the bytecode cache at @cache_dir
+[[nodiscard]] static char* get_only_bytecode_cache_entry(
+    const char* cache_dir) {
+    GjsAutoChar bytecode_dir =
+        g_build_filename(cache_dir, "gjs", "bytecode", nullptr);
+    GError* error = nullptr;
+    GDir* dir = g_dir_open(bytecode_dir, 0, &error);
+    g_assert_no_error(error);
+
+    const char* name = g_dir_read_name(dir);
+    g_assert_nonnull(name);
+    g_assert_true(g_str_has_suffix(name, ".jsc"));
+    char* retval = g_build_filename(bytecode_dir, name, nullptr);
+    g_assert_null(g_dir_read_name(dir));
+    g_dir_close(dir);
+    return retval;
+}
+
+[[nodiscard]] static char* read_file(const char* filename, size_t* len) {
+    char* contents;
+    GError* error = nullptr;
+    g_assert_true(g_file_get_contents(filename, &contents, len, &error));
+    g_assert_no_error(error);
+    return contents;
+}
+
+// A script is compiled from the cache the second time it is run, but its
+// cache entry must not be used once its contents change, even if its size and
+// modification time stay the same.
+//
+// Code coverage disables the cache for the rest of the process, and the cache
+// directory is only looked up once per process, so this runs in a subprocess
+// with its own $XDG_CACHE_HOME.
+static void gjstest_test_func_gjs_context_eval_file_bytecode_cache(void) {
+    if (!g_test_subprocess()) {
+        g_test_trap_subprocess(nullptr, 0, G_TEST_SUBPROCESS_INHERIT_STDERR);
+        g_test_trap_assert_passed();
+        return;
+    }
+
+    GjsAutoChar dir = g_dir_make_tmp("gjs-test-XXXXXX", nullptr);
+    g_assert_nonnull(dir);
+    GjsAutoChar cache_dir = g_build_filename(dir, "cache", nullptr);
+    g_setenv("XDG_CACHE_HOME", cache_dir, true);
+    g_unsetenv("GJS_DISABLE_BYTECODE_CACHE");
+    GjsAutoChar filename = g_build_filename(dir, "script.js", nullptr);
+    GError* error = nullptr;
+
+    g_assert_true(g_file_set_contents(filename, "6 * 7;", -1, &error));
+    g_assert_no_error(error);
+    GStatBuf st;
+    g_assert_cmpint(g_stat(filename, &st), ==, 0);
+
+    // The first run writes an entry
+    eval_file_and_assert_status(filename, 42);
+    GjsAutoChar entry = get_only_bytecode_cache_entry(cache_dir);
+    size_t len;
+    GjsAutoChar contents = read_file(entry, &len);
+
+    // The second run uses it, and marks it as recently used
+    GStatBuf entry_st;
+    g_assert_cmpint(g_stat(entry, &entry_st), ==, 0);
+    struct utimbuf long_ago = {entry_st.st_atime - 3600,
+                               entry_st.st_mtime - 3600};
+    g_assert_cmpint(g_utime(entry, &long_ago), ==, 0);
+
+    eval_file_and_assert_status(filename, 42);
+    GStatBuf used_st;
+    g_assert_cmpint(g_stat(entry, &used_st), ==, 0);
+    g_assert_cmpint(used_st.st_mtime, >, long_ago.modtime);
+    // It wasn't written again, which would have replaced the file
+    g_assert_cmpuint(used_st.st_ino, ==, entry_st.st_ino);
+
+    // Changing the source rewrites the entry
+    g_assert_true(g_file_set_contents(filename, "6 * 8;", -1, &error));
+    g_assert_no_error(error);
+    struct utimbuf times = {st.st_atime, st.st_mtime};
+    g_assert_cmpint(g_utime(filename, &times), ==, 0);
+
+    eval_file_and_assert_status(filename, 48);
+    GjsAutoChar new_entry = get_only_bytecode_cache_entry(cache_dir);
+    g_assert_cmpstr(new_entry, ==, entry);
+    size_t new_len;
+    GjsAutoChar new_contents = read_file(new_entry, &new_len);
+    g_assert_false(len == new_len && memcmp(contents, new_contents, len) == 0);
+
+    g_unlink(entry);
+    GjsAutoChar bytecode_dir = g_path_get_dirname(entry);
+    GjsAutoChar gjs_cache_dir = g_path_get_dirname(bytecode_dir);
+    g_rmdir(bytecode_dir);
+    g_rmdir(gjs_cache_dir);
+    g_rmdir(cache_dir);
+    g_unlink(filename);
+    g_rmdir(dir);
+}
+
+static void gjstest_test_func_gjs_context_import_path_cache(void) {
+    GjsAutoChar dir = g_dir_make_tmp("gjs-test-XXXXXX", nullptr);
+    g_assert_nonnull(dir);
+    GjsAutoChar filename = g_build_filename(dir, "later.js", nullptr);
+    char* search_path[] = {dir.get(), nullptr};
+    GjsAutoUnref<GjsContext> context =
+        gjs_context_new_with_search_path(search_path);
+    static const char script[] =
+        "(() => { try { return imports.later.answer; } catch { return 0; } "
+        "})();";
+    GError* error = nullptr;
+    int status;
+
+    bool ok = gjs_context_eval(context, script, -1, "<input>", &status, &error);
+    g_assert_no_error(error);
+    g_assert_true(ok);
+    g_assert_cmpint(status, ==, 0);
+
+    // The module is found once the directory's monitor has seen it appear
+    g_assert_true(
+        g_file_set_contents(filename, "var answer = 42;", -1, &error));
+    g_assert_no_error(error);
+    int64_t deadline = g_get_monotonic_time() + 10 * G_USEC_PER_SEC;
+    do {
+        while (g_main_context_iteration(nullptr, false)) {
+        }
+        ok = gjs_context_eval(context, script, -1, "<input>", &status, &error);
+        g_assert_no_error(error);
+        g_assert_true(ok);
+        if (status == 42)
+            break;
+        g_usleep(G_USEC_PER_SEC / 100);
+    } while (g_get_monotonic_time() < deadline);
+    g_assert_cmpint(status, ==, 42);
+
+    context = nullptr;
+    g_unlink(filename);
+    g_rmdir(dir);
+}
+
 #define JS_CLASS "\
 const GObject = imports.gi.GObject; \
 const FooBar = GObject.registerClass(class FooBar extends GObject.Object {}); \
@@ -203,6 +352,64 @@ static void gjstest_test_func_gjs_gobject_without_introspection(void) {
 #undef TESTJS
 }
 
+// Connects and disconnects many signal handlers on one object; the time per
+// handler must not grow with the number of handlers already connected. Run
+// with -m perf to get meaningful numbers.
+static void gjstest_test_func_gjs_gobject_signal_churn(void) {
+    GjsAutoUnref<GjsContext> context = gjs_context_new();
+    GError* error = nullptr;
+    int status;
+    unsigned n_handlers = g_test_perf() ? 50000 : 500;
+
+    GjsAutoChar setup = g_strdup_printf(
+        "const {GObject} = imports.gi;"
+        "var N = %u;"
+        "var obj = new GObject.Object();"
+        "var ids;",
+        n_handlers);
+    bool ok = gjs_context_eval(context, setup, -1, "<input>", &status, &error);
+    g_assert_no_error(error);
+    g_assert_true(ok);
+
+    static const char* CONNECT =
+        "ids = [];"
+        "for (let i = 0; i < N; i++)"
+        "    ids.push(obj.connect('notify', () => {}));";
+    static const struct {
+        const char* description;
+        const char* prepare;  // not timed
+        const char* script;
+    } phases[] = {
+        {"connect", nullptr, CONNECT},
+        {"disconnect, oldest first", nullptr,
+         "ids.forEach(id => obj.disconnect(id));"},
+        {"disconnect, newest first", CONNECT,
+         "ids.reverse().forEach(id => obj.disconnect(id));"},
+        {"dispose with", CONNECT, "obj.run_dispose();"},
+    };
+
+    for (const auto& phase : phases) {
+        if (phase.prepare) {
+            ok = gjs_context_eval(context, phase.prepare, -1, "<input>",
+                                  &status, &error);
+            g_assert_no_error(error);
+            g_assert_true(ok);
+        }
+
+        g_test_timer_start();
+        ok = gjs_context_eval(context, phase.script, -1, "<input>", &status,
+                              &error);
+        double elapsed = g_test_timer_elapsed();
+        g_assert_no_error(error);
+        g_assert_true(ok);
+
+        g_test_minimized_result(elapsed * 1e6 / n_handlers,
+                                "%s %u signal handlers: %.3f us per handler",
+                                phase.description, n_handlers,
+                                elapsed * 1e6 / n_handlers);
+    }
+}
+
 static void gjstest_test_func_gjs_jsapi_util_string_js_string_utf8(
     GjsUnitTestFixture* fx, const void*) {
     JS::RootedValue js_string(fx->cx);
@@ -267,6 +474,60 @@ static void test_jsapi_util_string_utf8_nchars_to_js(GjsUnitTestFixture* fx,
     g_assert_true(v_out.isString());
 }
 
+static void test_jsapi_util_string_latin1_round_trip(GjsUnitTestFixture* fx,
+                                                     const void*) {
+    // Long enough to cover the vectorized ASCII scan, with a non-ASCII
+    // Latin-1 character after the first chunk
+    const char* latin1_utf8 = "the quick brown fox jumps over the lazy d\303\266g";
+    JS::RootedValue v_out(fx->cx);
+    g_assert_true(gjs_string_from_utf8(fx->cx, latin1_utf8, &v_out));
+    g_assert_true(v_out.isString());
+    g_assert_true(JS_StringHasLatin1Chars(v_out.toString()));
+    g_assert_cmpuint(JS_GetStringLength(v_out.toString()), ==,
+                     g_utf8_strlen(latin1_utf8, -1));
+
+    JS::UniqueChars utf8_result = gjs_string_to_utf8(fx->cx, v_out);
+    g_assert_nonnull(utf8_result);
+    g_assert_cmpstr(latin1_utf8, ==, utf8_result.get());
+}
+
+static void test_jsapi_util_string_invalid_utf8_to_js(GjsUnitTestFixture* fx,
+                                                      const void*) {
+    // Truncated two-byte sequence that would otherwise fit in Latin-1
+    JS::RootedValue v_out(fx->cx);
+    g_assert_false(gjs_string_from_utf8_n(fx->cx, "abc\303", 4, &v_out));
+    g_assert_true(JS_IsExceptionPending(fx->cx));
+    JS_ClearPendingException(fx->cx);
+}
+
+static void test_jsapi_util_string_from_static_utf8(GjsUnitTestFixture* fx,
+                                                    const void*) {
+    const char* type_name = g_type_name(G_TYPE_OBJECT);
+    JS::RootedValue first(fx->cx), second(fx->cx);
+    g_assert_true(gjs_string_from_static_utf8(fx->cx, type_name, &first));
+    g_assert_true(gjs_string_from_static_utf8(fx->cx, type_name, &second));
+    g_assert_true(first.isString());
+    g_assert_true(first.toString() == second.toString());
+    g_assert_true(JS_StringHasBeenPinned(fx->cx, first.toString()));
+
+    JS::UniqueChars utf8_result = gjs_string_to_utf8(fx->cx, first);
+    g_assert_nonnull(utf8_result);
+    g_assert_cmpstr(utf8_result.get(), ==, "GObject");
+}
+
+static void test_jsapi_util_string_ascii_prefix_length() {
+    const char* ascii = "0123456789abcdefghijklmnopqrstuvwxyz";
+    size_t len = strlen(ascii);
+    g_assert_cmpuint(gjs_ascii_prefix_length(ascii, len), ==, len);
+    g_assert_cmpuint(gjs_ascii_prefix_length(ascii, 0), ==, 0);
+
+    for (size_t ix = 0; ix < len; ix++) {
+        std::string str(ascii);
+        str[ix] = '\377';
+        g_assert_cmpuint(gjs_ascii_prefix_length(str.c_str(), len), ==, ix);
+    }
+}
+
 static void test_jsapi_util_string_char16_data(GjsUnitTestFixture* fx,
                                                const void*) {
     char16_t *chars;
@@ -442,6 +703,46 @@ static void gjstest_test_safe_integer_min(GjsUnitTestFixture* fx, const void*) {
     g_assert_cmpint(safe_value.toNumber(), ==, min_safe_big_number<int64_t>());
 }
 
+static void gjstest_test_args_typed_array_from_carray(GjsUnitTestFixture* fx,
+                                                     const void*) {
+    double doubles[] = {0.5, 1.5, 2.5};
+    JS::RootedValue value(fx->cx);
+    g_assert_true(gjs_typed_array_from_carray(fx->cx, &value,
+                                              GI_TYPE_TAG_DOUBLE, 3, doubles,
+                                              /* take_ownership = */ false));
+    // The original array must have been copied
+    doubles[1] = 42.0;
+
+    g_assert_true(value.isObject());
+    JS::RootedObject array(fx->cx, &value.toObject());
+    g_assert_true(JS_IsFloat64Array(array));
+    g_assert_cmpuint(JS_GetTypedArrayLength(array), ==, 3);
+    JS::RootedValue elem(fx->cx);
+    g_assert_true(JS_GetElement(fx->cx, array, 1, &elem));
+    g_assert_cmpfloat(elem.toNumber(), ==, 1.5);
+
+    auto* ints = g_new(int32_t, 2);
+    ints[0] = -1;
+    ints[1] = 7;
+    g_assert_true(gjs_typed_array_from_carray(fx->cx, &value, GI_TYPE_TAG_INT32,
+                                              2, ints,
+                                              /* take_ownership = */ true));
+    array = &value.toObject();
+    g_assert_true(JS_IsInt32Array(array));
+    g_assert_cmpuint(JS_GetTypedArrayLength(array), ==, 2);
+    g_assert_true(JS_GetElement(fx->cx, array, 0, &elem));
+    g_assert_cmpint(elem.toInt32(), ==, -1);
+
+    g_assert_true(gjs_typed_array_from_carray(fx->cx, &value, GI_TYPE_TAG_FLOAT,
+                                              10, nullptr, false));
+    array = &value.toObject();
+    g_assert_true(JS_IsFloat32Array(array));
+    g_assert_cmpuint(JS_GetTypedArrayLength(array), ==, 0);
+
+    g_assert_false(gjs_typed_array_supports_element_type(GI_TYPE_TAG_INT64));
+    g_assert_false(gjs_typed_array_supports_element_type(GI_TYPE_TAG_UTF8));
+}
+
 static void gjstest_test_args_set_get_unset() {
     GIArgument arg = {0};
 
@@ -619,15 +920,23 @@ main(int    argc,
     g_test_add_func("/gjs/context/eval/non-zero-terminated",
                     gjstest_test_func_gjs_context_eval_non_zero_terminated);
     g_test_add_func("/gjs/context/exit", gjstest_test_func_gjs_context_exit);
+    g_test_add_func("/gjs/context/eval-file/bytecode-cache",
+                    gjstest_test_func_gjs_context_eval_file_bytecode_cache);
+    g_test_add_func("/gjs/context/import-path-cache",
+                    gjstest_test_func_gjs_context_import_path_cache);
     g_test_add_func("/gjs/gobject/js_defined_type", gjstest_test_func_gjs_gobject_js_defined_type);
     g_test_add_func("/gjs/gobject/without_introspection",
                     gjstest_test_func_gjs_gobject_without_introspection);
+    g_test_add_func("/gjs/gobject/signal_churn",
+                    gjstest_test_func_gjs_gobject_signal_churn);
     g_test_add_func("/gjs/profiler/start_stop", gjstest_test_profiler_start_stop);
     g_test_add_func("/util/misc/strv/concat/null",
                     gjstest_test_func_util_misc_strv_concat_null);
     g_test_add_func("/util/misc/strv/concat/pointers",
                     gjstest_test_func_util_misc_strv_concat_pointers);
 
+    g_test_add_func("/gjs/jsapi/util/string/ascii-prefix-length",
+                    test_jsapi_util_string_ascii_prefix_length);
     g_test_add_func("/gi/args/set-get-unset", gjstest_test_args_set_get_unset);
     g_test_add_func("/gi/args/rounded_values",
                     gjstest_test_args_rounded_values);
@@ -643,6 +952,12 @@ main(int    argc,
                         gjstest_test_func_gjs_jsapi_util_string_js_string_utf8);
     ADD_JSAPI_UTIL_TEST("string/utf8-nchars-to-js",
                         test_jsapi_util_string_utf8_nchars_to_js);
+    ADD_JSAPI_UTIL_TEST("string/latin1-round-trip",
+                        test_jsapi_util_string_latin1_round_trip);
+    ADD_JSAPI_UTIL_TEST("string/invalid-utf8-to-js",
+                        test_jsapi_util_string_invalid_utf8_to_js);
+    ADD_JSAPI_UTIL_TEST("string/from-static-utf8",
+                        test_jsapi_util_string_from_static_utf8);
     ADD_JSAPI_UTIL_TEST("string/char16_data",
                         test_jsapi_util_string_char16_data);
     ADD_JSAPI_UTIL_TEST("string/to_ucs4",
@@ -658,6 +973,8 @@ main(int    argc,
                         gjstest_test_safe_integer_max);
     ADD_JSAPI_UTIL_TEST("gi/args/safe-integer/min",
                         gjstest_test_safe_integer_min);
+    ADD_JSAPI_UTIL_TEST("gi/args/typed-array-from-carray",
+                        gjstest_test_args_typed_array_from_carray);
 
 #undef ADD_JSAPI_UTIL_TEST
 
@@ -665,6 +982,7 @@ main(int    argc,
     gjs_test_add_tests_for_parse_call_args();
     gjs_test_add_tests_for_rooting();
     gjs_test_add_tests_for_jsapi_utils();
+    gjs_test_add_tests_for_call_state();
 
     g_test_run();
 
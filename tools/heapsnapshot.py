@@ -0,0 +1,327 @@
+#!/usr/bin/env python3
+
+# SPDX-License-Identifier: MIT OR LGPL-2.0-or-later
+# SPDX-FileCopyrightText: 2020 GNOME Foundation
+#
+# heapsnapshot.py - Retained size analysis of binary GJS heap snapshots
+#
+# Reads the files written by System.dumpHeapSnapshot(), or by SIGUSR1 with
+# GJS_DEBUG_HEAP_FORMAT=binary. The format is described in gjs/heap-snapshot.h.
+
+import argparse
+from collections import defaultdict
+import sys
+
+MAGIC = b'GJSHEAP\0'
+VERSION = 1
+
+########################################################
+# Command line arguments.
+########################################################
+
+parser = argparse.ArgumentParser(description='Show which types of objects retain the most memory in a GJS heap snapshot, or how that changed between two snapshots.')
+
+parser.add_argument('snapshot', metavar='FILE',
+                    help='Heap snapshot from System.dumpHeapSnapshot()')
+
+parser.add_argument('--diff', '-d', dest='baseline', metavar='BASELINE',
+                    help='Compare against an earlier snapshot')
+
+parser.add_argument('--by-type', '-t', dest='by_type', action='store_true',
+                    default=False,
+                    help='Group by JS type instead of by GType (includes objects that are not GObject or boxed wrappers)')
+
+parser.add_argument('--top', '-n', dest='top', type=int, default=30,
+                    help='Number of rows to show (default: 30)')
+
+
+########################################################
+# Snapshot parsing.
+########################################################
+
+class SnapshotError(Exception):
+    pass
+
+
+class Reader:
+    def __init__(self, data):
+        self.data = data
+        self.pos = 0
+
+    def at_end(self):
+        return self.pos >= len(self.data)
+
+    def byte(self):
+        if self.pos >= len(self.data):
+            raise SnapshotError('unexpected end of file')
+        value = self.data[self.pos]
+        self.pos += 1
+        return value
+
+    def varint(self):
+        result = 0
+        shift = 0
+        while True:
+            byte = self.byte()
+            result |= (byte & 0x7f) << shift
+            if byte < 0x80:
+                return result
+            shift += 7
+
+    def bytes(self, length):
+        if self.pos + length > len(self.data):
+            raise SnapshotError('unexpected end of file')
+        value = self.data[self.pos:self.pos + length]
+        self.pos += length
+        return value
+
+
+class Snapshot:
+    '''The heap graph, with nodes numbered densely from 1; node 0 is a virtual
+    root pointing to the root of every snapshot in the file.'''
+
+    def __init__(self):
+        self.index = {}  # address -> node number
+        self.types = [None]
+        self.gtypes = [None]
+        self.sizes = [0]
+        self.edges = [[]]  # lists of node addresses, resolved in finish()
+
+    def node(self, address):
+        num = self.index.get(address)
+        if num is None:
+            num = len(self.types)
+            self.index[address] = num
+            self.types.append(None)
+            self.gtypes.append(None)
+            self.sizes.append(0)
+            self.edges.append([])
+        return num
+
+    def finish(self):
+        # Edges are stored as addresses while parsing, since a referent is
+        # written after the node that first points to it
+        index = self.index
+        self.edges = [[index[a] for a in edges if a in index]
+                      for edges in self.edges]
+
+    def __len__(self):
+        return len(self.types)
+
+
+def parse_one(reader, snapshot):
+    if reader.bytes(len(MAGIC)) != MAGIC:
+        raise SnapshotError('not a GJS heap snapshot')
+    version = reader.varint()
+    if version != VERSION:
+        raise SnapshotError('unsupported snapshot version {}'.format(version))
+
+    strings = [None]
+    root = reader.varint()
+    snapshot.edges[0].append(root)
+
+    while True:
+        tag = reader.byte()
+        if tag == ord('S'):
+            length = reader.varint()
+            strings.append(reader.bytes(length).decode('utf-8', 'replace'))
+        elif tag == ord('N'):
+            num = snapshot.node(reader.varint())
+            snapshot.types[num] = strings[reader.varint()]
+            snapshot.gtypes[num] = strings[reader.varint()]
+            size = reader.varint()
+            native_size = reader.varint()
+            snapshot.sizes[num] = size + native_size
+            edges = snapshot.edges[num]
+            for _ in range(reader.varint()):
+                edges.append(reader.varint())
+                reader.varint()  # edge name, not used here
+        elif tag == ord('E'):
+            reader.varint()  # node count
+            reader.varint()  # edge count
+            return
+        else:
+            raise SnapshotError('unknown record {!r} at offset {}'.format(
+                chr(tag), reader.pos - 1))
+
+
+def parse(path):
+    with open(path, 'rb') as f:
+        reader = Reader(f.read())
+
+    snapshot = Snapshot()
+    while not reader.at_end():
+        parse_one(reader, snapshot)
+    snapshot.finish()
+    return snapshot
+
+
+########################################################
+# Dominator tree and retained sizes.
+########################################################
+
+def postorder(snapshot):
+    '''Iterative depth-first search from the virtual root.'''
+    edges = snapshot.edges
+    visited = bytearray(len(snapshot))
+    order = []
+    visited[0] = 1
+    stack = [(0, iter(edges[0]))]
+    while stack:
+        node, children = stack[-1]
+        for child in children:
+            if not visited[child]:
+                visited[child] = 1
+                stack.append((child, iter(edges[child])))
+                break
+        else:
+            stack.pop()
+            order.append(node)
+    return order
+
+
+def dominators(snapshot, order):
+    '''Immediate dominators, with the algorithm from Cooper, Harvey and
+    Kennedy, "A Simple, Fast Dominance Algorithm". Unreachable nodes get -1.'''
+    n = len(snapshot)
+    number = [-1] * n
+    for ix, node in enumerate(order):
+        number[node] = ix
+
+    preds = [[] for _ in range(n)]
+    for node in order:
+        for child in snapshot.edges[node]:
+            preds[child].append(node)
+
+    idom = [-1] * n
+    idom[0] = 0
+    reverse_postorder = order[-2::-1]  # without the root
+
+    def intersect(a, b):
+        while a != b:
+            while number[a] < number[b]:
+                a = idom[a]
+            while number[b] < number[a]:
+                b = idom[b]
+        return a
+
+    changed = True
+    while changed:
+        changed = False
+        for node in reverse_postorder:
+            new_idom = -1
+            for pred in preds[node]:
+                if idom[pred] == -1:
+                    continue
+                new_idom = pred if new_idom == -1 else intersect(pred, new_idom)
+            if idom[node] != new_idom:
+                idom[node] = new_idom
+                changed = True
+    return idom
+
+
+def retained_sizes(snapshot, order, idom):
+    # In postorder, everything a node dominates comes before it
+    retained = list(snapshot.sizes)
+    for node in order[:-1]:
+        retained[idom[node]] += retained[node]
+    return retained
+
+
+class Row:
+    __slots__ = ('count', 'size', 'retained')
+
+    def __init__(self):
+        self.count = 0
+        self.size = 0
+        self.retained = 0
+
+
+def summarize(snapshot, by_type):
+    order = postorder(snapshot)
+    idom = dominators(snapshot, order)
+    retained = retained_sizes(snapshot, order, idom)
+    keys = snapshot.types if by_type else snapshot.gtypes
+
+    rows = defaultdict(Row)
+    for node in order[:-1]:
+        key = keys[node]
+        if key is None:
+            continue
+        row = rows[key]
+        row.count += 1
+        row.size += snapshot.sizes[node]
+
+        # Memory retained by a node is already counted if the node is itself
+        # retained by another node of the same kind
+        ancestor = idom[node]
+        while ancestor != 0 and keys[ancestor] != key:
+            ancestor = idom[ancestor]
+        if ancestor == 0:
+            row.retained += retained[node]
+
+    return rows, retained[0]
+
+
+########################################################
+# Output.
+########################################################
+
+def format_size(size):
+    for unit in ('B', 'KiB', 'MiB'):
+        if abs(size) < 1024:
+            return '{:.0f} {}'.format(size, unit) if unit == 'B' else \
+                '{:.1f} {}'.format(size, unit)
+        size /= 1024
+    return '{:.1f} GiB'.format(size)
+
+
+def print_summary(rows, total, top, label):
+    print('Total reachable: {}\n'.format(format_size(total)))
+    print('{:>12} {:>12} {:>9}  {}'.format('Retained', 'Self', 'Count',
+                                           label))
+    ordered = sorted(rows.items(), key=lambda item: item[1].retained,
+                     reverse=True)
+    for key, row in ordered[:top]:
+        print('{:>12} {:>12} {:>9}  {}'.format(format_size(row.retained),
+                                               format_size(row.size),
+                                               row.count, key))
+
+
+def print_diff(old_rows, old_total, new_rows, new_total, top, label):
+    print('Total reachable: {} ({:+})\n'.format(format_size(new_total),
+                                                new_total - old_total))
+    print('{:>12} {:>12} {:>9}  {}'.format('Retained', 'Self', 'Count',
+                                           label))
+    deltas = []
+    for key in set(old_rows) | set(new_rows):
+        old = old_rows.get(key, Row())
+        new = new_rows.get(key, Row())
+        delta = (new.retained - old.retained, new.size - old.size,
+                 new.count - old.count)
+        if any(delta):
+            deltas.append((key, delta))
+    deltas.sort(key=lambda item: abs(item[1][0]), reverse=True)
+    for key, (retained, size, count) in deltas[:top]:
+        print('{:>+12} {:>+12} {:>+9}  {}'.format(retained, size, count, key))
+
+
+def main():
+    args = parser.parse_args()
+    label = 'Type' if args.by_type else 'GType'
+
+    try:
+        rows, total = summarize(parse(args.snapshot), args.by_type)
+        if args.baseline:
+            old_rows, old_total = summarize(parse(args.baseline),
+                                            args.by_type)
+            print_diff(old_rows, old_total, rows, total, args.top, label)
+        else:
+            print_summary(rows, total, args.top, label)
+    except (OSError, SnapshotError) as e:
+        sys.stderr.write('heapsnapshot.py: {}\n'.format(e))
+        sys.exit(1)
+
+
+if __name__ == '__main__':
+    main()